@@ -0,0 +1,363 @@
+/*-
+ * Copyright (c) 2026
+ *	The nvi2 contributors.  All rights reserved.
+ *
+ * See the LICENSE file for redistribution information.
+ */
+
+/*
+ * nvi-bench --
+ *	Headless benchmark driver.  Generates test files of various shapes,
+ *	runs every ex script in the script directory against each of them
+ *	with "nvi -e -s", and reports the wall clock times as JSON.
+ *
+ * usage: nvi-bench [-k] [-n reps] [-o file] [-s scale] nvi scriptdir workdir
+ */
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#include <dirent.h>
+#include <err.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+typedef struct {
+	char	*name;			/* File name. */
+	u_long	 lines;			/* Line count, before scaling. */
+	u_long	 width;			/* Average line width. */
+	int	 enc;			/* Character set. */
+#define	ENC_ASCII	0
+#define	ENC_UTF8	1
+#define	ENC_LATIN1	2
+} SHAPE;
+
+static SHAPE shapes[] = {
+	{"small.txt",	  10000,	   60,	ENC_ASCII},
+	{"large.txt",	 500000,	   60,	ENC_ASCII},
+	{"long.txt",	    200,	65536,	ENC_ASCII},
+	{"many.txt",	1000000,	    8,	ENC_ASCII},
+	{"utf8.txt",	 100000,	   60,	ENC_UTF8},
+	{"latin1.txt",	 100000,	   60,	ENC_LATIN1},
+	{NULL},
+};
+
+static char *words[] = {
+	"the", "quick", "brown", "fox", "jumps", "over", "lazy", "dog",
+	"a", "needle", "in", "haystack", "editor", "line", "buffer", "of",
+};
+static char *uwords[] = {
+	"\303\251t\303\251", "na\303\257ve", "\316\261\316\262\316\263",
+	"\320\274\320\270\321\200", "\346\274\242\345\255\227",
+	"\360\237\231\202",
+};
+static char *lwords[] = {
+	"\351t\351", "na\357ve", "gr\374\337e", "se\361or", "\346ble",
+};
+
+static u_long seed;
+
+static int	gen(SHAPE *, char *, u_long, size_t *);
+static void	jstr(FILE *, char *, size_t);
+static u_long	rnd(void);
+static double	run(char *, char *, char *, char *, char *, int *);
+static int	scmp(const void *, const void *);
+static int	scripts(char *, char ***, int *);
+static void	usage(void);
+
+int
+main(int argc, char *argv[])
+{
+	SHAPE *sp;
+	FILE *ofp;
+	size_t bytes;
+	u_long lines, scale;
+	double best, t;
+	int ch, first, i, keep, n, nscr, reps, status;
+	char *nvi, *ofile, *p, path[PATH_MAX], **scr, *sdir, *wdir;
+
+	keep = 0;
+	reps = 3;
+	scale = 1;
+	ofile = NULL;
+	while ((ch = getopt(argc, argv, "kn:o:s:")) != -1)
+		switch (ch) {
+		case 'k':
+			keep = 1;
+			break;
+		case 'n':
+			if ((reps = atoi(optarg)) < 1)
+				usage();
+			break;
+		case 'o':
+			ofile = optarg;
+			break;
+		case 's':
+			if ((scale = strtoul(optarg, &p, 10)) == 0 || *p)
+				usage();
+			break;
+		default:
+			usage();
+		}
+	argc -= optind;
+	argv += optind;
+	if (argc != 3)
+		usage();
+	nvi = argv[0];
+	sdir = argv[1];
+	wdir = argv[2];
+
+	if (mkdir(wdir, 0700) && errno != EEXIST)
+		err(1, "%s", wdir);
+	if (scripts(sdir, &scr, &nscr))
+		err(1, "%s", sdir);
+	if (ofile == NULL)
+		ofp = stdout;
+	else if ((ofp = fopen(ofile, "w")) == NULL)
+		err(1, "%s", ofile);
+
+	(void)fprintf(ofp, "{\n  \"nvi\": ");
+	jstr(ofp, nvi, strlen(nvi));
+	(void)fprintf(ofp, ",\n  \"reps\": %d,\n"
+	    "  \"scale\": %lu,\n  \"results\": [", reps, scale);
+	for (first = 1, sp = shapes; sp->name != NULL; ++sp) {
+		(void)snprintf(path, sizeof(path), "%s/%s", wdir, sp->name);
+		lines = sp->lines / scale ? sp->lines / scale : 1;
+		if (gen(sp, path, lines, &bytes))
+			err(1, "%s", path);
+		for (i = 0; i < nscr; ++i) {
+			best = -1;
+			status = 0;
+			for (n = 0; n < reps; ++n) {
+				t = run(nvi,
+				    sdir, scr[i], wdir, sp->name, &status);
+				if (t < 0)
+					err(1, "%s", nvi);
+				if (best < 0 || t < best)
+					best = t;
+			}
+			(void)fprintf(ofp, "%s\n    {\"file\": ",
+			    first ? "" : ",");
+			jstr(ofp, sp->name, strlen(sp->name));
+			(void)fprintf(ofp, ", \"lines\": %lu, \"bytes\": %zu, "
+			    "\"script\": ", lines, bytes);
+			jstr(ofp, scr[i], strlen(scr[i]) - 3);
+			(void)fprintf(ofp, ", \"seconds\": %.6f, "
+			    "\"status\": %d}", best, status);
+			first = 0;
+			(void)fflush(ofp);
+		}
+		if (!keep)
+			(void)unlink(path);
+	}
+	(void)fprintf(ofp, "\n  ]\n}\n");
+	if (!keep) {
+		(void)snprintf(path, sizeof(path), "%s/bench.out", wdir);
+		(void)unlink(path);
+	}
+	if (ferror(ofp) || (ofp != stdout && fclose(ofp)))
+		err(1, "%s", ofile == NULL ? "stdout" : ofile);
+	return (0);
+}
+
+/*
+ * gen --
+ *	Write a file of the given shape, the contents depend only on it.
+ */
+static int
+gen(SHAPE *sp, char *path, u_long lines, size_t *bytesp)
+{
+	FILE *fp;
+	off_t bytes;
+	size_t len, width;
+	u_long lno;
+	char *w;
+
+	if ((fp = fopen(path, "w")) == NULL)
+		return (1);
+	seed = 1;
+	for (lno = 1; lno <= lines; ++lno) {
+		/* Some empty lines, and a needle every so often. */
+		if (lno % 50 == 2) {
+			(void)putc('\n', fp);
+			continue;
+		}
+		width = sp->width / 2 + rnd() % sp->width;
+		for (len = 0; len < width; len += strlen(w) + 1) {
+			if (len != 0)
+				(void)putc(' ', fp);
+			if (lno % 97 == 1 && len == 0)
+				w = "needle";
+			else if (sp->enc == ENC_UTF8 && rnd() % 3 == 0)
+				w = uwords[rnd() %
+				    (sizeof(uwords) / sizeof(uwords[0]))];
+			else if (sp->enc == ENC_LATIN1 && rnd() % 3 == 0)
+				w = lwords[rnd() %
+				    (sizeof(lwords) / sizeof(lwords[0]))];
+			else
+				w = words[rnd() %
+				    (sizeof(words) / sizeof(words[0]))];
+			(void)fputs(w, fp);
+		}
+		(void)putc('\n', fp);
+	}
+	if ((bytes = ftello(fp)) == -1) {
+		(void)fclose(fp);
+		return (1);
+	}
+	*bytesp = bytes;
+	return (ferror(fp) | fclose(fp));
+}
+
+/*
+ * jstr --
+ *	Write a string as a JSON string literal.
+ */
+static void
+jstr(FILE *fp, char *s, size_t len)
+{
+	u_char ch;
+
+	(void)putc('"', fp);
+	for (; len > 0; --len, ++s) {
+		ch = *s;
+		if (ch == '"' || ch == '\\') {
+			(void)putc('\\', fp);
+			(void)putc(ch, fp);
+		} else if (ch < 0x20 || ch == 0x7f)
+			(void)fprintf(fp, "\\u%04x", ch);
+		else
+			(void)putc(ch, fp);
+	}
+	(void)putc('"', fp);
+}
+
+/*
+ * rnd --
+ *	A small, portable, repeatable random number generator.
+ */
+static u_long
+rnd(void)
+{
+	seed = seed * 1103515245 + 12345;
+	return ((seed >> 16) & 0x7fff);
+}
+
+/*
+ * run --
+ *	Run one script against a file in the work directory, and return
+ *	the elapsed time in seconds, or -1 with errno set on error.
+ *
+ *	If the child can't set up or exec nvi, it writes errno down a
+ *	close-on-exec pipe, so it isn't mistaken for nvi's exit status.
+ */
+static double
+run(char *nvi, char *sdir, char *script, char *wdir, char *file, int *statusp)
+{
+	struct timespec t0, t1;
+	pid_t pid;
+	ssize_t nr;
+	int cerr, fd, pfd[2], status;
+	char path[PATH_MAX];
+
+	(void)snprintf(path, sizeof(path), "%s/%s", sdir, script);
+	if (pipe(pfd))
+		return (-1);
+	if (fcntl(pfd[1], F_SETFD, FD_CLOEXEC) == -1) {
+		cerr = errno;
+		(void)close(pfd[0]);
+		(void)close(pfd[1]);
+		errno = cerr;
+		return (-1);
+	}
+	(void)clock_gettime(CLOCK_MONOTONIC, &t0);
+	switch (pid = fork()) {
+	case -1:
+		cerr = errno;
+		(void)close(pfd[0]);
+		(void)close(pfd[1]);
+		errno = cerr;
+		return (-1);
+	case 0:
+		(void)close(pfd[0]);
+		if ((fd = open(path, O_RDONLY)) < 0)
+			goto cfail;
+		(void)dup2(fd, STDIN_FILENO);
+		(void)close(fd);
+		if ((fd = open("/dev/null", O_WRONLY)) < 0)
+			goto cfail;
+		(void)dup2(fd, STDOUT_FILENO);
+		(void)dup2(fd, STDERR_FILENO);
+		(void)close(fd);
+		if (chdir(wdir))
+			goto cfail;
+		execl(nvi, "nvi", "-e", "-s", file, (char *)NULL);
+cfail:		cerr = errno;
+		(void)write(pfd[1], &cerr, sizeof(cerr));
+		_exit(127);
+	}
+	(void)close(pfd[1]);
+	while ((nr = read(pfd[0], &cerr, sizeof(cerr))) == -1 &&
+	    errno == EINTR);
+	(void)close(pfd[0]);
+	if (waitpid(pid, &status, 0) != pid)
+		return (-1);
+	(void)clock_gettime(CLOCK_MONOTONIC, &t1);
+	if (nr == sizeof(cerr)) {
+		errno = cerr;
+		return (-1);
+	}
+	*statusp = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+	return ((t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9);
+}
+
+/*
+ * scripts --
+ *	Collect the names of the *.ex scripts, sorted.
+ */
+static int
+scripts(char *sdir, char ***scrp, int *nscrp)
+{
+	struct dirent *dp;
+	DIR *dirp;
+	size_t len;
+	int n;
+	char **scr;
+
+	if ((dirp = opendir(sdir)) == NULL)
+		return (1);
+	for (scr = NULL, n = 0; (dp = readdir(dirp)) != NULL;) {
+		if ((len = strlen(dp->d_name)) <= 3 ||
+		    strcmp(dp->d_name + len - 3, ".ex"))
+			continue;
+		if ((scr = realloc(scr, (n + 1) * sizeof(char *))) == NULL ||
+		    (scr[n++] = strdup(dp->d_name)) == NULL)
+			return (1);
+	}
+	(void)closedir(dirp);
+	qsort(scr, n, sizeof(char *), scmp);
+	*scrp = scr;
+	*nscrp = n;
+	return (0);
+}
+
+static int
+scmp(const void *a, const void *b)
+{
+	return (strcmp(*(char * const *)a, *(char * const *)b));
+}
+
+static void
+usage(void)
+{
+	(void)fprintf(stderr, "usage: nvi-bench [-k] [-n reps] [-o file] "
+	    "[-s scale] nvi scriptdir workdir\n");
+	exit(1);
+}
@@ -0,0 +1,3 @@
+g/needle/d
+g/^$/d
+q!
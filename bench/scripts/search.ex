@@ -0,0 +1,51 @@
+/needle/
+/needle/
+/needle/
+/needle/
+/needle/
+/needle/
+/needle/
+/needle/
+/needle/
+/needle/
+/needle/
+/needle/
+/needle/
+/needle/
+/needle/
+/needle/
+/needle/
+/needle/
+/needle/
+/needle/
+/needle/
+/needle/
+/needle/
+/needle/
+/needle/
+?needle?
+?needle?
+?needle?
+?needle?
+?needle?
+?needle?
+?needle?
+?needle?
+?needle?
+?needle?
+?needle?
+?needle?
+?needle?
+?needle?
+?needle?
+?needle?
+?needle?
+?needle?
+?needle?
+?needle?
+?needle?
+?needle?
+?needle?
+?needle?
+?needle?
+q!
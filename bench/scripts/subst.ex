@@ -0,0 +1,3 @@
+%s/the/THE/g
+%s/needle/haystack/
+q!
@@ -0,0 +1,5 @@
+%s/e/E/g
+u
+u
+u
+q!
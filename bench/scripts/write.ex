@@ -0,0 +1,2 @@
+w! bench.out
+q!
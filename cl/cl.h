@@ -15,6 +15,38 @@
 #include <curses.h>
 #endif
 
+/* A cell of the direct renderer's screen buffers. */
+typedef struct _cl_cell {
+	CHAR_T	 ch;		/* Character. */
+	u_char	 attr;		/* Standout. */
+#define	CL_UNKNOWN	0xff	/* Terminal contents unknown. */
+	u_char	 width;		/* Width, 0 if the second column. */
+} CL_CELL;
+
+/* The direct renderer, see cl_direct.c. */
+typedef struct _cl_direct {
+	CL_CELL	*front;		/* Cells on the terminal. */
+	CL_CELL	*back;		/* Cells of the row being drawn. */
+	char	*dirty;		/* Damaged rows. */
+	size_t	 rows, cols;	/* Buffer size. */
+	int	 cy, cx;	/* Terminal cursor, -1 if unknown. */
+
+#define	CL_NSCROLL	8
+	struct {		/* Scrolls to replay. */
+		size_t	 top, bot;
+		int	 n;
+	} scroll[CL_NSCROLL];
+	int	 nscroll;
+
+	char	*obuf;		/* Frame output. */
+	size_t	 olen, oblen;
+	int	 oerr;
+
+	char	*clear, *cr, *csr, *cud1, *cuf, *cup, *cuu1, *dch;
+	char	*el, *ich, *ind, *indn, *ri, *rin, *rmso, *smso;
+	int	 lastcell;	/* Can write the last screen cell. */
+} CL_DIRECT;
+
 typedef struct _cl_private {
 	char	 ibuf[256];	/* Input keys. */
 
@@ -39,6 +71,8 @@ typedef struct _cl_private {
 
 	SCR	*focus;		/* Screen that has the "focus". */
 
+	CL_DIRECT *dp;		/* Direct renderer, if drawing directly. */
+
 	int	 killersig;	/* Killer signal. */
 #define	INDX_HUP	0
 #define	INDX_INT	1
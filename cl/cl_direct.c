@@ -0,0 +1,690 @@
+/*-
+ * Copyright (c) 2026
+ *	The nvi2 contributors.  All rights reserved.
+ *
+ * See the LICENSE file for redistribution information.
+ */
+
+#include "config.h"
+
+#include <sys/types.h>
+#include <sys/queue.h>
+#include <sys/time.h>
+
+#include <bitstring.h>
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef HAVE_TERM_H
+#include <term.h>
+#endif
+#include <termios.h>
+#include <unistd.h>
+#include <wchar.h>
+
+#include "../common/common.h"
+#include "cl.h"
+
+/*
+ * The direct renderer.
+ *
+ * When the directdraw option is set, the curses windows are still used to
+ * compose the screen, but curses never writes to the terminal.  Instead,
+ * at each refresh the rows curses marked as touched are copied into a back
+ * buffer of cells and compared with a front buffer holding what's on the
+ * terminal, and only the changed spans are redrawn.  Lines inserted and
+ * deleted by the vi scrolling code are replayed with scroll regions.  The
+ * frame is wrapped in synchronized update sequences, so terminals that
+ * support them show it at once, and sent with a single write(2).
+ */
+
+/* Synchronized update mode, ignored by terminals that don't have it. */
+#define	SYNC_BEGIN	"\033[?2026h"
+#define	SYNC_END	"\033[?2026l"
+
+/* Unchanged cells cheaper to redraw than to move the cursor over. */
+#define	SPAN_GAP	4
+
+/* Cells that have to match to shift a row rather than redraw it. */
+#define	SHIFT_MIN	8
+
+#define	CELL_EQ(a, b)							\
+	((a)->ch == (b)->ch && (a)->attr == (b)->attr && (a)->width == (b)->width)
+
+static CL_DIRECT *outdp;		/* Frame being built, for tputs. */
+
+static int	cl_dalloc(CL_PRIVATE *);
+static void	cl_demit(CL_DIRECT *, CL_CELL *, size_t);
+static void	cl_dmove(CL_DIRECT *, size_t, size_t);
+static int	cl_dputc(int);
+static void	cl_dputs(CL_DIRECT *, char *, size_t);
+static void	cl_drow(CL_DIRECT *, size_t);
+static void	cl_dscrollup(CL_DIRECT *, size_t, size_t, int);
+static int	cl_dshift(CL_DIRECT *, size_t, size_t);
+
+/*
+ * cl_dflush --
+ *	Bring the terminal up to date with the curses windows, leaving the
+ *	cursor where it is in the window win.
+ *
+ * PUBLIC: int cl_dflush(GS *, WINDOW *, int);
+ */
+int
+cl_dflush(GS *gp, WINDOW *win, int repaint)
+{
+	CL_PRIVATE *clp;
+	CL_DIRECT *dp;
+	SCR *tsp;
+	WINDOW *twin;
+	ssize_t nw;
+	size_t bot, cnt, len, lno, off, olen, top, y, x;
+	int i, n, rows;
+
+	clp = GCLP(gp);
+	if ((dp = clp->dp) == NULL ||
+	    dp->rows != (size_t)LINES || dp->cols != (size_t)COLS) {
+		if (cl_dalloc(clp))
+			return (1);
+		dp = clp->dp;
+		repaint = 1;
+	}
+	outdp = dp;
+	dp->olen = 0;
+	dp->oerr = 0;
+	cl_dputs(dp, SYNC_BEGIN, sizeof(SYNC_BEGIN) - 1);
+	rows = 0;
+
+	/*
+	 * Start over from a cleared terminal, or replay any scrolling on the
+	 * terminal and in the front buffer.
+	 */
+	if (repaint) {
+		if (dp->clear != NULL)
+			(void)tputs(dp->clear, LINES, cl_dputc);
+		for (cnt = 0; cnt < dp->rows * dp->cols; ++cnt) {
+			dp->front[cnt].ch = ' ';
+			dp->front[cnt].attr =
+			    dp->clear == NULL ? CL_UNKNOWN : 0;
+			dp->front[cnt].width = 1;
+		}
+		memset(dp->dirty, 1, dp->rows);
+		dp->cy = dp->cx = -1;
+		rows = 2;
+	} else if (dp->nscroll != 0 && dp->csr != NULL) {
+		for (i = 0; i < dp->nscroll; ++i) {
+			n = dp->scroll[i].n;
+			top = dp->scroll[i].top;
+			bot = dp->scroll[i].bot;
+			cl_dscrollup(dp, top, bot, n);
+			(void)tputs(tgoto(dp->csr, bot, top), 1, cl_dputc);
+
+			/* Some terminals home the cursor on a region change. */
+			dp->cy = dp->cx = -1;
+			if (n > 0) {
+				cl_dmove(dp, bot, 0);
+				if (n > 1 && dp->indn != NULL)
+					(void)tputs(tgoto(dp->indn,
+					    0, n), 1, cl_dputc);
+				else
+					for (; n > 0; --n)
+						(void)tputs(dp->ind,
+						    1, cl_dputc);
+			} else {
+				cl_dmove(dp, top, 0);
+				if (n < -1 && dp->rin != NULL)
+					(void)tputs(tgoto(dp->rin,
+					    0, -n), 1, cl_dputc);
+				else
+					for (; n < 0; ++n)
+						(void)tputs(dp->ri,
+						    1, cl_dputc);
+			}
+		}
+		(void)tputs(tgoto(dp->csr, dp->rows - 1, 0), 1, cl_dputc);
+		dp->cy = dp->cx = -1;
+		rows = 2;
+	}
+	dp->nscroll = 0;
+
+	/* Collect the rows changed in any of the windows. */
+	for (tsp = NULL, twin = stdscr;;) {
+		off = getbegy(twin);
+		for (lno = 0, len = getmaxy(twin); lno < len; ++lno)
+			if (off + lno < dp->rows && is_linetouched(twin, lno))
+				dp->dirty[off + lno] = 1;
+		(void)untouchwin(twin);
+
+		tsp = tsp == NULL ?
+		    TAILQ_FIRST(gp->dq) : TAILQ_NEXT(tsp, q);
+		for (; tsp != NULL; tsp = TAILQ_NEXT(tsp, q))
+			if (CLSP(tsp) != NULL)
+				break;
+		if (tsp == NULL)
+			break;
+		twin = CLSP(tsp);
+	}
+
+	/*
+	 * Redraw the changed spans of the damaged rows.  Reading the cells
+	 * moves the stdscr cursor, put it back.
+	 */
+	getyx(stdscr, y, x);
+	for (lno = 0; lno < dp->rows; ++lno)
+		if (dp->dirty[lno]) {
+			olen = dp->olen;
+			cl_drow(dp, lno);
+			if (dp->olen != olen)
+				++rows;
+			dp->dirty[lno] = 0;
+		}
+	(void)wmove(stdscr, y, x);
+
+	/* Place the cursor. */
+	getbegyx(win, y, x);
+	cl_dmove(dp, y + getcury(win), x + getcurx(win));
+
+	/*
+	 * A change to a single row can't be seen half done, only use a
+	 * synchronized update for more.
+	 */
+	if (rows > 1) {
+		cl_dputs(dp, SYNC_END, sizeof(SYNC_END) - 1);
+		off = 0;
+	} else
+		off = sizeof(SYNC_BEGIN) - 1;
+	if (dp->oerr)
+		return (1);
+	if (off == dp->olen)
+		return (0);
+
+	/* Anything written through stdio has to go first. */
+	(void)fflush(stdout);
+	for (; off < dp->olen; off += nw)
+		if ((nw = write(STDOUT_FILENO,
+		    dp->obuf + off, dp->olen - off)) < 0) {
+			if (errno == EINTR) {
+				nw = 0;
+				continue;
+			}
+			return (1);
+		}
+	return (0);
+}
+
+/*
+ * cl_dscroll --
+ *	Note that the lines from the cursor to the bottom of the window were
+ *	scrolled up (n > 0) or down (n < 0).
+ *
+ * PUBLIC: void cl_dscroll(CL_PRIVATE *, WINDOW *, int);
+ */
+void
+cl_dscroll(CL_PRIVATE *clp, WINDOW *win, int n)
+{
+	CL_DIRECT *dp;
+	size_t bot, top;
+	int i;
+
+	/* Scroll regions are full width. */
+	if ((dp = clp->dp) == NULL || getmaxx(win) != COLS)
+		return;
+	top = getbegy(win);
+	bot = top + getmaxy(win) - 1;
+	top += getcury(win);
+	if (top >= bot || bot >= dp->rows)
+		return;
+
+	/*
+	 * A line deleted, followed by one inserted above it in the same
+	 * window, scrolls the lines between them down.  The vi code does
+	 * this to scroll the text above the info line.
+	 */
+	if ((i = dp->nscroll - 1) >= 0 && n == -1 &&
+	    dp->scroll[i].n == 1 && dp->scroll[i].bot == bot &&
+	    dp->scroll[i].top > top) {
+		bot = dp->scroll[i].top;
+		--dp->nscroll;
+		--i;
+	}
+
+	/* Merge a run of scrolls in the same direction. */
+	if (i >= 0 &&
+	    dp->scroll[i].top == top && dp->scroll[i].bot == bot &&
+	    (dp->scroll[i].n > 0) == (n > 0)) {
+		if (abs(dp->scroll[i].n += n) < (int)(bot - top + 1))
+			return;
+	} else if (dp->nscroll < CL_NSCROLL) {
+		dp->scroll[dp->nscroll].top = top;
+		dp->scroll[dp->nscroll].bot = bot;
+		dp->scroll[dp->nscroll].n = n;
+		++dp->nscroll;
+		return;
+	}
+
+	/* Too much to replay, repaint the rows instead. */
+	dp->nscroll = 0;
+}
+
+/*
+ * cl_dend --
+ *	Discard the direct renderer.
+ *
+ * PUBLIC: void cl_dend(CL_PRIVATE *);
+ */
+void
+cl_dend(CL_PRIVATE *clp)
+{
+	CL_DIRECT *dp;
+
+	if ((dp = clp->dp) == NULL)
+		return;
+	free(dp->front);
+	free(dp->back);
+	free(dp->dirty);
+	free(dp->obuf);
+	free(dp->clear);
+	free(dp->cr);
+	free(dp->csr);
+	free(dp->cud1);
+	free(dp->dch);
+	free(dp->cuf);
+	free(dp->cuu1);
+	free(dp->cup);
+	free(dp->el);
+	free(dp->ich);
+	free(dp->ind);
+	free(dp->indn);
+	free(dp->ri);
+	free(dp->rin);
+	free(dp->smso);
+	free(dp->rmso);
+	free(dp);
+	clp->dp = NULL;
+}
+
+/*
+ * cl_dalloc --
+ *	Allocate the buffers for the current terminal size.
+ */
+static int
+cl_dalloc(CL_PRIVATE *clp)
+{
+	CL_DIRECT *dp;
+	size_t cells;
+
+	cl_dend(clp);
+	if (LINES <= 0 || COLS <= 0)
+		return (1);
+	CALLOC_RET(NULL, dp, 1, sizeof(CL_DIRECT));
+	clp->dp = dp;
+	dp->rows = LINES;
+	dp->cols = COLS;
+	cells = dp->rows * dp->cols;
+	CALLOC_GOTO(NULL, dp->front, cells, sizeof(CL_CELL));
+	CALLOC_GOTO(NULL, dp->back, dp->cols, sizeof(CL_CELL));
+	CALLOC_GOTO(NULL, dp->dirty, dp->rows, 1);
+
+	(void)cl_getcap(NULL, "clear", &dp->clear);
+	(void)cl_getcap(NULL, "cr", &dp->cr);
+	(void)cl_getcap(NULL, "csr", &dp->csr);
+	(void)cl_getcap(NULL, "cud1", &dp->cud1);
+	(void)cl_getcap(NULL, "dch", &dp->dch);
+	(void)cl_getcap(NULL, "cuf", &dp->cuf);
+	(void)cl_getcap(NULL, "cuu1", &dp->cuu1);
+	(void)cl_getcap(NULL, "cup", &dp->cup);
+	(void)cl_getcap(NULL, "el", &dp->el);
+	(void)cl_getcap(NULL, "ich", &dp->ich);
+	(void)cl_getcap(NULL, "ind", &dp->ind);
+	(void)cl_getcap(NULL, "indn", &dp->indn);
+	(void)cl_getcap(NULL, "ri", &dp->ri);
+	(void)cl_getcap(NULL, "rin", &dp->rin);
+	(void)cl_getcap(NULL, "smso", &dp->smso);
+	(void)cl_getcap(NULL, "rmso", &dp->rmso);
+	if (dp->cup == NULL)
+		goto alloc_err;
+	if (dp->ind == NULL || dp->ri == NULL) {
+		free(dp->csr);
+		dp->csr = NULL;
+	}
+	if (dp->smso == NULL || dp->rmso == NULL) {
+		free(dp->smso);
+		dp->smso = NULL;
+	}
+
+	/*
+	 * Writing the last cell of the screen scrolls terminals that wrap
+	 * immediately.
+	 */
+	dp->lastcell = tigetflag("am") <= 0 || tigetflag("xenl") > 0;
+	return (0);
+
+alloc_err:
+	cl_dend(clp);
+	return (1);
+}
+
+/*
+ * cl_drow --
+ *	Copy a row of the screen into the back buffer and redraw the spans
+ *	that differ from the front buffer.
+ */
+static void
+cl_drow(CL_DIRECT *dp, size_t lno)
+{
+	CL_CELL *bp, *fp;
+	size_t blank, cno, end, last, same, start;
+	int shifted, width;
+#ifdef USE_WIDECHAR
+	cchar_t cc;
+	attr_t attr;
+	wchar_t wc[CCHARW_MAX + 1];
+	short pair;
+#else
+	chtype ch;
+#endif
+
+	/*
+	 * Read the row.  Curses returns the same character for both columns
+	 * of a double-width one, mark the second as a continuation.
+	 */
+	bp = dp->back;
+	for (cno = width = 0; cno < dp->cols; ++cno) {
+#ifdef USE_WIDECHAR
+		(void)mvwin_wch(stdscr, lno, cno, &cc);
+		(void)getcchar(&cc, wc, &attr, &pair, NULL);
+		bp[cno].ch = wc[0] == L'\0' ? ' ' : wc[0];
+		bp[cno].attr = (attr & A_STANDOUT) != 0;
+#else
+		ch = mvwinch(stdscr, lno, cno);
+		bp[cno].ch = ch & A_CHARTEXT;
+		bp[cno].attr = (ch & A_STANDOUT) != 0;
+#endif
+		if (width > 1) {
+			bp[cno].width = 0;
+			--width;
+			continue;
+		}
+		width = XCHAR_WIDTH(NULL, bp[cno].ch);
+		if (width < 1 || width > 2)
+			width = 1;
+		bp[cno].width = width;
+	}
+
+	/* The row ends in blanks that can be erased instead. */
+	for (blank = dp->cols; blank > 0; --blank)
+		if (bp[blank - 1].ch != ' ' || bp[blank - 1].attr)
+			break;
+	last = dp->cols;
+	if (lno == dp->rows - 1 && !dp->lastcell)
+		--last;
+
+	fp = dp->front + lno * dp->cols;
+	for (cno = 0, shifted = 0; cno < last;) {
+		if (CELL_EQ(bp + cno, fp + cno)) {
+			++cno;
+			continue;
+		}
+
+		/*
+		 * If the rest of the row moved, e.g. a character was deleted,
+		 * shift it on the terminal instead of redrawing it.
+		 */
+		if (!shifted) {
+			shifted = 1;
+			if (cl_dshift(dp, lno, cno))
+				continue;
+		}
+
+		/* Start a span at the first column of a character. */
+		for (start = cno; start > 0 && bp[start].width == 0;)
+			--start;
+
+		/* Erase the rest of the row if it's blank. */
+		if (start >= blank && dp->el != NULL) {
+			cl_dmove(dp, lno, start);
+			(void)tputs(dp->el, 1, cl_dputc);
+			memcpy(fp + start, bp + start,
+			    (dp->cols - start) * sizeof(CL_CELL));
+			return;
+		}
+
+		/*
+		 * Extend it over short runs of unchanged cells, stopping where
+		 * the row can be erased.
+		 */
+		for (end = cno + 1, same = 0;
+		    end < last && same < SPAN_GAP; ++end) {
+			if (end == blank && dp->el != NULL)
+				break;
+			if (CELL_EQ(bp + end, fp + end))
+				++same;
+			else
+				same = 0;
+		}
+		end -= same;
+		while (end < last && bp[end].width == 0)
+			++end;
+		if (end == last && bp[end - 1].width == 2)
+			--end;
+		cl_dmove(dp, lno, start);
+		cl_demit(dp, bp + start, end - start);
+		memcpy(fp + start, bp + start, (end - start) * sizeof(CL_CELL));
+
+		/* At the right margin, the cursor may or may not have wrapped. */
+		if ((dp->cx = end) == dp->cols)
+			dp->cy = dp->cx = -1;
+		cno = end;
+	}
+}
+
+/*
+ * cl_dshift --
+ *	If the back buffer row matches the front buffer row shifted left or
+ *	right from column cno, shift the terminal row to match.
+ */
+static int
+cl_dshift(CL_DIRECT *dp, size_t lno, size_t cno)
+{
+	CL_CELL *bp, *fp;
+	size_t cnt, end, len;
+	int n;
+
+	if (dp->dch == NULL || dp->ich == NULL)
+		return (0);
+	bp = dp->back;
+	fp = dp->front + lno * dp->cols;
+
+	/* Double-width characters and unknown cells don't shift simply. */
+	for (end = cno, cnt = cno; cnt < dp->cols; ++cnt) {
+		if (bp[cnt].width != 1 || fp[cnt].width != 1 ||
+		    fp[cnt].attr == CL_UNKNOWN)
+			return (0);
+		if (bp[cnt].ch != ' ' || bp[cnt].attr ||
+		    fp[cnt].ch != ' ' || fp[cnt].attr)
+			end = cnt + 1;
+	}
+
+	/* Try deleting, then inserting, up to SPAN_GAP * 2 characters. */
+	for (n = 1; n <= SPAN_GAP * 2 && cno + n + SHIFT_MIN <= end; ++n) {
+		for (cnt = cno; cnt + n < end; ++cnt)
+			if (!CELL_EQ(bp + cnt, fp + cnt + n))
+				break;
+		if (cnt + n == end)
+			goto found;
+		for (cnt = cno + n; cnt < end; ++cnt)
+			if (!CELL_EQ(bp + cnt, fp + cnt - n))
+				break;
+		if (cnt == end) {
+			n = -n;
+			goto found;
+		}
+	}
+	return (0);
+
+found:	cl_dmove(dp, lno, cno);
+	len = (dp->cols - cno - abs(n)) * sizeof(CL_CELL);
+	if (n > 0) {
+		(void)tputs(tgoto(dp->dch, 0, n), 1, cl_dputc);
+		memmove(fp + cno, fp + cno + n, len);
+		cnt = dp->cols - n;
+	} else {
+		(void)tputs(tgoto(dp->ich, 0, -n), 1, cl_dputc);
+		memmove(fp + cno - n, fp + cno, len);
+		cnt = cno;
+	}
+	for (end = cnt + abs(n); cnt < end; ++cnt) {
+		fp[cnt].ch = ' ';
+		fp[cnt].attr = 0;
+		fp[cnt].width = 1;
+	}
+	return (1);
+}
+
+/*
+ * cl_demit --
+ *	Append a run of cells to the frame.
+ */
+static void
+cl_demit(CL_DIRECT *dp, CL_CELL *cp, size_t len)
+{
+	size_t mblen;
+	int attr;
+	char mb[MB_LEN_MAX];
+#ifdef USE_WIDECHAR
+	mbstate_t mbs;
+
+	memset(&mbs, 0, sizeof(mbs));
+#endif
+	for (attr = 0; len > 0; --len, ++cp) {
+		if (cp->width == 0)
+			continue;
+		if (dp->smso != NULL && cp->attr != attr) {
+			(void)tputs((attr = cp->attr) ?
+			    dp->smso : dp->rmso, 1, cl_dputc);
+		}
+#ifdef USE_WIDECHAR
+		if ((mblen = wcrtomb(mb, cp->ch, &mbs)) == (size_t)-1) {
+			memset(&mbs, 0, sizeof(mbs));
+			mb[0] = '?';
+			mblen = 1;
+		}
+#else
+		mb[0] = cp->ch;
+		mblen = 1;
+#endif
+		cl_dputs(dp, mb, mblen);
+	}
+	if (attr)
+		(void)tputs(dp->rmso, 1, cl_dputc);
+}
+
+/*
+ * cl_dmove --
+ *	Move the cursor, if it isn't already there.
+ */
+static void
+cl_dmove(CL_DIRECT *dp, size_t lno, size_t cno)
+{
+	/*
+	 * Use the shorter relative motions when possible.  Tgoto passes its
+	 * row argument as the first parameter, the cuf count.
+	 */
+	if (lno + 1 == (size_t)dp->cy &&
+	    cno == (size_t)dp->cx && dp->cuu1 != NULL) {
+		(void)tputs(dp->cuu1, 1, cl_dputc);
+		goto done;
+	}
+	if ((size_t)dp->cy == lno && dp->cx >= 0) {
+		if ((size_t)dp->cx == cno)
+			return;
+		if (cno == 0 && dp->cr != NULL) {
+			(void)tputs(dp->cr, 1, cl_dputc);
+			goto done;
+		}
+		if (cno > (size_t)dp->cx && dp->cuf != NULL) {
+			(void)tputs(tgoto(dp->cuf,
+			    0, cno - dp->cx), 1, cl_dputc);
+			goto done;
+		}
+	} else if (cno == 0 && dp->cy >= 0 && lno == (size_t)dp->cy + 1 &&
+	    dp->cr != NULL && dp->cud1 != NULL) {
+		(void)tputs(dp->cr, 1, cl_dputc);
+		(void)tputs(dp->cud1, 1, cl_dputc);
+		goto done;
+	}
+	(void)tputs(tgoto(dp->cup, cno, lno), 1, cl_dputc);
+done:	dp->cy = lno;
+	dp->cx = cno;
+}
+
+/*
+ * cl_dscrollup --
+ *	Scroll the front buffer lines top to bot up (n > 0) or down (n < 0).
+ */
+static void
+cl_dscrollup(CL_DIRECT *dp, size_t top, size_t bot, int n)
+{
+	CL_CELL *fp;
+	size_t cnt, len, rows;
+
+	rows = bot - top + 1;
+	if ((size_t)abs(n) < rows) {
+		len = (rows - abs(n)) * dp->cols * sizeof(CL_CELL);
+		fp = dp->front + top * dp->cols;
+		if (n > 0)
+			memmove(fp, fp + n * dp->cols, len);
+		else
+			memmove(fp - n * dp->cols, fp, len);
+	}
+
+	/* The new lines are blank. */
+	if (n > 0)
+		fp = dp->front + (bot - MIN(n, rows) + 1) * dp->cols;
+	else
+		fp = dp->front + top * dp->cols;
+	for (cnt = MIN((size_t)abs(n), rows) * dp->cols; cnt > 0; --cnt, ++fp) {
+		fp->ch = ' ';
+		fp->attr = 0;
+		fp->width = 1;
+	}
+	memset(dp->dirty + top, 1, rows);
+}
+
+/*
+ * cl_dputs --
+ *	Append bytes to the frame.
+ */
+static void
+cl_dputs(CL_DIRECT *dp, char *p, size_t len)
+{
+	size_t blen;
+	char *bp;
+
+	if (dp->olen + len > dp->oblen) {
+		blen = MAX(dp->oblen * 2, dp->olen + len + 1024);
+		if ((bp = realloc(dp->obuf, blen)) == NULL) {
+			dp->oerr = 1;
+			return;
+		}
+		dp->obuf = bp;
+		dp->oblen = blen;
+	}
+	memcpy(dp->obuf + dp->olen, p, len);
+	dp->olen += len;
+}
+
+/*
+ * cl_dputc --
+ *	Function version of cl_dputs, for tputs.
+ */
+static int
+cl_dputc(int ch)
+{
+	char c;
+
+	c = ch;
+	cl_dputs(outdp, &c, 1);
+	return (ch);
+}
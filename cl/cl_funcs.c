@@ -333,6 +333,7 @@ cl_deleteln(SCR *sp)
 	 * The bottom line is expected to be blank after this operation,
 	 * and other screens must support that semantic.
 	 */
+	cl_dscroll(clp, win, 1);
 	return (wdeleteln(win) == ERR);
 }
 
@@ -447,6 +448,7 @@ cl_insertln(SCR *sp)
 	 * The current line is expected to be blank after this operation,
 	 * and the screen must support that semantic.
 	 */
+	cl_dscroll(CLP(sp), win, -1);
 	return (winsertln(win) == ERR);
 }
 
@@ -522,6 +524,8 @@ cl_refresh(SCR *sp, int repaint)
 	WINDOW *win;
 	SCR *psp, *tsp;
 	size_t y, x;
+	uint64_t t;
+	int rval;
 
 	gp = sp->gp;
 	clp = CLP(sp);
@@ -559,6 +563,28 @@ cl_refresh(SCR *sp, int repaint)
 		F_CLR(clp, CL_LAYOUT);
 	}
 
+	STAT_START(t);
+	TR_EVENT(sp, TR_UPDATE, TR_BEGIN, sp == clp->focus);
+	if (O_ISSET(sp, O_DIRECTDRAW)) {
+		/*
+		 * The direct renderer draws all of the screens at once, do
+		 * it for the focus window, see below.
+		 */
+		rval = clp->focus != NULL && sp != clp->focus ?
+		    0 : cl_dflush(gp, win, repaint);
+		goto done;
+	}
+
+	/*
+	 * If the direct renderer was drawing, curses has no idea what's on
+	 * the terminal, and the lines it drew are no longer marked as touched.
+	 */
+	if (clp->dp != NULL) {
+		cl_dend(clp);
+		touchwin(stdscr);
+		repaint = 1;
+	}
+
 	/*
 	 * In the curses library, doing wrefresh(curscr) is okay, but the
 	 * screen flashes when we then apply the refresh() to bring it up
@@ -572,9 +598,22 @@ cl_refresh(SCR *sp, int repaint)
 	 * is called for that window after refreshing the others.
 	 * This prevents the cursor being drawn in the other windows.
 	 */
-	return (wnoutrefresh(stdscr) == ERR || 
+	rval = wnoutrefresh(stdscr) == ERR || 
 		wnoutrefresh(win) == ERR || 
-		(sp == clp->focus && doupdate() == ERR));
+		(sp == clp->focus && doupdate() == ERR);
+done:	TR_EVENT(sp, TR_UPDATE, TR_END, rval);
+	STAT_STOP(sp, refresh_time, t);
+	STAT_INC(sp, refresh);
+
+	/* The screen is up to date, a pending key event has been handled. */
+	if (sp == clp->focus && gp->stats.key_start != 0) {
+		t = stats_now() - gp->stats.key_start;
+		gp->stats.key_time += t;
+		if (t > gp->stats.key_max)
+			gp->stats.key_max = t;
+		gp->stats.key_start = 0;
+	}
+	return (rval);
 }
 
 /*
@@ -749,7 +788,10 @@ cl_suspend(SCR *sp, int *allowedp)
 	 */
 	getyx(win, y, x);
 	(void)wmove(win, LINES - 1, 0);
-	(void)wrefresh(win);
+	if (clp->dp != NULL)
+		(void)cl_dflush(sp->gp, win, 0);
+	else
+		(void)wrefresh(win);
 
 	/*
 	 * Temporarily end the screen.  System V introduced a semantic where
@@ -794,7 +836,8 @@ cl_suspend(SCR *sp, int *allowedp)
 	}
 
 	/* Restore terminal settings. */
-	wrefresh(win);			    /* Needed on SunOs/Solaris ? */
+	if (clp->dp == NULL)
+		wrefresh(win);		    /* Needed on SunOs/Solaris ? */
 	if (F_ISSET(clp, CL_STDIN_TTY))
 		(void)tcsetattr(STDIN_FILENO, TCSASOFT | TCSADRAIN, &t);
 
@@ -827,8 +870,8 @@ void
 cl_usage(void)
 {
 #define	USAGE "\
-usage: ex [-eFRrSsv] [-c command] [-t tag] [-w size] [file ...]\n\
-usage: vi [-eFlRrSv] [-c command] [-t tag] [-w size] [file ...]\n"
+usage: ex [-eFPRrSsv] [-c command] [-t tag] [-w size] [file ...]\n\
+usage: vi [-eFlPRrSv] [-c command] [-t tag] [-w size] [file ...]\n"
 	(void)fprintf(stderr, "%s", USAGE);
 #undef	USAGE
 }
@@ -96,7 +96,10 @@ cl_screen(SCR *sp, u_int32_t flags)
 			wclrtobot(win);
 		}
 		(void)wmove(win, RLNO(sp, sp->rows) - 1, 0);
-		wrefresh(win);
+		if (clp->dp != NULL)
+			(void)cl_dflush(gp, win, 0);
+		else
+			wrefresh(win);
 	}
 
 	/* Enter the requested mode. */
@@ -393,8 +396,12 @@ cl_vi_end(GS *gp)
 		(void)move(0, 0);
 		(void)deleteln();
 		(void)move(LINES - 1, 0);
-		(void)refresh();
+		if (clp->dp != NULL)
+			(void)cl_dflush(gp, stdscr, 0);
+		else
+			(void)refresh();
 	}
+	cl_dend(clp);
 
 	cl_freecap(clp);
 
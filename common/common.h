@@ -81,6 +81,8 @@ typedef enum { SEQ_ABBREV, SEQ_COMMAND, SEQ_INPUT } seq_t;
 #include "util.h"		/* Required by ex.h. */
 #include "mark.h"		/* Required by gs.h. */
 #include "conv.h"		/* Required by ex.h and screen.h */
+#include "pool.h"		/* Required by stats.h and gs.h. */
+#include "stats.h"		/* Required by gs.h. */
 #include "../ex/ex.h"		/* Required by gs.h. */
 #include "gs.h"			/* Required by screen.h. */
 #include "screen.h"		/* Required by exf.h. */
@@ -25,6 +25,9 @@
 #include <string.h>
 #include <strings.h>
 #include <unistd.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 #include "common.h"
 
@@ -303,6 +306,167 @@ cs_int2char(SCR *sp, const CHAR_T * str, ssize_t len, CONVWIN *cw,
 	return default_int2char(sp, str, len, cw, tolen, dst, (iconv_t)-1);
 }
 
+/*
+ * The locale is UTF-8 and wchar_t holds Unicode code points, the common
+ * case by far, so convert without a libc call per character.  Runs of
+ * ASCII are widened/narrowed 16 bytes at a time with SSE2 where we have
+ * it.  Only well-formed RFC 3629 sequences are handled here, everything
+ * else (malformed, incomplete, or out of range) takes the general path,
+ * so the error reporting is the same as before.
+ */
+#if defined(__SSE2__) && WCHAR_MAX > 0xffff
+#define	UTF8_SSE2
+#endif
+
+static int 
+utf8_char2int(SCR *sp, const char * str, ssize_t len, CONVWIN *cw,
+    size_t *tolen, CHAR_T **dst)
+{
+	const u_char *s, *e;
+	CHAR_T *d;
+	u_int c, c1, c2, c3;
+#ifdef UTF8_SSE2
+	__m128i v, z, lo, hi;
+#endif
+
+	BINC_RETW(NULL, cw->bp1.wc, cw->blen1, len);
+	d = cw->bp1.wc;
+	s = (const u_char *)str;
+	e = s + len;
+	while (s < e) {
+#ifdef UTF8_SSE2
+		for (z = _mm_setzero_si128(); e - s >= 16; s += 16, d += 16) {
+			v = _mm_loadu_si128((const __m128i *)s);
+			if (_mm_movemask_epi8(v) != 0)
+				break;
+			lo = _mm_unpacklo_epi8(v, z);
+			hi = _mm_unpackhi_epi8(v, z);
+			_mm_storeu_si128((__m128i *)d, _mm_unpacklo_epi16(lo, z));
+			_mm_storeu_si128((__m128i *)d + 1,
+			    _mm_unpackhi_epi16(lo, z));
+			_mm_storeu_si128((__m128i *)d + 2,
+			    _mm_unpacklo_epi16(hi, z));
+			_mm_storeu_si128((__m128i *)d + 3,
+			    _mm_unpackhi_epi16(hi, z));
+		}
+		if (s == e)
+			break;
+#endif
+		if ((c = *s) < 0x80) {
+			*d++ = c;
+			++s;
+			continue;
+		}
+		if (c < 0xc2 || c > 0xf4)
+			goto slow;
+		if (c < 0xe0) {
+			if (e - s < 2 || ((c1 = s[1]) & 0xc0) != 0x80)
+				goto slow;
+			*d++ = (c & 0x1f) << 6 | (c1 & 0x3f);
+			s += 2;
+		} else if (c < 0xf0) {
+			if (e - s < 3 || ((c1 = s[1]) & 0xc0) != 0x80 ||
+			    ((c2 = s[2]) & 0xc0) != 0x80)
+				goto slow;
+			c = (c & 0x0f) << 12 | (c1 & 0x3f) << 6 | (c2 & 0x3f);
+			/* Overlong or surrogate. */
+			if (c < 0x800 || (c >= 0xd800 && c <= 0xdfff))
+				goto slow;
+			*d++ = c;
+			s += 3;
+		} else {
+			if (e - s < 4 || ((c1 = s[1]) & 0xc0) != 0x80 ||
+			    ((c2 = s[2]) & 0xc0) != 0x80 ||
+			    ((c3 = s[3]) & 0xc0) != 0x80)
+				goto slow;
+			c = (c & 0x07) << 18 | (c1 & 0x3f) << 12 |
+			    (c2 & 0x3f) << 6 | (c3 & 0x3f);
+			/* Overlong or beyond Unicode. */
+			if (c < 0x10000 || c > 0x10ffff)
+				goto slow;
+			*d++ = c;
+			s += 4;
+		}
+	}
+
+	*tolen = d - cw->bp1.wc;
+	*dst = cw->bp1.wc;
+	return 0;
+
+slow:	return default_char2int(sp, str, len, cw, tolen, dst, (iconv_t)-1);
+}
+
+static int 
+utf8_int2char(SCR *sp, const CHAR_T * str, ssize_t len, CONVWIN *cw, 
+    size_t *tolen, char **dst)
+{
+	const CHAR_T *s, *e;
+	u_char *d;
+	size_t off;
+	u_int c;
+#ifdef UTF8_SSE2
+	__m128i a, b, m, v, w;
+#endif
+
+	/* Room for all ASCII and the trailing NUL; grown on demand. */
+	BINC_RETC(NULL, cw->bp1.c, cw->blen1, len + 1);
+	d = (u_char *)cw->bp1.c;
+	s = str;
+	e = s + len;
+	while (s < e) {
+#ifdef UTF8_SSE2
+		for (m = _mm_set1_epi32(~0x7f); e - s >= 16; s += 16, d += 16) {
+			a = _mm_loadu_si128((const __m128i *)s);
+			b = _mm_loadu_si128((const __m128i *)s + 1);
+			v = _mm_loadu_si128((const __m128i *)s + 2);
+			w = _mm_loadu_si128((const __m128i *)s + 3);
+			if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(
+			    _mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(v, w)),
+			    m), _mm_setzero_si128())) != 0xffff)
+				break;
+			_mm_storeu_si128((__m128i *)d, _mm_packus_epi16(
+			    _mm_packs_epi32(a, b), _mm_packs_epi32(v, w)));
+		}
+		if (s == e)
+			break;
+#endif
+		if ((c = *s) < 0x80) {
+			*d++ = c;
+			++s;
+			continue;
+		}
+		if (c > 0x10ffff || (c >= 0xd800 && c <= 0xdfff))
+			goto slow;
+
+		/* At most 4 bytes for this one, 1 for each of the rest. */
+		off = d - (u_char *)cw->bp1.c;
+		if (cw->blen1 < off + 4 + (e - s)) {
+			BINC_RETC(NULL, cw->bp1.c, cw->blen1,
+			    off + 4 + (e - s) + 256);
+			d = (u_char *)cw->bp1.c + off;
+		}
+		if (c < 0x800) {
+			*d++ = 0xc0 | c >> 6;
+		} else if (c < 0x10000) {
+			*d++ = 0xe0 | c >> 12;
+			*d++ = 0x80 | (c >> 6 & 0x3f);
+		} else {
+			*d++ = 0xf0 | c >> 18;
+			*d++ = 0x80 | (c >> 12 & 0x3f);
+			*d++ = 0x80 | (c >> 6 & 0x3f);
+		}
+		*d++ = 0x80 | (c & 0x3f);
+		++s;
+	}
+	*d = '\0';
+
+	*tolen = d - (u_char *)cw->bp1.c;
+	*dst = cw->bp1.c;
+	return 0;
+
+slow:	return default_int2char(sp, str, len, cw, tolen, dst, (iconv_t)-1);
+}
+
 #endif
 
 /*
@@ -343,6 +507,10 @@ conv_init(SCR *orig, SCR *sp)
 			sp->conv.sys2int = sp->conv.file2int = raw2int;
 			sp->conv.int2sys = sp->conv.int2file = int2raw;
 			sp->conv.input2int = raw2int;
+		} else if (!strcmp(codeset(), "UTF-8")) {
+			sp->conv.sys2int = sp->conv.file2int = utf8_char2int;
+			sp->conv.int2sys = sp->conv.int2file = utf8_int2char;
+			sp->conv.input2int = utf8_char2int;
 		} else {
 			sp->conv.sys2int = cs_char2int;
 			sp->conv.int2sys = cs_int2char;
@@ -429,6 +597,24 @@ conv_enc(SCR *sp, int option, char *enc)
 	*c2w = id_c2w;
 	*w2c = id_w2c;
 
+	/*
+	 * The UTF-8 converters don't use iconv(3), switch to the general
+	 * ones while the file or input encoding isn't the locale's.
+	 */
+	if (sp->conv.sys2int == utf8_char2int)
+		switch (option) {
+		case O_FILEENCODING:
+			sp->conv.file2int = id_c2w == (iconv_t)-1 ?
+			    utf8_char2int : fe_char2int;
+			sp->conv.int2file = id_w2c == (iconv_t)-1 ?
+			    utf8_int2char : fe_int2char;
+			break;
+		case O_INPUTENCODING:
+			sp->conv.input2int = id_c2w == (iconv_t)-1 ?
+			    utf8_char2int : ie_char2int;
+			break;
+		}
+
 	F_CLR(sp, SC_CONV_ERROR);
 	F_SET(sp, SC_SCR_REFORMAT);
 
@@ -446,6 +632,25 @@ err:
 	return 1;
 }
 
+/*
+ * conv_file2int_mt --
+ *	Return the file conversion, if it can be used by other threads,
+ *	i.e., if it doesn't use the screen's iconv descriptors.
+ *
+ * PUBLIC: char2wchar_t conv_file2int_mt(SCR *);
+ */
+char2wchar_t
+conv_file2int_mt(SCR *sp)
+{
+	if (sp->conv.file2int != fe_char2int)
+		return (sp->conv.file2int);
+#if defined(USE_WIDECHAR) && defined(USE_ICONV)
+	if (sp->conv.id[IC_FE_CHAR2INT] != (iconv_t)-1)
+		return (NULL);
+#endif
+	return (cs_char2int);
+}
+
 /*
  * conv_end --
  *	Close the iconv descriptors, release the buffer.
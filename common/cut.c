@@ -25,6 +25,19 @@
 #include "common.h"
 
 static void	cb_rotate(SCR *);
+static CB	*cb_new(SCR *, CHAR_T);
+static int	cb_own(SCR *, CB *, int);
+static void	cb_share(CB *, CB *);
+static CBTEXT	*cbt_new(SCR *);
+static void	cbt_free(CBTEXT *);
+static void	cbt_clear(CBTEXT *);
+static TEXT	*cbt_add(SCR *, CBTEXT *, const CHAR_T *, size_t);
+static int	cbt_copy(SCR *, CBTEXT *, TEXT *, size_t *);
+
+/* Cut buffer text chunk sizes. */
+#define	CBT_ALIGN(n)	(((n) + sizeof(void *) - 1) & ~(sizeof(void *) - 1))
+#define	CBT_CHUNK_MIN	1024
+#define	CBT_CHUNK_MAX	(64 * 1024)
 
 /*
  * cut --
@@ -63,7 +76,8 @@ static void	cb_rotate(SCR *);
 int
 cut(SCR *sp, CHAR_T *namep, MARK *fm, MARK *tm, int flags)
 {
-	CB *cbp;
+	CB *cbp, *scbp;
+	TEXT *tp;
 	CHAR_T name = '\0';
 	recno_t lno;
 	int append, copy_one, copy_def;
@@ -74,9 +88,8 @@ cut(SCR *sp, CHAR_T *namep, MARK *fm, MARK *tm, int flags)
 
 	/*
 	 * If the user specified a buffer, put it there.  (This may require
-	 * a copy into the numeric buffers.  We do the copy so that we don't
-	 * have to reference count and so we don't have to deal with things
-	 * like appends to buffers that are used multiple times.)
+	 * a copy into the numeric buffers.  The copy shares the text of the
+	 * named buffer, which is copied before it's later appended to.)
 	 *
 	 * Otherwise, if it's supposed to be put in a numeric buffer (usually
 	 * a delete) put it there.  The rules for putting things in numeric
@@ -116,22 +129,17 @@ namecb:		CBNAME(sp, cbp, name);
 	} else
 		cbp = &sp->gp->dcb_store;
 
-copyloop:
 	/*
 	 * If this is a new buffer, create it and add it into the list.
-	 * Otherwise, if it's not an append, free its current contents.
+	 * Otherwise, if it's not an append, discard its current contents.
 	 */
-	if (cbp == NULL) {
-		CALLOC_RET(sp, cbp, 1, sizeof(CB));
-		cbp->name = name;
-		TAILQ_INIT(cbp->textq);
-		SLIST_INSERT_HEAD(sp->gp->cutq, cbp, q);
-	} else if (!append) {
-		text_lfree(cbp->textq);
-		cbp->len = 0;
-		cbp->flags = 0;
-	}
+	if (cbp == NULL && (cbp = cb_new(sp, name)) == NULL)
+		return (1);
+	if (cb_own(sp, cbp, append))
+		return (1);
 
+	/* Remember the end of the text, appended lines follow it. */
+	tp = TAILQ_LAST(cbp->textq, _texth);
 
 	/* In line mode, it's pretty easy, just cut the lines. */
 	if (LF_ISSET(CUT_LINEMODE)) {
@@ -158,31 +166,123 @@ copyloop:
 		    cut_line(sp, lno, 0, tm->cno + 1, cbp))
 			goto cut_line_err;
 	}
+	sp->gp->dcbp = cbp;
 
-	append = 0;		/* Only append to the named buffer. */
-	sp->gp->dcbp = cbp;	/* Repoint the default buffer on each pass. */
+	if (!copy_one && !copy_def)
+		return (0);
 
-	if (copy_one) {		/* Copy into numeric buffer 1. */
+	/*
+	 * Copy into numeric buffer 1 or the default buffer.  A buffer that
+	 * was replaced is shared, otherwise the new lines are copied from
+	 * memory, not cut from the file again.
+	 */
+	scbp = cbp;
+	if (copy_one) {
 		name = '1';
 		CBNAME(sp, cbp, name);
-		copy_one = 0;
-		goto copyloop;
-	}
-	if (copy_def) {		/* Copy into the default buffer. */
+		if (cbp == NULL && (cbp = cb_new(sp, name)) == NULL)
+			return (1);
+	} else
 		cbp = &sp->gp->dcb_store;
-		copy_def = 0;
-		goto copyloop;
+	if (cbp == scbp)
+		return (0);
+	if (!append)
+		cb_share(cbp, scbp);
+	else {
+		if (cb_own(sp, cbp, 0))
+			return (1);
+		if (LF_ISSET(CUT_LINEMODE))
+			cbp->flags |= CB_LMODE;
+		if (cbt_copy(sp, cbp->ctp, tp == NULL ?
+		    TAILQ_FIRST(scbp->textq) : TAILQ_NEXT(tp, q), &cbp->len))
+			goto cut_line_err;
 	}
+	sp->gp->dcbp = cbp;	/* Repoint the default buffer. */
 	return (0);
 
 cut_line_err:	
-	text_lfree(cbp->textq);
+	cbt_clear(cbp->ctp);
 	cbp->len = 0;
 	cbp->flags = 0;
 	sp->gp->dcbp = NULL;
 	return (1);
 }
 
+/*
+ * cb_new --
+ *	Create a cut buffer and add it into the list.
+ */
+static CB *
+cb_new(SCR *sp, CHAR_T name)
+{
+	CB *cbp;
+
+	CALLOC(sp, cbp, 1, sizeof(CB));
+	if (cbp == NULL)
+		return (NULL);
+	if ((cbp->ctp = cbt_new(sp)) == NULL) {
+		free(cbp);
+		return (NULL);
+	}
+	cbp->textq = cbp->ctp->textq;
+	cbp->name = name;
+	SLIST_INSERT_HEAD(sp->gp->cutq, cbp, q);
+	return (cbp);
+}
+
+/*
+ * cb_own --
+ *	Get a cut buffer's text for writing: discard it unless appending,
+ *	and copy it first if it's shared.
+ */
+static int
+cb_own(SCR *sp, CB *cbp, int append)
+{
+	CBTEXT *ctp;
+
+	if (cbp->ctp != NULL && cbp->ctp->refcnt == 1) {
+		if (!append) {
+			cbt_clear(cbp->ctp);
+			cbp->len = 0;
+			cbp->flags = 0;
+		}
+		return (0);
+	}
+
+	if ((ctp = cbt_new(sp)) == NULL)
+		return (1);
+	if (cbp->ctp != NULL && append) {
+		if (cbt_copy(sp, ctp, TAILQ_FIRST(cbp->textq), NULL)) {
+			cbt_free(ctp);
+			return (1);
+		}
+	} else {
+		cbp->len = 0;
+		cbp->flags = 0;
+	}
+	if (cbp->ctp != NULL)
+		cbt_free(cbp->ctp);
+	cbp->ctp = ctp;
+	cbp->textq = ctp->textq;
+	return (0);
+}
+
+/*
+ * cb_share --
+ *	Replace a cut buffer's text with another buffer's text.
+ */
+static void
+cb_share(CB *cbp, CB *scbp)
+{
+	if (cbp->ctp != NULL)
+		cbt_free(cbp->ctp);
+	cbp->ctp = scbp->ctp;
+	++cbp->ctp->refcnt;
+	cbp->textq = scbp->textq;
+	cbp->len = scbp->len;
+	cbp->flags = scbp->flags;
+}
+
 /*
  * cb_rotate --
  *	Rotate the numbered buffers up one.
@@ -210,7 +310,7 @@ cb_rotate(SCR *sp)
 		pre_cbp = cbp;
 	}
 	if (del_cbp != NULL) {
-		text_lfree(del_cbp->textq);
+		cbt_free(del_cbp->ctp);
 		free(del_cbp);
 	}
 }
@@ -232,23 +332,20 @@ cut_line(SCR *sp, recno_t lno, size_t fcno, size_t clen, CB *cbp)
 	if (db_get(sp, lno, DBG_FATAL, &p, &len))
 		return (1);
 
-	/* Create a TEXT structure that can hold the entire line. */
-	if ((tp = text_init(sp, NULL, 0, len)) == NULL)
-		return (1);
-
 	/*
 	 * If the line isn't empty and it's not the entire line,
-	 * copy the portion we want, and reset the TEXT length.
+	 * copy the portion we want.
 	 */
 	if (len != 0) {
 		if (clen == ENTIRE_LINE)
 			clen = len - fcno;
-		MEMCPY(tp->lb, p + fcno, clen);
-		tp->len = clen;
-	}
+		p += fcno;
+	} else
+		clen = 0;
 
 	/* Append to the end of the cut buffer. */
-	TAILQ_INSERT_TAIL(cbp->textq, tp, q);
+	if ((tp = cbt_add(sp, cbp->ctp, p, clen)) == NULL)
+		return (1);
 	cbp->len += tp->len;
 
 	return (0);
@@ -267,16 +364,130 @@ cut_close(GS *gp)
 
 	/* Free cut buffer list. */
 	while ((cbp = SLIST_FIRST(gp->cutq)) != NULL) {
-		if (!TAILQ_EMPTY(cbp->textq))
-			text_lfree(cbp->textq);
+		cbt_free(cbp->ctp);
 		SLIST_REMOVE_HEAD(gp->cutq, q);
 		free(cbp);
 	}
 
 	/* Free default cut storage. */
 	cbp = &gp->dcb_store;
-	if (!TAILQ_EMPTY(cbp->textq))
-		text_lfree(cbp->textq);
+	if (cbp->ctp != NULL) {
+		cbt_free(cbp->ctp);
+		cbp->ctp = NULL;
+		cbp->textq = NULL;
+	}
+	gp->dcbp = NULL;
+}
+
+/*
+ * cbt_new --
+ *	Allocate an empty cut buffer text.
+ */
+static CBTEXT *
+cbt_new(SCR *sp)
+{
+	CBTEXT *ctp;
+
+	CALLOC(sp, ctp, 1, sizeof(CBTEXT));
+	if (ctp == NULL)
+		return (NULL);
+	TAILQ_INIT(ctp->textq);
+	ctp->refcnt = 1;
+	return (ctp);
+}
+
+/*
+ * cbt_free --
+ *	Release a reference to a cut buffer text.
+ */
+static void
+cbt_free(CBTEXT *ctp)
+{
+	if (--ctp->refcnt != 0)
+		return;
+	cbt_clear(ctp);
+	free(ctp);
+}
+
+/*
+ * cbt_clear --
+ *	Discard the contents of a cut buffer text.
+ */
+static void
+cbt_clear(CBTEXT *ctp)
+{
+	void *next;
+
+	for (; ctp->chunks != NULL; ctp->chunks = next) {
+		next = *(void **)ctp->chunks;
+		free(ctp->chunks);
+	}
+	TAILQ_INIT(ctp->textq);
+	ctp->clen = 0;
+	ctp->bp = NULL;
+	ctp->blen = 0;
+}
+
+/*
+ * cbt_add --
+ *	Append a line to a cut buffer text.
+ */
+static TEXT *
+cbt_add(SCR *sp, CBTEXT *ctp, const CHAR_T *p, size_t len)
+{
+	TEXT *tp;
+	size_t clen, tlen;
+	char *bp;
+
+	/*
+	 * The TEXT structure and its line buffer are allocated together,
+	 * from the last chunk if there's room, else from a new one.  Chunks
+	 * double in size, so small cuts stay small.
+	 */
+	tlen = CBT_ALIGN(sizeof(TEXT)) + CBT_ALIGN(len * sizeof(CHAR_T));
+	if (tlen > ctp->blen) {
+		clen = ctp->clen == 0 ? CBT_CHUNK_MIN : ctp->clen * 2;
+		if (clen > CBT_CHUNK_MAX)
+			clen = CBT_CHUNK_MAX;
+		if (clen < tlen + CBT_ALIGN(sizeof(void *)))
+			clen = tlen + CBT_ALIGN(sizeof(void *));
+		MALLOC(sp, bp, clen);
+		if (bp == NULL)
+			return (NULL);
+		*(void **)bp = ctp->chunks;
+		ctp->chunks = bp;
+		ctp->clen = clen;
+		ctp->bp = bp + CBT_ALIGN(sizeof(void *));
+		ctp->blen = clen - CBT_ALIGN(sizeof(void *));
+	}
+	tp = (TEXT *)ctp->bp;
+	ctp->bp += tlen;
+	ctp->blen -= tlen;
+
+	memset(tp, 0, sizeof(TEXT));
+	if ((tp->lb_len = len * sizeof(CHAR_T)) != 0) {
+		tp->lb = (CHAR_T *)((char *)tp + CBT_ALIGN(sizeof(TEXT)));
+		MEMCPY(tp->lb, p, len);
+	}
+	tp->len = len;
+	TAILQ_INSERT_TAIL(ctp->textq, tp, q);
+	return (tp);
+}
+
+/*
+ * cbt_copy --
+ *	Append copies of a list of lines to a cut buffer text.
+ */
+static int
+cbt_copy(SCR *sp, CBTEXT *ctp, TEXT *tp, size_t *lenp)
+{
+	for (; tp != NULL; tp = TAILQ_NEXT(tp, q)) {
+		if (cbt_add(sp, ctp, tp->lb, tp->len) == NULL)
+			return (1);
+		if (lenp != NULL)
+			*lenp += tp->len;
+	}
+	return (0);
 }
 
 /*
@@ -290,14 +501,13 @@ text_init(SCR *sp, const CHAR_T *p, size_t len, size_t total_len)
 {
 	TEXT *tp;
 
-	CALLOC(sp, tp, 1, sizeof(TEXT));
-	if (tp == NULL)
+	if ((tp = pool_get(sp, P_TEXT)) == NULL)
 		return (NULL);
 	/* ANSI C doesn't define a call to malloc(3) for 0 bytes. */
 	if ((tp->lb_len = total_len * sizeof(CHAR_T)) != 0) {
 		MALLOC(sp, tp->lb, tp->lb_len);
 		if (tp->lb == NULL) {
-			free(tp);
+			pool_put(sp, P_TEXT, tp);
 			return (NULL);
 		}
 		if (p != NULL && len != 0)
@@ -311,16 +521,16 @@ text_init(SCR *sp, const CHAR_T *p, size_t len, size_t total_len)
  * text_lfree --
  *	Free a chain of text structures.
  *
- * PUBLIC: void text_lfree(TEXTH *);
+ * PUBLIC: void text_lfree(SCR *, TEXTH *);
  */
 void
-text_lfree(TEXTH *headp)
+text_lfree(SCR *sp, TEXTH *headp)
 {
 	TEXT *tp;
 
 	while ((tp = TAILQ_FIRST(headp)) != NULL) {
 		TAILQ_REMOVE(headp, tp, q);
-		text_free(tp);
+		text_free(sp, tp);
 	}
 }
 
@@ -328,11 +538,11 @@ text_lfree(TEXTH *headp)
  * text_free --
  *	Free a text structure.
  *
- * PUBLIC: void text_free(TEXT *);
+ * PUBLIC: void text_free(SCR *, TEXT *);
  */
 void
-text_free(TEXT *tp)
+text_free(SCR *sp, TEXT *tp)
 {
 	free(tp->lb);
-	free(tp);
+	pool_put(sp, P_TEXT, tp);
 }
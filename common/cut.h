@@ -10,10 +10,28 @@
 typedef struct _texth TEXTH;		/* TEXT list head structure. */
 TAILQ_HEAD(_texth, _text);
 
+/*
+ * Cut buffer text.  The TEXT structures and their line buffers are carved
+ * out of a chain of chunks, so a cut costs a few allocations instead of
+ * two per line, and is discarded in one pass.  The text is reference
+ * counted, a cut buffer copied into a numeric or the default buffer shares
+ * it, and it's copied before it's appended to if it's shared.
+ */
+typedef struct _cbtext CBTEXT;
+struct _cbtext {
+	TEXTH	 textq[1];		/* Linked list of TEXT structures. */
+	u_int	 refcnt;		/* Reference count. */
+	void	*chunks;		/* Linked list of allocation chunks. */
+	size_t	 clen;			/* Last chunk length. */
+	char	*bp;			/* Free space in the last chunk. */
+	size_t	 blen;			/* Free space length. */
+};
+
 /* Cut buffers. */
 struct _cb {
 	SLIST_ENTRY(_cb) q;		/* Linked list of cut buffers. */
-	TEXTH	 textq[1];		/* Linked list of TEXT structures. */
+	CBTEXT	*ctp;			/* Shared cut buffer text. */
+	TEXTH	*textq;			/* Linked list of TEXT structures. */
 	/* XXXX Needed ? Can non ascii-chars be cut buffer names ? */
 	CHAR_T	 name;			/* Cut buffer name. */
 	size_t	 len;			/* Total length of cut text. */
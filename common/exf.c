@@ -32,12 +32,22 @@
 #include <unistd.h>
 
 #include "common.h"
+#include "../vi/vi.h"
 
 static int	file_backup(SCR *, char *, char *);
+static int	file_cache_add(SCR *, EXF *);
+static EXF	*file_cache_get(SCR *, struct stat *);
 static void	file_cinit(SCR *);
 static void	file_encinit(SCR *);
+static void	file_exf_free(SCR *, EXF *);
 static void	file_comment(SCR *);
 static int	file_spath(SCR *, FREF *, struct stat *, int *);
+static u_int32_t fref_hash(const char *);
+static int	fref_insert(SCR *, FREF *);
+static void	fref_remove(GS *, FREF *);
+
+/* Initial size of the FREF hash table. */
+#define	FREFH_SIZE	64
 
 /*
  * file_add --
@@ -70,17 +80,21 @@ file_add(SCR *sp, char *name)
 	 * them the next time we see them.
 	 */
 	gp = sp->gp;
-	if (name != NULL)
-		TAILQ_FOREACH_SAFE(frp, gp->frefq, q, tfrp) {
-			if (frp->name == NULL) {
-				TAILQ_REMOVE(gp->frefq, frp, q);
-				free(frp->name);
-				free(frp);
-				continue;
-			}
-			if (!strcmp(frp->name, name))
-				return (frp);
+	if (name != NULL) {
+		if (gp->fref_noname) {
+			TAILQ_FOREACH_SAFE(frp, gp->frefq, q, tfrp)
+				if (frp->name == NULL) {
+					TAILQ_REMOVE(gp->frefq, frp, q);
+					free(frp);
+				}
+			gp->fref_noname = 0;
 		}
+		if (gp->frefh != NULL)
+			for (frp = gp->frefh[fref_hash(name) &
+			    (gp->frefh_size - 1)]; frp != NULL; frp = frp->hnext)
+				if (!strcmp(frp->name, name))
+					return (frp);
+	}
 
 	/* Allocate and initialize the FREF structure. */
 	CALLOC(sp, frp, 1, sizeof(FREF));
@@ -99,12 +113,116 @@ file_add(SCR *sp, char *name)
 		return (NULL);
 	}
 
+	/* Index the name. */
+	if (fref_insert(sp, frp)) {
+		free(frp->name);
+		free(frp);
+		return (NULL);
+	}
+
 	/* Append into the chain of file names. */
 	TAILQ_INSERT_TAIL(gp->frefq, frp, q);
 
 	return (frp);
 }
 
+/*
+ * file_setname --
+ *	Replace the name of a FREF, keeping the name index current.  The
+ *	FREF takes ownership of the new name.
+ *
+ * PUBLIC: void file_setname(SCR *, FREF *, char *);
+ */
+void
+file_setname(SCR *sp, FREF *frp, char *name)
+{
+	fref_remove(sp->gp, frp);
+	free(frp->name);
+	frp->name = name;
+	(void)fref_insert(sp, frp);
+}
+
+/*
+ * fref_hash --
+ *	Hash a file name (FNV-1a).
+ */
+static u_int32_t
+fref_hash(const char *name)
+{
+	u_int32_t h;
+
+	for (h = 2166136261U; *name != '\0'; ++name)
+		h = (h ^ (u_char)*name) * 16777619U;
+	return (h);
+}
+
+/*
+ * fref_insert --
+ *	Add a named FREF to the name index, growing the table as needed.
+ */
+static int
+fref_insert(SCR *sp, FREF *frp)
+{
+	GS *gp;
+	FREF **nh, *next, *tfrp;
+	size_t i, nsize, slot;
+
+	gp = sp->gp;
+	if (frp->name == NULL)
+		return (0);
+
+	/*
+	 * Double the table when it fills up.  If we can't, keep the old
+	 * one, the chains only get longer.
+	 */
+	if (gp->frefh == NULL || gp->frefh_cnt >= gp->frefh_size) {
+		nsize = gp->frefh == NULL ? FREFH_SIZE : gp->frefh_size * 2;
+		if ((nh = calloc(nsize, sizeof(FREF *))) != NULL) {
+			for (i = 0; i < gp->frefh_size; ++i)
+				for (tfrp = gp->frefh[i];
+				    tfrp != NULL; tfrp = next) {
+					next = tfrp->hnext;
+					slot = fref_hash(tfrp->name) & (nsize - 1);
+					tfrp->hnext = nh[slot];
+					nh[slot] = tfrp;
+				}
+			free(gp->frefh);
+			gp->frefh = nh;
+			gp->frefh_size = nsize;
+		} else if (gp->frefh == NULL) {
+			msgq(sp, M_SYSERR, NULL);
+			return (1);
+		}
+	}
+
+	slot = fref_hash(frp->name) & (gp->frefh_size - 1);
+	frp->hnext = gp->frefh[slot];
+	gp->frefh[slot] = frp;
+	++gp->frefh_cnt;
+	return (0);
+}
+
+/*
+ * fref_remove --
+ *	Remove a FREF from the name index.
+ */
+static void
+fref_remove(GS *gp, FREF *frp)
+{
+	FREF **fpp;
+
+	if (frp->name == NULL || gp->frefh == NULL)
+		return;
+	for (fpp = &gp->frefh[fref_hash(frp->name) & (gp->frefh_size - 1)];
+	    *fpp != NULL; fpp = &(*fpp)->hnext)
+		if (*fpp == frp) {
+			*fpp = frp->hnext;
+			frp->hnext = NULL;
+			--gp->frefh_cnt;
+			break;
+		}
+}
+
 /*
  * file_init --
  *	Start editing a file, based on the FREF structure.  If successsful,
@@ -121,7 +239,7 @@ file_init(SCR *sp, FREF *frp, char *rcv_name, int flags)
 	struct stat sb;
 	size_t psize;
 	int fd, exists, open_err, readonly;
-	char *oname, *tname;
+	char *oname, *p, *tname;
 
 	open_err = readonly = 0;
 
@@ -143,6 +261,23 @@ file_init(SCR *sp, FREF *frp, char *rcv_name, int flags)
 	 */
 	F_CLR(frp, ~FR_CURSORSET);
 
+	/*
+	 * Scan the user's path to find the file that we're going to
+	 * try and open.
+	 */
+	if (file_spath(sp, frp, &sb, &exists))
+		return (1);
+
+	/*
+	 * If the file was edited recently and hasn't changed since, pick
+	 * up where we left it.
+	 */
+	if (exists && rcv_name == NULL && !LF_ISSET(FS_OPENERR) &&
+	    (ep = file_cache_get(sp, &sb)) != NULL) {
+		oname = frp->name;
+		goto cached;
+	}
+
 	/*
 	 * Required EXF initialization:
 	 *	Flush the line caches.
@@ -154,13 +289,6 @@ file_init(SCR *sp, FREF *frp, char *rcv_name, int flags)
 	ep->rcv_fd = -1;
 	F_SET(ep, F_FIRSTMODIFY);
 
-	/*
-	 * Scan the user's path to find the file that we're going to
-	 * try and open.
-	 */
-	if (file_spath(sp, frp, &sb, &exists))
-		return (1);
-
 	/*
 	 * If no name or backing file, for whatever reason, create a backing
 	 * temporary file, saving the temp file name so we can later unlink
@@ -189,10 +317,11 @@ file_init(SCR *sp, FREF *frp, char *rcv_name, int flags)
 		frp->tname = tname;
 		if (frp->name == NULL) {
 			F_SET(frp, FR_TMPFILE);
-			if ((frp->name = strdup(tname)) == NULL) {
+			if ((p = strdup(tname)) == NULL) {
 				msgq(sp, M_SYSERR, NULL);
 				goto err;
 			}
+			file_setname(sp, frp, p);
 		}
 		oname = frp->tname;
 		psize = 1024;
@@ -239,6 +368,21 @@ file_init(SCR *sp, FREF *frp, char *rcv_name, int flags)
 			    "238|Warning: %s is not a regular file");
 	}
 
+	/*
+	 * In pager mode, existing files are read in place, with neither a
+	 * recovery file nor an undo log.
+	 */
+	if (F_ISSET(sp->gp, G_PAGER) && rcv_name == NULL &&
+	    F_ISSET(ep, F_DEVSET) && S_ISREG(sb.st_mode)) {
+		F_SET(ep, F_NOLOG | F_PAGER);
+		if ((ep->db = pager_open(oname)) == NULL) {
+			msgq_str(sp, M_SYSERR, oname, "%s");
+			open_err = 1;
+			goto oerr;
+		}
+		goto paged;
+	}
+
 	/* Set up recovery. */
 	oinfo.bval = '\n';			/* Always set. */
 	oinfo.psize = psize;
@@ -275,11 +419,20 @@ file_init(SCR *sp, FREF *frp, char *rcv_name, int flags)
 		goto oerr;
 	}
 
+	/*
+	 * Pick up the line count from the file's line offset index.  A
+	 * snapshot reads all of the file now, there's nothing to save.
+	 */
+paged:	if (rcv_name == NULL && F_ISSET(ep, F_DEVSET) && S_ISREG(sb.st_mode) &&
+	    (F_ISSET(ep, F_PAGER) || !F_ISSET(sp->gp, G_SNAPSHOT)))
+		lidx_init(sp, ep, oname, sb.st_size);
+
 	/*
 	 * Do the remaining things that can cause failure of the new file,
 	 * mark and logging initialization.
 	 */
-	if (mark_init(sp, ep) || log_init(sp, ep))
+	if (mark_init(sp, ep) ||
+	    (!F_ISSET(ep, F_NOLOG) && log_init(sp, ep)))
 		goto err;
 
 	/*
@@ -291,7 +444,7 @@ file_init(SCR *sp, FREF *frp, char *rcv_name, int flags)
 	 * happen in historical vi as the result of the initial command, i.e.
 	 * if vi was executed without a file name.
 	 */
-	if (LF_ISSET(FS_SETALT))
+cached:	if (LF_ISSET(FS_SETALT))
 		set_alt_name(sp, sp->frp == NULL ||
 		    F_ISSET(sp->frp, FR_TMPFILE) ? NULL : sp->frp->name);
 
@@ -421,8 +574,8 @@ file_init(SCR *sp, FREF *frp, char *rcv_name, int flags)
 
 	return (0);
 
-err:	free(frp->name);
-	frp->name = NULL;
+err:	file_setname(sp, frp, NULL);
+	sp->gp->fref_noname = 1;
 	if (frp->tname != NULL) {
 		(void)unlink(frp->tname);
 		free(frp->tname);
@@ -504,10 +657,8 @@ file_spath(SCR *sp, FREF *frp, struct stat *sbp, int *existsp)
 		}
 
 	/* If we found it, build a new pathname and discard the old one. */
-	if (found) {
-		free(frp->name);
-		frp->name = path;
-	}
+	if (found)
+		file_setname(sp, frp, path);
 	*existsp = found;
 	return (0);
 }
@@ -674,12 +825,24 @@ file_end(SCR *sp, EXF *ep, int force)
 		frp->tname = NULL;
 		if (F_ISSET(frp, FR_TMPFILE)) {
 			TAILQ_REMOVE(sp->gp->frefq, frp, q);
+			fref_remove(sp->gp, frp);
 			free(frp->name);
 			free(frp);
 		}
 		sp->frp = NULL;
 	}
 
+	/*
+	 * Keep the EXF of an unmodified file around, in case we come back.
+	 * If the screen is going away, discard any EXF's still being kept.
+	 */
+	if (F_ISSET(sp, SC_EXIT | SC_EXIT_FORCE)) {
+		if (TAILQ_FIRST(sp->gp->dq) == sp &&
+		    TAILQ_NEXT(sp, q) == NULL && TAILQ_EMPTY(sp->gp->hq))
+			file_cache_end(sp);
+	} else if (!force && sp->frp != NULL && !file_cache_add(sp, ep))
+		return (0);
+
 	/*
 	 * Clean up the EXF structure.
 	 *
@@ -692,7 +855,17 @@ file_end(SCR *sp, EXF *ep, int force)
 	}
 
 	/* COMMITTED TO THE CLOSE.  THERE'S NO GOING BACK... */
+	file_exf_free(sp, ep);
+	return (0);
+}
 
+/*
+ * file_exf_free --
+ *	Discard an EXF structure whose db structure has been closed.
+ */
+static void
+file_exf_free(SCR *sp, EXF *ep)
+{
 	/* Stop logging. */
 	(void)log_end(sp, ep);
 
@@ -711,8 +884,13 @@ file_end(SCR *sp, EXF *ep, int force)
 	if (!F_ISSET(ep, F_RCV_NORM)) {
 		if (ep->rcv_path != NULL && unlink(ep->rcv_path))
 			msgq_str(sp, M_SYSERR, ep->rcv_path, "242|%s: remove");
-		if (ep->rcv_mpath != NULL && unlink(ep->rcv_mpath))
-			msgq_str(sp, M_SYSERR, ep->rcv_mpath, "243|%s: remove");
+		if (ep->rcv_mpath != NULL) {
+			if (unlink(ep->rcv_mpath))
+				msgq_str(sp, M_SYSERR,
+				    ep->rcv_mpath, "243|%s: remove");
+			else
+				rcv_idxdel(sp, ep->rcv_mpath);
+		}
 	}
 	if (ep->rcv_fd != -1)
 		(void)close(ep->rcv_fd);
@@ -720,11 +898,172 @@ file_end(SCR *sp, EXF *ep, int force)
 	free(ep->rcv_mpath);
 	if (ep->c_blen > 0)
 		free(ep->c_lp);
+	vs_wc_end(ep);
+	v_mi_end(ep);
+	v_pi_end(ep);
+	lidx_end(ep);
+	fol_end(ep);
 
 	free(ep);
+}
+
+/*
+ * file_cache_add --
+ *	Keep a closed, unmodified file for reuse, returning 0 if it was
+ *	kept.  The least recently used files are discarded to stay within
+ *	the filecache option.
+ */
+static int
+file_cache_add(SCR *sp, EXF *ep)
+{
+	GS *gp;
+	EXF *nep, *tep;
+	int fd;
+
+	/*
+	 * Only files that are exactly what's on disk are kept: no temporary
+	 * files, and nothing that was modified since it was read or written.
+	 */
+	gp = sp->gp;
+	if (O_VAL(sp, O_FILECACHE) == 0 || !F_ISSET(ep, F_DEVSET) ||
+	    F_ISSET(ep, F_MODIFIED | F_RCV_NORM))
+		return (1);
+
+	/*
+	 * A file that was modified and then written has a recovery mail
+	 * file, but nothing to recover.  Remove it, recovery starts over
+	 * with the next change.
+	 */
+	if (ep->rcv_mpath != NULL) {
+		if (unlink(ep->rcv_mpath))
+			msgq_str(sp, M_SYSERR, ep->rcv_mpath, "243|%s: remove");
+		free(ep->rcv_mpath);
+		ep->rcv_mpath = NULL;
+		if (ep->rcv_fd != -1) {
+			(void)close(ep->rcv_fd);
+			ep->rcv_fd = -1;
+		}
+		F_SET(ep, F_FIRSTMODIFY);
+	}
+
+	/* Let other editors lock the file while we're not editing it. */
+	if (O_ISSET(sp, O_LOCKFILES) && (fd = ep->db->fd(ep->db)) != -1)
+		(void)flock(fd, LOCK_UN);
+
+	/*
+	 * Editing a file that's still open, :e of the current file, reads a
+	 * new copy.  Don't keep two of them.
+	 */
+	TAILQ_FOREACH_SAFE(tep, gp->exfq, q, nep) {
+		if (tep->mdev != ep->mdev || tep->minode != ep->minode)
+			continue;
+		TAILQ_REMOVE(gp->exfq, tep, q);
+		--gp->exf_cnt;
+		if (tep->db->close != NULL)
+			(void)tep->db->close(tep->db);
+		file_exf_free(sp, tep);
+	}
+
+	TAILQ_INSERT_HEAD(gp->exfq, ep, q);
+	for (++gp->exf_cnt; gp->exf_cnt > O_VAL(sp, O_FILECACHE);) {
+		tep = TAILQ_LAST(gp->exfq, _exfh);
+		TAILQ_REMOVE(gp->exfq, tep, q);
+		--gp->exf_cnt;
+		if (tep->db->close != NULL)
+			(void)tep->db->close(tep->db);
+		file_exf_free(sp, tep);
+	}
 	return (0);
 }
 
+/*
+ * file_cache_get --
+ *	Return the kept EXF for a file, if it hasn't changed since.
+ */
+static EXF *
+file_cache_get(SCR *sp, struct stat *sbp)
+{
+	GS *gp;
+	EXF *ep;
+
+	gp = sp->gp;
+	TAILQ_FOREACH(ep, gp->exfq, q)
+		if (ep->mdev == sbp->st_dev && ep->minode == sbp->st_ino)
+			break;
+	if (ep == NULL)
+		return (NULL);
+	TAILQ_REMOVE(gp->exfq, ep, q);
+	--gp->exf_cnt;
+
+#if defined HAVE_STRUCT_STAT_ST_MTIMESPEC
+	if (timespeccmp(&sbp->st_mtimespec, &ep->mtim, ==))
+#elif defined HAVE_STRUCT_STAT_ST_MTIM
+	if (timespeccmp(&sbp->st_mtim, &ep->mtim, ==))
+#else
+	if (sbp->st_mtime == ep->mtim.tv_sec)
+#endif
+		return (ep);
+
+	if (ep->db->close != NULL)
+		(void)ep->db->close(ep->db);
+	file_exf_free(sp, ep);
+	return (NULL);
+}
+
+/*
+ * file_cache_end --
+ *	Discard all kept files.
+ *
+ * PUBLIC: void file_cache_end(SCR *);
+ */
+void
+file_cache_end(SCR *sp)
+{
+	GS *gp;
+	EXF *ep;
+
+	gp = sp->gp;
+	while ((ep = TAILQ_FIRST(gp->exfq)) != NULL) {
+		TAILQ_REMOVE(gp->exfq, ep, q);
+		if (ep->db->close != NULL)
+			(void)ep->db->close(ep->db);
+		file_exf_free(sp, ep);
+	}
+	gp->exf_cnt = 0;
+}
+
+/*
+ * file_prefetch --
+ *	Ask the system to start reading the next file in the argument
+ *	list, so that moving to it doesn't wait for the disk.
+ *
+ * PUBLIC: void file_prefetch(SCR *);
+ */
+void
+file_prefetch(SCR *sp)
+{
+#ifdef HAVE_POSIX_FADVISE
+	struct stat sb;
+	off_t len;
+	int fd;
+
+	if (O_VAL(sp, O_PREFETCH) == 0 ||
+	    sp->cargv == NULL || sp->cargv[0] == NULL || sp->cargv[1] == NULL)
+		return;
+
+	/* Opening a device or a FIFO can have side effects, don't. */
+	if (stat(sp->cargv[1], &sb) || !S_ISREG(sb.st_mode))
+		return;
+	if ((fd = open(sp->cargv[1], O_RDONLY | O_NONBLOCK)) == -1)
+		return;
+	len = (off_t)O_VAL(sp, O_PREFETCH) * 1024;
+	if (len > sb.st_size)
+		len = sb.st_size;
+	(void)posix_fadvise(fd, 0, len, POSIX_FADV_WILLNEED);
+	(void)close(fd);
+#endif
+}
+
 /*
  * file_write --
  *	Write the file to disk.  Historic vi had fairly convoluted
@@ -769,6 +1108,16 @@ file_write(SCR *sp, MARK *fm, MARK *tm, char *name, int flags)
 		return (1);
 	}
 
+	/*
+	 * A paged file is read in place, it can't be written while it's
+	 * being read.
+	 */
+	if (F_ISSET(ep, F_PAGER) && !stat(name, &sb) &&
+	    sb.st_dev == ep->mdev && sb.st_ino == ep->minode) {
+		msgq_str(sp, M_ERR, name, "330|%s is being paged, not written");
+		return (1);
+	}
+
 	/* If not forced, not appending, and "writeany" not set ... */
 	if (!LF_ISSET(FS_FORCE | FS_APPEND) && !O_ISSET(sp, O_WRITEANY)) {
 		/* Don't overwrite anything but the original file. */
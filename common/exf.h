@@ -12,6 +12,7 @@
  *	The file structure.
  */
 struct _exf {
+	TAILQ_ENTRY(_exf) q;		/* Linked list of cached EXF's. */
 	int	 refcnt;		/* Reference count. */
 
 					/* Underlying database state. */
@@ -21,6 +22,11 @@ struct _exf {
 	size_t	 c_blen;		/* Cached line buffer length. */
 	recno_t	 c_lno;			/* Cached line number. */
 	recno_t	 c_nlines;		/* Cached lines in the file. */
+	void	*wcache;		/* Vi line width cache. */
+	void	*mindex;		/* Vi bracket depth index. */
+	void	*pindex;		/* Vi paragraph and section index. */
+	void	*lindex;		/* Line offset index. */
+	void	*follow;		/* Followed file state. */
 
 	DB	*log;			/* Log db structure. */
 	char	*l_lp;			/* Log buffer. */
@@ -51,10 +57,11 @@ struct _exf {
 #define	F_MODIFIED	0x004		/* File is currently dirty. */
 #define	F_MULTILOCK	0x008		/* Multiple processes running, lock. */
 #define	F_NOLOG		0x010		/* Logging turned off. */
-#define	F_RCV_NORM	0x020		/* Don't delete recovery files. */
-#define	F_RCV_ON	0x040		/* Recovery is possible. */
-#define	F_UNDO		0x080		/* No change since last undo. */
-	u_int8_t flags;
+#define	F_PAGER		0x020		/* File is being paged. */
+#define	F_RCV_NORM	0x040		/* Don't delete recovery files. */
+#define	F_RCV_ON	0x080		/* Recovery is possible. */
+#define	F_UNDO		0x100		/* No change since last undo. */
+	u_int16_t flags;
 };
 
 /* Flags to db_get(). */
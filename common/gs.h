@@ -20,6 +20,7 @@
  */
 struct _fref {
 	TAILQ_ENTRY(_fref) q;		/* Linked list of file references. */
+	FREF	*hnext;			/* Hash chain of file references. */
 	char	*name;			/* File name. */
 	char	*tname;			/* Backing temporary file name. */
 
@@ -63,6 +64,14 @@ struct _gs {
 
 					/* File references. */
 	TAILQ_HEAD(_frefh, _fref) frefq[1];
+	FREF	**frefh;		/* File references hashed by name. */
+	size_t	 frefh_size;		/* Hash table size, a power of 2. */
+	size_t	 frefh_cnt;		/* Hashed file references. */
+	int	 fref_noname;		/* If references lost their names. */
+
+					/* Closed, unmodified files. */
+	TAILQ_HEAD(_exfh, _exf) exfq[1];
+	u_long	 exf_cnt;		/* Number of cached files. */
 
 #define	GO_COLUMNS	0		/* Global options: columns. */
 #define	GO_LINES	1		/* Global options: lines. */
@@ -95,6 +104,10 @@ struct _gs {
 	FILE	*tracefp;		/* Trace file pointer. */
 #endif
 
+	STATS	 stats;			/* Performance counters. */
+	POOL	 pool[P_NTYPES];	/* Object pools. */
+	TRRING	 tr;			/* Trace ring. */
+
 	EVENT	*i_event;		/* Array of input events. */
 	size_t	 i_nelem;		/* Number of array elements. */
 	size_t	 i_cnt;			/* Count of events. */
@@ -129,13 +142,15 @@ struct _gs {
 /* Flags. */
 #define	G_ABBREV	0x0001		/* If have abbreviations. */
 #define	G_BELLSCHED	0x0002		/* Bell scheduled. */
-#define	G_INTERRUPTED	0x0004		/* Interrupted. */
-#define	G_RECOVER_SET	0x0008		/* Recover system initialized. */
-#define	G_SCRIPTED	0x0010		/* Ex script session. */
-#define	G_SCRWIN	0x0020		/* Scripting windows running. */
-#define	G_SNAPSHOT	0x0040		/* Always snapshot files. */
-#define	G_SRESTART	0x0080		/* Screen restarted. */
-#define	G_TMP_INUSE	0x0100		/* Temporary buffer in use. */
+#define	G_FOLLOW	0x0004		/* Files being followed. */
+#define	G_INTERRUPTED	0x0008		/* Interrupted. */
+#define	G_PAGER		0x0010		/* Page existing files in place. */
+#define	G_RECOVER_SET	0x0020		/* Recover system initialized. */
+#define	G_SCRIPTED	0x0040		/* Ex script session. */
+#define	G_SCRWIN	0x0080		/* Scripting windows running. */
+#define	G_SNAPSHOT	0x0100		/* Always snapshot files. */
+#define	G_SRESTART	0x0200		/* Screen restarted. */
+#define	G_TMP_INUSE	0x0400		/* Temporary buffer in use. */
 	u_int32_t flags;
 
 	/* Screen interface functions. */
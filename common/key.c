@@ -579,6 +579,16 @@ loop:		if (gp->scr_event(sp, argp,
 		case E_TIMEOUT:
 			istimeout = 1;
 			break;
+		case E_CHARACTER:
+		case E_STRING:
+			/* Time the key until the screen is refreshed. */
+			STAT_INC(sp, keys);
+			if (F_ISSET(sp, SC_VI) && gp->stats.key_start == 0)
+				gp->stats.key_start = stats_now();
+			TR_EVENT(sp, TR_KEY, TR_INSTANT,
+			    argp->e_event == E_STRING ?
+			    argp->e_csp[0] : argp->e_c);
+			goto append;
 		case E_INTERRUPT:
 			/* Set the global interrupt flag. */
 			F_SET(sp->gp, G_INTERRUPTED);
@@ -634,8 +644,10 @@ newmap:	evp = &gp->i_event[gp->i_next];
 		goto nomap;
 
 	/* Search the map. */
+	TR_EVENT(sp, TR_MAP, TR_BEGIN, evp->e_c);
 	qp = seq_find(sp, NULL, evp, NULL, gp->i_cnt,
 	    LF_ISSET(EC_MAPCOMMAND) ? SEQ_COMMAND : SEQ_INPUT, &ispartial);
+	TR_EVENT(sp, TR_MAP, TR_END, qp != NULL);
 
 	/*
 	 * If get a partial match, get more characters and retry the map.
@@ -11,9 +11,11 @@
 
 #ifdef USE_WIDECHAR
 #define FILE2INT5(sp,buf,n,nlen,w,wlen)					    \
-    sp->conv.file2int(sp, n, nlen, &buf, &wlen, &w)
+    (STAT_ADD(sp, file2int, nlen),					    \
+    sp->conv.file2int(sp, n, nlen, &buf, &wlen, &w))
 #define INT2FILE(sp,w,wlen,n,nlen) 					    \
-    sp->conv.int2file(sp, w, wlen, &sp->cw, &nlen, &n)
+    (STAT_ADD(sp, int2file, wlen),					    \
+    sp->conv.int2file(sp, w, wlen, &sp->cw, &nlen, &n))
 #define CHAR2INT5(sp,buf,n,nlen,w,wlen)					    \
     sp->conv.sys2int(sp, n, nlen, &buf, &wlen, &w)
 #define INT2CHAR(sp,w,wlen,n,nlen) 					    \
@@ -26,9 +28,9 @@
 #define CAN_PRINT(sp, ch)   (XCHAR_WIDTH(sp, ch) > 0)
 #else
 #define FILE2INT5(sp,buf,n,nlen,w,wlen) \
-    (w = n, wlen = nlen, 0)
+    (STAT_ADD(sp, file2int, nlen), w = n, wlen = nlen, 0)
 #define INT2FILE(sp,w,wlen,n,nlen) \
-    (n = w, nlen = wlen, 0)
+    (STAT_ADD(sp, int2file, wlen), n = w, nlen = wlen, 0)
 #define CHAR2INT5(sp,buf,n,nlen,w,wlen) \
     (w = n, wlen = nlen, 0)
 #define INT2CHAR(sp,w,wlen,n,nlen) \
@@ -22,6 +22,13 @@
 #include "common.h"
 #include "../vi/vi.h"
 
+static int db_encode(SCR *, CHAR_T *, size_t, DBT *);
+#ifdef USE_WIDECHAR
+static int db_iswide(DBT *);
+#endif
+static int db_binsert(SCR *, recno_t, recno_t);
+static int scr_block(SCR *, recno_t, lnop_t, recno_t);
+static int scr_move(SCR *, recno_t, recno_t, recno_t);
 static int scr_update(SCR *, recno_t, lnop_t, int);
 
 /*
@@ -121,6 +128,7 @@ db_get(SCR *sp,
 				*lenp = tp->len;
 			if (pp != NULL)
 				*pp = tp->lb;
+			STAT_INC(sp, db_hit);
 			return (0);
 		}
 		/*
@@ -140,14 +148,18 @@ db_get(SCR *sp,
 			*lenp = ep->c_len;
 		if (pp != NULL)
 			*pp = ep->c_lp;
+		STAT_INC(sp, db_hit);
 		return (0);
 	}
 	ep->c_lno = OOBLNO;
 
 nocache:
+	STAT_INC(sp, db_miss);
+
 	/* Get the line from the underlying database. */
 	key.data = &lno;
 	key.size = sizeof(lno);
+	STAT_INC(sp, rec_get);
 	switch (ep->db->get(ep->db, &key, &data, 0)) {
 	case -1:
 		goto err2;
@@ -162,6 +174,18 @@ err3:		if (lenp != NULL)
 		return (1);
 	}
 
+#ifdef USE_WIDECHAR
+	/*
+	 * Lines kept in the internal form only have to be copied, the
+	 * record isn't necessarily aligned for a CHAR_T.
+	 */
+	if (db_iswide(&data)) {
+		wlen = data.size / sizeof(CHAR_T) - 1;
+		BINC_GOTOW(sp, ep->c_lp, ep->c_blen, wlen);
+		memcpy(ep->c_lp, data.data, wlen * sizeof(CHAR_T));
+		goto cached;
+	}
+#endif
 	if (FILE2INT(sp, data.data, data.size, wp, wlen)) {
 		if (!F_ISSET(sp, SC_CONV_ERROR)) {
 			F_SET(sp, SC_CONV_ERROR);
@@ -176,6 +200,21 @@ err3:		if (lenp != NULL)
 		MEMCPY(ep->c_lp, wp, wlen);
 	} else
 		ep->c_lp = data.data;
+
+#ifdef USE_WIDECHAR
+	/*
+	 * If the widestore option is set, replace the record with the
+	 * decoded line so it's never converted again.  This isn't a
+	 * change to the file, it's neither logged nor does it make the
+	 * file dirty.  Failure only costs us the next conversion.
+	 */
+	if (O_ISSET(sp, O_WIDESTORE) && !F_ISSET(ep, F_PAGER) &&
+	    !db_encode(sp, ep->c_lp, wlen, &data)) {
+		STAT_INC(sp, rec_put);
+		(void)ep->db->put(ep->db, &key, &data, 0);
+	}
+cached:
+#endif
 	ep->c_lno = lno;
 	ep->c_len = wlen;
 
@@ -209,6 +248,8 @@ db_delete(SCR *sp, recno_t lno)
 		ex_emsg(sp, NULL, EXM_NOFILEYET);
 		return (1);
 	}
+	if (db_paged(sp))
+		return (1);
 		
 	/* Update marks, @ and global commands. */
 	if (mark_insdel(sp, LINE_DELETE, lno))
@@ -222,6 +263,7 @@ db_delete(SCR *sp, recno_t lno)
 	/* Update file. */
 	key.data = &lno;
 	key.size = sizeof(lno);
+	STAT_INC(sp, rec_del);
 	if (ep->db->del(ep->db, &key, 0) == 1) {
 		msgq(sp, M_SYSERR,
 		    "003|unable to delete line %lu", (u_long)lno);
@@ -233,11 +275,15 @@ db_delete(SCR *sp, recno_t lno)
 		ep->c_lno = OOBLNO;
 	if (ep->c_nlines != OOBLNO)
 		--ep->c_nlines;
+	vs_wc_change(sp, lno, LINE_DELETE);
+	v_mi_change(sp, lno, LINE_DELETE);
+	v_pi_change(sp, lno, LINE_DELETE);
 
 	/* File now modified. */
 	if (F_ISSET(ep, F_FIRSTMODIFY))
 		(void)rcv_init(sp);
 	F_SET(ep, F_MODIFIED);
+	lidx_end(ep);
 
 	/* Update screen. */
 	return (scr_update(sp, lno, LINE_DELETE, 1));
@@ -254,8 +300,6 @@ db_append(SCR *sp, int update, recno_t lno, CHAR_T *p, size_t len)
 {
 	DBT data, key;
 	EXF *ep;
-	char *fp;
-	size_t flen;
 	int rval;
 
 #if defined(DEBUG) && 0
@@ -266,14 +310,16 @@ db_append(SCR *sp, int update, recno_t lno, CHAR_T *p, size_t len)
 		ex_emsg(sp, NULL, EXM_NOFILEYET);
 		return (1);
 	}
+	if (db_paged(sp))
+		return (1);
 		
-	INT2FILE(sp, p, len, fp, flen);
+	if (db_encode(sp, p, len, &data))
+		return (1);
 
 	/* Update file. */
 	key.data = &lno;
 	key.size = sizeof(lno);
-	data.data = fp;
-	data.size = flen;
+	STAT_INC(sp, rec_put);
 	if (ep->db->put(ep->db, &key, &data, R_IAFTER) == -1) {
 		msgq(sp, M_SYSERR,
 		    "004|unable to append to line %lu", (u_long)lno);
@@ -285,11 +331,15 @@ db_append(SCR *sp, int update, recno_t lno, CHAR_T *p, size_t len)
 		ep->c_lno = OOBLNO;
 	if (ep->c_nlines != OOBLNO)
 		++ep->c_nlines;
+	vs_wc_change(sp, lno, LINE_APPEND);
+	v_mi_change(sp, lno, LINE_APPEND);
+	v_pi_change(sp, lno, LINE_APPEND);
 
 	/* File now dirty. */
 	if (F_ISSET(ep, F_FIRSTMODIFY))
 		(void)rcv_init(sp);
 	F_SET(ep, F_MODIFIED);
+	lidx_end(ep);
 
 	/* Log change. */
 	log_line(sp, lno + 1, LOG_LINE_APPEND);
@@ -325,8 +375,6 @@ db_insert(SCR *sp, recno_t lno, CHAR_T *p, size_t len)
 {
 	DBT data, key;
 	EXF *ep;
-	char *fp;
-	size_t flen;
 	int rval;
 
 #if defined(DEBUG) && 0
@@ -338,14 +386,16 @@ db_insert(SCR *sp, recno_t lno, CHAR_T *p, size_t len)
 		ex_emsg(sp, NULL, EXM_NOFILEYET);
 		return (1);
 	}
+	if (db_paged(sp))
+		return (1);
 		
-	INT2FILE(sp, p, len, fp, flen);
+	if (db_encode(sp, p, len, &data))
+		return (1);
 		
 	/* Update file. */
 	key.data = &lno;
 	key.size = sizeof(lno);
-	data.data = fp;
-	data.size = flen;
+	STAT_INC(sp, rec_put);
 	if (ep->db->put(ep->db, &key, &data, R_IBEFORE) == -1) {
 		msgq(sp, M_SYSERR,
 		    "005|unable to insert at line %lu", (u_long)lno);
@@ -357,11 +407,15 @@ db_insert(SCR *sp, recno_t lno, CHAR_T *p, size_t len)
 		ep->c_lno = OOBLNO;
 	if (ep->c_nlines != OOBLNO)
 		++ep->c_nlines;
+	vs_wc_change(sp, lno, LINE_INSERT);
+	v_mi_change(sp, lno, LINE_INSERT);
+	v_pi_change(sp, lno, LINE_INSERT);
 
 	/* File now dirty. */
 	if (F_ISSET(ep, F_FIRSTMODIFY))
 		(void)rcv_init(sp);
 	F_SET(ep, F_MODIFIED);
+	lidx_end(ep);
 
 	/* Log change. */
 	log_line(sp, lno, LOG_LINE_INSERT);
@@ -388,8 +442,6 @@ db_set(SCR *sp, recno_t lno, CHAR_T *p, size_t len)
 {
 	DBT data, key;
 	EXF *ep;
-	char *fp;
-	size_t flen;
 
 #if defined(DEBUG) && 0
 	TRACE(sp, "replace line %lu: len %lu {%.*s}\n",
@@ -400,17 +452,19 @@ db_set(SCR *sp, recno_t lno, CHAR_T *p, size_t len)
 		ex_emsg(sp, NULL, EXM_NOFILEYET);
 		return (1);
 	}
+	if (db_paged(sp))
+		return (1);
 		
 	/* Log before change. */
 	log_line(sp, lno, LOG_LINE_RESET_B);
 
-	INT2FILE(sp, p, len, fp, flen);
+	if (db_encode(sp, p, len, &data))
+		return (1);
 
 	/* Update file. */
 	key.data = &lno;
 	key.size = sizeof(lno);
-	data.data = fp;
-	data.size = flen;
+	STAT_INC(sp, rec_put);
 	if (ep->db->put(ep->db, &key, &data, 0) == -1) {
 		msgq(sp, M_SYSERR,
 		    "006|unable to store line %lu", (u_long)lno);
@@ -420,11 +474,15 @@ db_set(SCR *sp, recno_t lno, CHAR_T *p, size_t len)
 	/* Flush the cache, before logging or screen update. */
 	if (lno == ep->c_lno)
 		ep->c_lno = OOBLNO;
+	vs_wc_change(sp, lno, LINE_RESET);
+	v_mi_change(sp, lno, LINE_RESET);
+	v_pi_change(sp, lno, LINE_RESET);
 
 	/* File now dirty. */
 	if (F_ISSET(ep, F_FIRSTMODIFY))
 		(void)rcv_init(sp);
 	F_SET(ep, F_MODIFIED);
+	lidx_end(ep);
 
 	/* Log after change. */
 	log_line(sp, lno, LOG_LINE_RESET_F);
@@ -433,6 +491,407 @@ db_set(SCR *sp, recno_t lno, CHAR_T *p, size_t len)
 	return (scr_update(sp, lno, LINE_RESET, 1));
 }
 
+/*
+ * db_bappend --
+ *	Append the lines of a TEXT list into the file as a single block.
+ *
+ * PUBLIC: int db_bappend(SCR *, recno_t, TEXTH *, recno_t *);
+ */
+int
+db_bappend(SCR *sp, recno_t lno, TEXTH *tqp, recno_t *cntp)
+{
+	DBT data;
+	TEXT *tp;
+	recno_t cnt;
+	size_t blen, len;
+	int rval;
+	char *bp;
+
+	/* Check for no underlying file. */
+	if (sp->ep == NULL) {
+		ex_emsg(sp, NULL, EXM_NOFILEYET);
+		return (1);
+	}
+
+	/*
+	 * Build the database records, each preceded by its length.  The
+	 * same buffer is the body of the log record.
+	 */
+	GET_SPACE_RETC(sp, bp, blen, 256);
+	cnt = 0;
+	len = 0;
+	TAILQ_FOREACH(tp, tqp, q) {
+		if (db_encode(sp, tp->lb, tp->len, &data))
+			goto err;
+		ADD_SPACE_GOTOC(sp, bp, blen, len + sizeof(size_t) + data.size);
+		memmove(bp + len, &data.size, sizeof(size_t));
+		memmove(bp + len + sizeof(size_t), data.data, data.size);
+		len += sizeof(size_t) + data.size;
+		++cnt;
+	}
+
+	rval = cnt == 0 ? 0 : db_rappend(sp, lno, cnt, bp, len);
+	if (cntp != NULL)
+		*cntp = cnt;
+	FREE_SPACE(sp, bp, blen);
+	return (rval);
+
+alloc_err:
+err:	FREE_SPACE(sp, bp, blen);
+	return (1);
+}
+
+/*
+ * db_rappend --
+ *	Append a block of raw, length prefixed, records into the file.
+ *
+ * PUBLIC: int db_rappend(SCR *, recno_t, recno_t, char *, size_t);
+ */
+int
+db_rappend(SCR *sp, recno_t lno, recno_t cnt, char *p, size_t len)
+{
+	DBT data, key;
+	EXF *ep;
+	recno_t cur, n;
+	size_t off;
+
+	/* Check for no underlying file. */
+	if ((ep = sp->ep) == NULL) {
+		ex_emsg(sp, NULL, EXM_NOFILEYET);
+		return (1);
+	}
+	if (db_paged(sp))
+		return (1);
+
+	/* Update file. */
+	key.data = &cur;
+	key.size = sizeof(cur);
+	for (off = 0, cur = lno, n = cnt; n > 0; --n, ++cur) {
+		memmove(&data.size, p + off, sizeof(size_t));
+		data.data = p + off + sizeof(size_t);
+		off += sizeof(size_t) + data.size;
+		STAT_INC(sp, rec_put);
+		if (ep->db->put(ep->db, &key, &data, R_IAFTER) == -1) {
+			msgq(sp, M_SYSERR,
+			    "004|unable to append to line %lu", (u_long)cur);
+			return (1);
+		}
+	}
+
+	/* Log change. */
+	log_block(sp, LOG_BLOCK_APPEND, lno, cnt, 0, p, len);
+
+	return (db_binsert(sp, lno + 1, cnt));
+}
+
+/*
+ * db_bcopy --
+ *	Copy a block of cnt lines starting at fl after line tl.
+ *
+ * PUBLIC: int db_bcopy(SCR *, recno_t, recno_t, recno_t);
+ */
+int
+db_bcopy(SCR *sp, recno_t fl, recno_t cnt, recno_t tl)
+{
+	DBT data, key;
+	EXF *ep;
+	recno_t i, lno;
+	size_t blen;
+	char *bp;
+
+	/* Check for no underlying file. */
+	if ((ep = sp->ep) == NULL) {
+		ex_emsg(sp, NULL, EXM_NOFILEYET);
+		return (1);
+	}
+	if (db_paged(sp))
+		return (1);
+
+	/*
+	 * The records are copied as they are, without conversion.  It's
+	 * possible to copy a block into itself, source lines after tl are
+	 * pushed down by the lines already copied.
+	 */
+	GET_SPACE_RETC(sp, bp, blen, 256);
+	key.size = sizeof(lno);
+	key.data = &lno;
+	for (i = 0; i < cnt; ++i) {
+		lno = fl + i + (fl + i > tl ? i : 0);
+		STAT_INC(sp, rec_get);
+		if (ep->db->get(ep->db, &key, &data, 0) != 0) {
+			db_err(sp, lno);
+			goto err;
+		}
+		BINC_GOTOC(sp, bp, blen, data.size);
+		memmove(bp, data.data, data.size);
+		data.data = bp;
+		lno = tl + i;
+		STAT_INC(sp, rec_put);
+		if (ep->db->put(ep->db, &key, &data, R_IAFTER) == -1) {
+			msgq(sp, M_SYSERR,
+			    "004|unable to append to line %lu", (u_long)lno);
+			goto err;
+		}
+	}
+	FREE_SPACE(sp, bp, blen);
+
+	/* Log change. */
+	log_block(sp, LOG_BLOCK_COPY, fl, cnt, tl, NULL, 0);
+
+	return (db_binsert(sp, tl + 1, cnt));
+
+alloc_err:
+err:	FREE_SPACE(sp, bp, blen);
+	return (1);
+}
+
+/*
+ * db_bmove --
+ *	Move a block of cnt lines starting at fl after line tl, which may
+ *	not be inside the block.
+ *
+ * PUBLIC: int db_bmove(SCR *, recno_t, recno_t, recno_t);
+ */
+int
+db_bmove(SCR *sp, recno_t fl, recno_t cnt, recno_t tl)
+{
+	DBT data, key;
+	EXF *ep;
+	recno_t first, lno, n;
+	size_t blen;
+	int rval;
+	char *bp;
+
+	/* Check for no underlying file. */
+	if ((ep = sp->ep) == NULL) {
+		ex_emsg(sp, NULL, EXM_NOFILEYET);
+		return (1);
+	}
+	if (db_paged(sp))
+		return (1);
+
+	/*
+	 * Move the records one at a time, in the same order ex_move() used
+	 * to move the lines, so the global command ranges come out the same.
+	 */
+	GET_SPACE_RETC(sp, bp, blen, 256);
+	key.size = sizeof(lno);
+	key.data = &lno;
+	rval = 0;
+	for (n = 0; n < cnt; ++n) {
+		lno = tl > fl ? fl : fl + n;
+		STAT_INC(sp, rec_get);
+		if (ep->db->get(ep->db, &key, &data, 0) != 0) {
+			db_err(sp, lno);
+			goto err;
+		}
+		BINC_GOTOC(sp, bp, blen, data.size);
+		memmove(bp, data.data, data.size);
+		data.data = bp;
+		lno = tl > fl ? tl : tl + n;
+		STAT_INC(sp, rec_put);
+		if (ep->db->put(ep->db, &key, &data, R_IAFTER) == -1) {
+			msgq(sp, M_SYSERR,
+			    "004|unable to append to line %lu", (u_long)lno);
+			goto err;
+		}
+		lno = tl > fl ? fl : fl + n + 1;
+		STAT_INC(sp, rec_del);
+		if (ep->db->del(ep->db, &key, 0) == 1) {
+			msgq(sp, M_SYSERR,
+			    "003|unable to delete line %lu", (u_long)lno);
+			goto err;
+		}
+		if (ex_g_insdel(sp,
+		    LINE_INSERT, tl > fl ? tl + 1 : tl + n + 1) ||
+		    ex_g_insdel(sp, LINE_DELETE, lno))
+			rval = 1;
+	}
+	FREE_SPACE(sp, bp, blen);
+
+	/* Flush the caches, the line count doesn't change. */
+	first = tl > fl ? fl : tl + 1;
+	ep->c_lno = OOBLNO;
+	vs_wc_change(sp, first, LINE_INSERT);
+	v_mi_change(sp, first, LINE_INSERT);
+	v_pi_change(sp, first, LINE_INSERT);
+
+	/* File now dirty. */
+	if (F_ISSET(ep, F_FIRSTMODIFY))
+		(void)rcv_init(sp);
+	F_SET(ep, F_MODIFIED);
+	lidx_end(ep);
+
+	/* Log change. */
+	log_block(sp, LOG_BLOCK_MOVE, fl, cnt, tl, NULL, 0);
+
+	/* Update marks. */
+	mark_move(sp, fl, cnt, tl);
+
+	/* Update screen. */
+	return (scr_move(sp, fl, cnt, tl) || rval);
+
+alloc_err:
+err:	FREE_SPACE(sp, bp, blen);
+	return (1);
+}
+
+/*
+ * db_bmove_lno --
+ *	Return the number of line lno after a block of cnt lines at fl
+ *	was moved after tl.
+ *
+ * PUBLIC: recno_t db_bmove_lno(recno_t, recno_t, recno_t, recno_t);
+ */
+recno_t
+db_bmove_lno(recno_t lno, recno_t fl, recno_t cnt, recno_t tl)
+{
+	if (tl > fl) {
+		if (lno >= fl && lno < fl + cnt)
+			return (lno + tl - (fl + cnt - 1));
+		if (lno >= fl + cnt && lno <= tl)
+			return (lno - cnt);
+	} else {
+		if (lno >= fl && lno < fl + cnt)
+			return (lno - (fl - (tl + 1)));
+		if (lno > tl && lno < fl)
+			return (lno + cnt);
+	}
+	return (lno);
+}
+
+/*
+ * db_bdelete --
+ *	Delete a block of cnt lines starting at lno.
+ *
+ * PUBLIC: int db_bdelete(SCR *, recno_t, recno_t);
+ */
+int
+db_bdelete(SCR *sp, recno_t lno, recno_t cnt)
+{
+	DBT key;
+	EXF *ep;
+	recno_t n;
+
+	/* Check for no underlying file. */
+	if ((ep = sp->ep) == NULL) {
+		ex_emsg(sp, NULL, EXM_NOFILEYET);
+		return (1);
+	}
+	if (db_paged(sp))
+		return (1);
+
+	/* Update marks, @ and global commands. */
+	if (mark_block(sp, LINE_DELETE, lno, cnt))
+		return (1);
+	for (n = cnt; n > 0; --n)
+		if (ex_g_insdel(sp, LINE_DELETE, lno))
+			return (1);
+
+	/* Log and update file. */
+	key.data = &lno;
+	key.size = sizeof(lno);
+	for (n = cnt; n > 0; --n) {
+		log_line(sp, lno, LOG_LINE_DELETE);
+		STAT_INC(sp, rec_del);
+		if (ep->db->del(ep->db, &key, 0) == 1) {
+			msgq(sp, M_SYSERR,
+			    "003|unable to delete line %lu", (u_long)lno);
+			return (1);
+		}
+
+		/* The next line is logged from the cache, flush it. */
+		ep->c_lno = OOBLNO;
+	}
+
+	/* Update line count, before screen update. */
+	if (ep->c_nlines != OOBLNO)
+		ep->c_nlines -= cnt;
+	vs_wc_change(sp, lno, LINE_DELETE);
+	v_mi_change(sp, lno, LINE_DELETE);
+	v_pi_change(sp, lno, LINE_DELETE);
+
+	/* File now modified. */
+	if (F_ISSET(ep, F_FIRSTMODIFY))
+		(void)rcv_init(sp);
+	F_SET(ep, F_MODIFIED);
+	lidx_end(ep);
+
+	/* Update screen. */
+	return (scr_block(sp, lno, LINE_DELETE, cnt));
+}
+
+/*
+ * db_bpermute --
+ *	Replace a block of cnt lines starting at lno with ncnt of its
+ *	lines, in the order given by an array of offsets into the block.
+ *
+ * PUBLIC: int db_bpermute(SCR *, recno_t, recno_t, recno_t *, recno_t);
+ */
+int
+db_bpermute(SCR *sp, recno_t lno, recno_t cnt, recno_t *perm, recno_t ncnt)
+{
+	DBT data, key;
+	EXF *ep;
+	recno_t cur, i;
+	size_t blen, len, nlen, *off;
+	int rval;
+	char *bp, *nbp;
+
+	/* Check for no underlying file. */
+	if ((ep = sp->ep) == NULL) {
+		ex_emsg(sp, NULL, EXM_NOFILEYET);
+		return (1);
+	}
+	if (db_paged(sp))
+		return (1);
+
+	/*
+	 * The records are read in order, random reads from the DB are slow,
+	 * and copied as they are, without conversion, into a block appended
+	 * after the lines.  Then the lines are deleted.  See db_rappend()
+	 * for the block format.
+	 */
+	bp = nbp = NULL;
+	blen = 0;
+	MALLOC_RET(sp, off, (cnt + 1) * sizeof(size_t));
+	key.data = &cur;
+	key.size = sizeof(cur);
+	for (len = 0, i = 0; i < cnt; ++i) {
+		cur = lno + i;
+		STAT_INC(sp, rec_get);
+		if (ep->db->get(ep->db, &key, &data, 0) != 0) {
+			db_err(sp, cur);
+			goto err;
+		}
+		BINC_GOTOC(sp, bp, blen, len + data.size);
+		memmove(bp + len, data.data, data.size);
+		off[i] = len;
+		len += data.size;
+	}
+	off[cnt] = len;
+
+	MALLOC_GOTO(sp, nbp, len + ncnt * sizeof(size_t));
+	for (nlen = 0, i = 0; i < ncnt; ++i) {
+		len = off[perm[i] + 1] - off[perm[i]];
+		memmove(nbp + nlen, &len, sizeof(size_t));
+		memmove(nbp + nlen + sizeof(size_t), bp + off[perm[i]], len);
+		nlen += sizeof(size_t) + len;
+	}
+	free(bp);
+	free(off);
+
+	rval = ncnt != 0 && db_rappend(sp, lno + cnt - 1, ncnt, nbp, nlen);
+	free(nbp);
+	return (rval || db_bdelete(sp, lno, cnt));
+
+alloc_err:
+err:	free(nbp);
+	free(bp);
+	free(off);
+	return (1);
+}
+
 /*
  * db_exist --
  *	Return if a line exists.
@@ -516,6 +975,16 @@ alloc_err:
 	memcpy(&lno, key.data, sizeof(lno));
 
 	if (lno != ep->c_lno) {
+#ifdef USE_WIDECHAR
+		if (db_iswide(&data)) {
+			wlen = data.size / sizeof(CHAR_T) - 1;
+			BINC_GOTOW(sp, ep->c_lp, ep->c_blen, wlen);
+			memcpy(ep->c_lp, data.data, wlen * sizeof(CHAR_T));
+			ep->c_lno = lno;
+			ep->c_len = wlen;
+			goto cached;
+		}
+#endif
 		FILE2INT(sp, data.data, data.size, wp, wlen);
 
 		/* Fill the cache. */
@@ -527,7 +996,11 @@ alloc_err:
 		ep->c_lno = lno;
 		ep->c_len = wlen;
 	}
+#ifdef USE_WIDECHAR
+cached:
+#endif
 	ep->c_nlines = lno;
+	lidx_last(sp, ep, lno);
 
 	/* Return the value. */
 	*lnop = (F_ISSET(sp, SC_TINPUT) &&
@@ -551,17 +1024,41 @@ db_rget(SCR *sp,
 	DBT data, key;
 	EXF *ep = sp->ep;
 	int rval;
+#ifdef USE_WIDECHAR
+	char *fp;
+	size_t flen, wlen;
+#endif
 
 	/* Get the line from the underlying database. */
 	key.data = &lno;
 	key.size = sizeof(lno);
-	if ((rval = ep->db->get(ep->db, &key, &data, 0)) == 0)
-	{
-		*lenp = data.size;
-		*pp = data.data;
-	}
+	STAT_INC(sp, rec_get);
+	if ((rval = ep->db->get(ep->db, &key, &data, 0)) != 0)
+		return (rval);
 
-	return (rval);
+#ifdef USE_WIDECHAR
+	/*
+	 * Lines kept in the internal form are converted back to the file
+	 * encoding, going through the line cache to align the record.
+	 */
+	if (db_iswide(&data)) {
+		wlen = data.size / sizeof(CHAR_T) - 1;
+		BINC_GOTOW(sp, ep->c_lp, ep->c_blen, wlen);
+		memcpy(ep->c_lp, data.data, wlen * sizeof(CHAR_T));
+		ep->c_lno = lno;
+		ep->c_len = wlen;
+		if (INT2FILE(sp, ep->c_lp, wlen, fp, flen))
+			return (-1);
+		*lenp = flen;
+		*pp = fp;
+		return (0);
+alloc_err:
+		return (-1);
+	}
+#endif
+	*lenp = data.size;
+	*pp = data.data;
+	return (0);
 }
 
 /*
@@ -581,9 +1078,30 @@ db_rset(SCR *sp, recno_t lno, char *p, size_t len)
 	key.size = sizeof(lno);
 	data.data = p;
 	data.size = len;
+	vs_wc_change(sp, lno, LINE_RESET);
+	v_mi_change(sp, lno, LINE_RESET);
+	v_pi_change(sp, lno, LINE_RESET);
+	STAT_INC(sp, rec_put);
 	return ep->db->put(ep->db, &key, &data, 0);
 }
 
+/*
+ * db_paged --
+ *	Complain and return 1 if the file is being paged, and so can't be
+ *	changed.  Errno is set for callers that report system errors.
+ *
+ * PUBLIC: int db_paged(SCR *);
+ */
+int
+db_paged(SCR *sp)
+{
+	if (sp->ep == NULL || !F_ISSET(sp->ep, F_PAGER))
+		return (0);
+	msgq(sp, M_ERR, "329|File is being paged, it can't be changed");
+	errno = EROFS;
+	return (1);
+}
+
 /*
  * db_err --
  *	Report a line error.
@@ -597,6 +1115,58 @@ db_err(SCR *sp, recno_t lno)
 	    "008|Error: unable to retrieve line %lu", (u_long)lno);
 }
 
+/*
+ * db_encode --
+ *	Build the database record for a line.  If the widestore option is
+ *	set, the line is kept in the internal form, tagged by a trailing
+ *	CHAR_T of newline bytes, which never appear in a line read from
+ *	the file.
+ */
+static int
+db_encode(SCR *sp, CHAR_T *p, size_t len, DBT *data)
+{
+	char *fp;
+	size_t flen;
+
+#ifdef USE_WIDECHAR
+	if (O_ISSET(sp, O_WIDESTORE)) {
+		flen = (len + 1) * sizeof(CHAR_T);
+		BINC_RETC(sp, sp->cw.bp1.c, sp->cw.blen1, flen);
+		memcpy(sp->cw.bp1.c, p, len * sizeof(CHAR_T));
+		memset(sp->cw.bp1.c + len * sizeof(CHAR_T), '\n',
+		    sizeof(CHAR_T));
+		data->data = sp->cw.bp1.c;
+		data->size = flen;
+		return (0);
+	}
+#endif
+	INT2FILE(sp, p, len, fp, flen);
+	data->data = fp;
+	data->size = flen;
+	return (0);
+}
+
+#ifdef USE_WIDECHAR
+/*
+ * db_iswide --
+ *	Return if a record holds a line in the internal form.
+ */
+static int
+db_iswide(DBT *data)
+{
+	char *p;
+	size_t n;
+
+	if (data->size < sizeof(CHAR_T) || data->size % sizeof(CHAR_T))
+		return (0);
+	p = (char *)data->data + data->size - sizeof(CHAR_T);
+	for (n = sizeof(CHAR_T); n > 0; --n)
+		if (*p++ != '\n')
+			return (0);
+	return (1);
+}
+#endif
+
 /*
  * scr_update --
  *	Update all of the screens that are backed by the file that
@@ -619,3 +1189,90 @@ scr_update(SCR *sp, recno_t lno, lnop_t op, int current)
 					return (1);
 	return (current ? vs_change(sp, lno, op) : 0);
 }
+
+/*
+ * db_binsert --
+ *	Update everything that depends on the line numbers after a block
+ *	of cnt lines was inserted at lno.
+ */
+static int
+db_binsert(SCR *sp, recno_t lno, recno_t cnt)
+{
+	EXF *ep;
+	recno_t n;
+	int rval;
+
+	ep = sp->ep;
+
+	/* Flush the cache, update line count, before screen update. */
+	if (lno <= ep->c_lno)
+		ep->c_lno = OOBLNO;
+	if (ep->c_nlines != OOBLNO)
+		ep->c_nlines += cnt;
+	vs_wc_change(sp, lno, LINE_INSERT);
+	v_mi_change(sp, lno, LINE_INSERT);
+	v_pi_change(sp, lno, LINE_INSERT);
+
+	/* File now dirty. */
+	if (F_ISSET(ep, F_FIRSTMODIFY))
+		(void)rcv_init(sp);
+	F_SET(ep, F_MODIFIED);
+	lidx_end(ep);
+
+	/* Update marks, @ and global commands. */
+	rval = 0;
+	if (mark_block(sp, LINE_INSERT, lno, cnt))
+		rval = 1;
+	for (n = 0; n < cnt; ++n)
+		if (ex_g_insdel(sp, LINE_INSERT, lno + n))
+			rval = 1;
+
+	/* Update screen. */
+	return (scr_block(sp, lno, LINE_INSERT, cnt) || rval);
+}
+
+/*
+ * scr_block --
+ *	Update all of the screens that are backed by the file that
+ *	just changed, for a block of lines.
+ */
+static int
+scr_block(SCR *sp, recno_t lno, lnop_t op, recno_t cnt)
+{
+	EXF *ep;
+	SCR *tsp;
+
+	if (F_ISSET(sp, SC_EX))
+		return (0);
+
+	ep = sp->ep;
+	if (ep->refcnt != 1)
+		TAILQ_FOREACH(tsp, sp->gp->dq, q)
+			if (sp != tsp && tsp->ep == ep)
+				if (vs_change_block(tsp, lno, op, cnt))
+					return (1);
+	return (vs_change_block(sp, lno, op, cnt));
+}
+
+/*
+ * scr_move --
+ *	Update all of the screens that are backed by the file that
+ *	just changed, for a block of lines that was moved.
+ */
+static int
+scr_move(SCR *sp, recno_t fl, recno_t cnt, recno_t tl)
+{
+	EXF *ep;
+	SCR *tsp;
+
+	if (F_ISSET(sp, SC_EX))
+		return (0);
+
+	ep = sp->ep;
+	if (ep->refcnt != 1)
+		TAILQ_FOREACH(tsp, sp->gp->dq, q)
+			if (sp != tsp && tsp->ep == ep)
+				if (vs_change_move(tsp, fl, cnt, tl))
+					return (1);
+	return (vs_change_move(sp, fl, cnt, tl));
+}
@@ -0,0 +1,404 @@
+/*-
+ * Copyright (c) 2026
+ *	The nvi2 contributors.  All rights reserved.
+ *
+ * See the LICENSE file for redistribution information.
+ */
+
+#include "config.h"
+
+#include <sys/types.h>
+#include <sys/queue.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+
+#include <bitstring.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "common.h"
+
+/*
+ * Line offset index.
+ *
+ * Counting the lines of a large file means reading all of it, and the DB
+ * layer does that the first time anything asks for the last line, e.g. a
+ * ^G status message.  If the lineindex option is set, the byte offset of
+ * every lineindex'th line of a large file is saved the first time all of
+ * the file is read, in the file "lines.<uid>.<dev>.<inode>" in the recovery
+ * directory.  The next time the file is edited, if its size and
+ * modification time match, the line count is taken from the index, and
+ * :goto maps a byte offset to a line by reading only the part of the file
+ * between two indexed lines.
+ *
+ * The index describes the file as it is on disk, and is discarded on the
+ * first change to the file's lines.  A saved index that no longer matches
+ * its file is removed when it's read, and the recover script removes the
+ * rest at boot.
+ *
+ * The index only helps when the DB layer reads the file as it's needed,
+ * i.e. when the file is paged (-P) or isn't snapshotted (-F).  Otherwise
+ * all of the file is read when it's opened, and the line count costs
+ * nothing.
+ */
+#define	LIDX_MAGIC	"nvilidx1"
+#define	LIDX_MINSIZE	(1024 * 1024)	/* Smallest file worth indexing. */
+#define	LIDX_BUFSIZE	(64 * 1024)	/* Scan buffer size. */
+
+typedef struct {
+	char	 magic[8];		/* LIDX_MAGIC. */
+	uint64_t dev;			/* Device. */
+	uint64_t ino;			/* Inode. */
+	uint64_t size;			/* File size. */
+	uint64_t sec;			/* Last modification time. */
+	uint64_t nsec;
+	uint64_t nlines;		/* Lines in the file. */
+	uint64_t step;			/* Lines between offsets. */
+	uint64_t noff;			/* Number of offsets. */
+} LIDXHDR;
+
+typedef struct {
+	char	*name;			/* File name. */
+	LIDXHDR	 hdr;			/* File key, index if built. */
+	uint64_t *off;			/* Offsets of lines 1, 1 + step, ... */
+} LIDX;
+
+#define	LXP(ep)	((LIDX *)((ep)->lindex))
+
+static int	 lidx_fopen(LIDX *);
+static char	*lidx_path(SCR *, LIDX *);
+static int	 lidx_read(SCR *, LIDX *);
+static void	 lidx_write(SCR *, LIDX *);
+
+/*
+ * lidx_init --
+ *	Set up the line offset index of a newly opened file, and take
+ *	the line count from it if the saved index is still good.
+ *
+ * PUBLIC: void lidx_init(SCR *, EXF *, char *, off_t);
+ */
+void
+lidx_init(SCR *sp, EXF *ep, char *name, off_t size)
+{
+	LIDX *lp;
+
+	if (O_VAL(sp, O_LINEINDEX) == 0 || size < LIDX_MINSIZE ||
+	    opts_empty(sp, O_RECDIR, 1))
+		return;
+
+	if ((lp = calloc(1, sizeof(LIDX))) == NULL)
+		return;
+	if ((lp->name = strdup(name)) == NULL) {
+		free(lp);
+		return;
+	}
+	memcpy(lp->hdr.magic, LIDX_MAGIC, sizeof(lp->hdr.magic));
+	lp->hdr.dev = ep->mdev;
+	lp->hdr.ino = ep->minode;
+	lp->hdr.size = size;
+	lp->hdr.sec = ep->mtim.tv_sec;
+	lp->hdr.nsec = ep->mtim.tv_nsec;
+	ep->lindex = lp;
+
+	if (!lidx_read(sp, lp))
+		ep->c_nlines = lp->hdr.nlines;
+}
+
+/*
+ * lidx_end --
+ *	Discard the line offset index, the file is changing.
+ *
+ * PUBLIC: void lidx_end(EXF *);
+ */
+void
+lidx_end(EXF *ep)
+{
+	LIDX *lp;
+
+	if ((lp = LXP(ep)) == NULL)
+		return;
+	free(lp->name);
+	free(lp->off);
+	free(lp);
+	ep->lindex = NULL;
+}
+
+/*
+ * lidx_last --
+ *	All of the file has been read and has nlines lines; build and save
+ *	the index if the file wants one.
+ *
+ * PUBLIC: void lidx_last(SCR *, EXF *, recno_t);
+ */
+void
+lidx_last(SCR *sp, EXF *ep, recno_t nlines)
+{
+	LIDX *lp;
+	uint64_t *off, nl, pos, step;
+	size_t aoff, noff;
+	ssize_t nr;
+	int fd;
+	char *bp, *p, *t, last;
+
+	if ((lp = LXP(ep)) == NULL || lp->off != NULL)
+		return;
+	if ((fd = lidx_fopen(lp)) == -1) {
+		lidx_end(ep);
+		return;
+	}
+
+	if ((step = O_VAL(sp, O_LINEINDEX)) == 0) {
+		(void)close(fd);
+		lidx_end(ep);
+		return;
+	}
+	aoff = nlines / step + 1;
+	off = NULL;
+	if ((bp = malloc(LIDX_BUFSIZE)) == NULL ||
+	    (off = calloc(aoff, sizeof(uint64_t))) == NULL)
+		goto err;
+
+	/*
+	 * Line nl + 1 starts after the nl'th newline, unless that's the end
+	 * of the file.  The last line doesn't need a trailing newline.
+	 */
+	off[0] = 0;
+	noff = 1;
+	nl = 0;
+	last = '\n';
+	for (pos = 0; (nr = read(fd, bp, LIDX_BUFSIZE)) > 0; pos += nr) {
+		for (p = bp, t = bp + nr;
+		    (p = memchr(p, '\n', t - p)) != NULL;) {
+			++p;
+			if (++nl % step != 0 || pos + (p - bp) == lp->hdr.size)
+				continue;
+			if (noff == aoff)
+				goto err;
+			off[noff++] = pos + (p - bp);
+		}
+		last = bp[nr - 1];
+		if (INTERRUPTED(sp))
+			goto err;
+	}
+
+	/* If the file changed underneath the DB layer, forget it. */
+	if (nr != 0 || pos != lp->hdr.size ||
+	    nl + (last != '\n') != nlines)
+		goto err;
+
+	lp->hdr.nlines = nlines;
+	lp->hdr.step = step;
+	lp->hdr.noff = noff;
+	lp->off = off;
+	lidx_write(sp, lp);
+	off = NULL;
+
+err:	(void)close(fd);
+	free(bp);
+	free(off);
+	if (lp->off == NULL)
+		lidx_end(ep);
+}
+
+/*
+ * lidx_offset --
+ *	Return the line holding a byte offset into the file, and the byte's
+ *	offset in the line.  Returns 1 if there's no index to use.
+ *
+ * PUBLIC: int lidx_offset(SCR *, uint64_t, recno_t *, uint64_t *);
+ */
+int
+lidx_offset(SCR *sp, uint64_t byte, recno_t *lnop, uint64_t *colp)
+{
+	LIDX *lp;
+	uint64_t lno, pos, start;
+	size_t hi, lo, mid;
+	ssize_t nr;
+	int fd;
+	char *bp, *p, *t;
+
+	if ((lp = LXP(sp->ep)) == NULL || lp->off == NULL)
+		return (1);
+	if ((fd = lidx_fopen(lp)) == -1) {
+		lidx_end(sp->ep);
+		return (1);
+	}
+	if ((bp = malloc(LIDX_BUFSIZE)) == NULL) {
+		(void)close(fd);
+		return (1);
+	}
+
+	if (byte >= lp->hdr.size)
+		byte = lp->hdr.size - 1;
+	for (lo = 0, hi = lp->hdr.noff; hi - lo > 1;) {
+		mid = lo + (hi - lo) / 2;
+		if (lp->off[mid] <= byte)
+			lo = mid;
+		else
+			hi = mid;
+	}
+	lno = lo * lp->hdr.step + 1;
+	start = pos = lp->off[lo];
+
+	/* Count the newlines between the indexed line and the byte. */
+	if (lseek(fd, (off_t)pos, SEEK_SET) == -1)
+		goto err;
+	while (pos < byte) {
+		if ((nr = read(fd, bp, MIN(LIDX_BUFSIZE, byte - pos))) <= 0)
+			goto err;
+		for (p = bp, t = bp + nr;
+		    (p = memchr(p, '\n', t - p)) != NULL; ++lno)
+			start = pos + (++p - bp);
+		pos += nr;
+	}
+	(void)close(fd);
+	free(bp);
+
+	*lnop = lno;
+	*colp = byte - start;
+	return (0);
+
+err:	(void)close(fd);
+	free(bp);
+	return (1);
+}
+
+/*
+ * lidx_fopen --
+ *	Open the indexed file, if it hasn't changed.
+ */
+static int
+lidx_fopen(LIDX *lp)
+{
+	struct stat sb;
+	int fd;
+
+	if ((fd = open(lp->name, O_RDONLY)) == -1)
+		return (-1);
+	if (fstat(fd, &sb) || (uint64_t)sb.st_dev != lp->hdr.dev ||
+	    (uint64_t)sb.st_ino != lp->hdr.ino ||
+	    (uint64_t)sb.st_size != lp->hdr.size ||
+#if defined HAVE_STRUCT_STAT_ST_MTIMESPEC
+	    (uint64_t)sb.st_mtimespec.tv_sec != lp->hdr.sec ||
+	    (uint64_t)sb.st_mtimespec.tv_nsec != lp->hdr.nsec) {
+#elif defined HAVE_STRUCT_STAT_ST_MTIM
+	    (uint64_t)sb.st_mtim.tv_sec != lp->hdr.sec ||
+	    (uint64_t)sb.st_mtim.tv_nsec != lp->hdr.nsec) {
+#else
+	    (uint64_t)sb.st_mtime != lp->hdr.sec) {
+#endif
+		(void)close(fd);
+		return (-1);
+	}
+	return (fd);
+}
+
+/*
+ * lidx_path --
+ *	Return the name of a file's index; need free.
+ */
+static char *
+lidx_path(SCR *sp, LIDX *lp)
+{
+	char buf[64];
+
+	(void)snprintf(buf, sizeof(buf), "lines.%lu.%jx.%jx",
+	    (u_long)getuid(), (uintmax_t)lp->hdr.dev, (uintmax_t)lp->hdr.ino);
+	return (join(O_STR(sp, O_RECDIR), buf));
+}
+
+/*
+ * lidx_read --
+ *	Read a file's saved index, if it matches the file.
+ */
+static int
+lidx_read(SCR *sp, LIDX *lp)
+{
+	struct stat sb;
+	LIDXHDR hdr;
+	uint64_t *off, cnt;
+	size_t len;
+	int fd;
+	char *path;
+
+	if ((path = lidx_path(sp, lp)) == NULL)
+		return (1);
+	if ((fd = open(path, O_RDONLY | O_NOFOLLOW)) == -1) {
+		free(path);
+		return (1);
+	}
+
+	/*
+	 * The recovery directory is writable by everyone, believe only our
+	 * own index files.
+	 */
+	off = NULL;
+	if (fstat(fd, &sb) || !S_ISREG(sb.st_mode) || sb.st_uid != getuid() ||
+	    read(fd, &hdr, sizeof(hdr)) != sizeof(hdr))
+		goto err;
+
+	/* If the file has changed, the index is no use to anyone. */
+	if (memcmp(&hdr, &lp->hdr, offsetof(LIDXHDR, nlines))) {
+		(void)unlink(path);
+		goto err;
+	}
+	if (hdr.step == 0 || hdr.nlines == 0 || hdr.nlines > MAX_REC_NUMBER ||
+	    hdr.noff != (hdr.nlines - 1) / hdr.step + 1 ||
+	    (uint64_t)sb.st_size != sizeof(hdr) + hdr.noff * sizeof(uint64_t))
+		goto err;
+	len = hdr.noff * sizeof(uint64_t);
+	if ((off = malloc(len)) == NULL || read(fd, off, len) != (ssize_t)len)
+		goto err;
+	for (cnt = 0; cnt < hdr.noff; ++cnt)
+		if (off[cnt] >= hdr.size ||
+		    (cnt == 0 ? off[cnt] != 0 : off[cnt] <= off[cnt - 1]))
+			goto err;
+	(void)close(fd);
+	free(path);
+
+	lp->hdr = hdr;
+	lp->off = off;
+	return (0);
+
+err:	(void)close(fd);
+	free(off);
+	free(path);
+	return (1);
+}
+
+/*
+ * lidx_write --
+ *	Save a file's index.  It's only a hint, so errors are ignored.
+ */
+static void
+lidx_write(SCR *sp, LIDX *lp)
+{
+	size_t len;
+	int fd;
+	char *path, *tpath;
+
+	if ((path = lidx_path(sp, lp)) == NULL)
+		return;
+	if ((tpath = join(O_STR(sp, O_RECDIR), "lines.XXXXXX")) == NULL) {
+		free(path);
+		return;
+	}
+	if ((fd = mkstemp(tpath)) != -1) {
+		len = lp->hdr.noff * sizeof(uint64_t);
+		if (write(fd, &lp->hdr, sizeof(lp->hdr)) != sizeof(lp->hdr) ||
+		    write(fd, lp->off, len) != (ssize_t)len) {
+			(void)close(fd);
+			(void)unlink(tpath);
+		} else if (close(fd) || rename(tpath, path))
+			(void)unlink(tpath);
+	}
+	free(tpath);
+	free(path);
+}
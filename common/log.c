@@ -36,6 +36,9 @@
  *	LOG_LINE_RESET_F	recno_t		char *
  *	LOG_LINE_RESET_B	recno_t		char *
  *	LOG_MARK		LMARK
+ *	LOG_BLOCK_APPEND	recno_t recno_t recno_t	{size_t char *} ...
+ *	LOG_BLOCK_COPY		recno_t recno_t recno_t
+ *	LOG_BLOCK_MOVE		recno_t recno_t recno_t
  *
  * We do before image physical logging.  This means that the editor layer
  * MAY NOT modify records in place, even if simply deleting or overwriting
@@ -43,6 +46,12 @@
  * up lots of space.  This may eventually have to be reduced, probably by
  * doing logical logging, which is a much cooler database phrase.
  *
+ * Block operations are logged that way.  The three line numbers are the
+ * first line, the number of lines and the destination line of the block.
+ * A copy or move doesn't need the text, since the log is rolled in order
+ * and the source lines are always there when it's replayed.  An appended
+ * block carries its lines as the raw database records.
+ *
  * The implementation of the historic vi 'u' command, using roll-forward and
  * roll-back, is simple.  Each set of changes has a LOG_CURSOR_INIT record,
  * followed by a number of other records, followed by a LOG_CURSOR_END record.
@@ -59,6 +68,7 @@
  * behaved that way.
  */
 
+static int	log_block1(SCR *, u_char *, size_t, int);
 static int	log_cursor1(SCR *, int);
 static void	log_err(SCR *, char *, int);
 #if defined(DEBUG) && 0
@@ -191,6 +201,8 @@ log_cursor1(SCR *sp, int type)
 	key.size = sizeof(recno_t);
 	data.data = ep->l_lp;
 	data.size = sizeof(u_char) + sizeof(MARK);
+	STAT_INC(sp, log_recs);
+	STAT_ADD(sp, log_bytes, data.size);
 	if (ep->log->put(ep->log, &key, &data, 0) == -1)
 		LOG_ERR;
 
@@ -269,6 +281,8 @@ log_line(SCR *sp, recno_t lno, u_int action)
 	key.size = sizeof(recno_t);
 	data.data = ep->l_lp;
 	data.size = len * sizeof(CHAR_T) + CHAR_T_OFFSET;
+	STAT_INC(sp, log_recs);
+	STAT_ADD(sp, log_bytes, data.size);
 	if (ep->log->put(ep->log, &key, &data, 0) == -1)
 		LOG_ERR;
 
@@ -302,6 +316,114 @@ log_line(SCR *sp, recno_t lno, u_int action)
 	return (0);
 }
 
+/*
+ * log_block --
+ *	Log a block change.
+ *
+ * PUBLIC: int log_block(SCR *, u_int, recno_t, recno_t, recno_t, char *, size_t);
+ */
+int
+log_block(SCR *sp, u_int action,
+    recno_t lno, recno_t cnt, recno_t tl, char *p, size_t len)
+{
+	DBT data, key;
+	EXF *ep;
+	size_t size;
+
+	ep = sp->ep;
+	if (F_ISSET(ep, F_NOLOG))
+		return (0);
+
+	/* See log_line(). */
+	F_CLR(ep, F_UNDO);
+
+	/* Put out one initial cursor record per set of changes. */
+	if (ep->l_cursor.lno != OOBLNO) {
+		if (log_cursor1(sp, LOG_CURSOR_INIT))
+			return (1);
+		ep->l_cursor.lno = OOBLNO;
+	}
+
+	size = sizeof(u_char) + 3 * sizeof(recno_t);
+	BINC_RETC(sp, ep->l_lp, ep->l_len, size + len);
+	ep->l_lp[0] = action;
+	memmove(ep->l_lp + sizeof(u_char), &lno, sizeof(recno_t));
+	memmove(ep->l_lp + sizeof(u_char) + sizeof(recno_t),
+	    &cnt, sizeof(recno_t));
+	memmove(ep->l_lp + sizeof(u_char) + 2 * sizeof(recno_t),
+	    &tl, sizeof(recno_t));
+	if (len != 0)
+		memmove(ep->l_lp + size, p, len);
+
+	key.data = &ep->l_cur;
+	key.size = sizeof(recno_t);
+	data.data = ep->l_lp;
+	data.size = size + len;
+	STAT_INC(sp, log_recs);
+	STAT_ADD(sp, log_bytes, data.size);
+	if (ep->log->put(ep->log, &key, &data, 0) == -1)
+		LOG_ERR;
+
+#if defined(DEBUG) && 0
+	TRACE(sp, "%lu: log_block: %u: %lu {%lu} %lu\n",
+	    ep->l_cur, action, lno, cnt, tl);
+#endif
+	/* Reset high water mark. */
+	ep->l_high = ++ep->l_cur;
+	return (0);
+}
+
+/*
+ * log_block1 --
+ *	Roll a block change backward or forward.
+ */
+static int
+log_block1(SCR *sp, u_char *p, size_t len, int forward)
+{
+	recno_t cnt, lno, tl;
+	size_t size;
+
+	size = sizeof(u_char) + 3 * sizeof(recno_t);
+	memmove(&lno, p + sizeof(u_char), sizeof(recno_t));
+	memmove(&cnt, p + sizeof(u_char) + sizeof(recno_t), sizeof(recno_t));
+	memmove(&tl, p + sizeof(u_char) + 2 * sizeof(recno_t),
+	    sizeof(recno_t));
+
+	switch (*p) {
+	case LOG_BLOCK_APPEND:
+		tl = lno;
+		/* FALLTHROUGH */
+	case LOG_BLOCK_COPY:
+		if (!forward) {
+			if (db_bdelete(sp, tl + 1, cnt))
+				return (1);
+			sp->rptlines[L_DELETED] += cnt;
+			break;
+		}
+		if (*p == LOG_BLOCK_APPEND ?
+		    db_rappend(sp, lno, cnt, (char *)p + size, len - size) :
+		    db_bcopy(sp, lno, cnt, tl))
+			return (1);
+		sp->rptlines[L_ADDED] += cnt;
+		break;
+	case LOG_BLOCK_MOVE:
+		if (forward) {
+			if (db_bmove(sp, lno, cnt, tl))
+				return (1);
+		} else if (tl > lno) {
+			if (db_bmove(sp, tl - cnt + 1, cnt, lno - 1))
+				return (1);
+		} else
+			if (db_bmove(sp, tl + 1, cnt, lno + cnt - 1))
+				return (1);
+		sp->rptlines[L_MOVED] += cnt;
+		break;
+	default:
+		abort();
+	}
+	return (0);
+}
+
 /*
  * log_mark --
  *	Log a mark position.  For the log to work, we assume that there
@@ -337,6 +459,8 @@ log_mark(SCR *sp, LMARK *lmp)
 	key.size = sizeof(recno_t);
 	data.data = ep->l_lp;
 	data.size = sizeof(u_char) + sizeof(LMARK);
+	STAT_INC(sp, log_recs);
+	STAT_ADD(sp, log_bytes, data.size);
 	if (ep->log->put(ep->log, &key, &data, 0) == -1)
 		LOG_ERR;
 
@@ -428,6 +552,13 @@ log_backward(SCR *sp, MARK *rp)
 				++sp->rptlines[L_CHANGED];
 			}
 			break;
+		case LOG_BLOCK_APPEND:
+		case LOG_BLOCK_COPY:
+		case LOG_BLOCK_MOVE:
+			didop = 1;
+			if (log_block1(sp, p, data.size, 0))
+				goto err;
+			break;
 		case LOG_MARK:
 			didop = 1;
 			memmove(&lm, p + sizeof(u_char), sizeof(LMARK));
@@ -508,6 +639,9 @@ log_setline(SCR *sp)
 		case LOG_LINE_INSERT:
 		case LOG_LINE_DELETE:
 		case LOG_LINE_RESET_F:
+		case LOG_BLOCK_APPEND:
+		case LOG_BLOCK_COPY:
+		case LOG_BLOCK_MOVE:
 			break;
 		case LOG_LINE_RESET_B:
 			memmove(&lno, p + sizeof(u_char), sizeof(recno_t));
@@ -615,6 +749,13 @@ log_forward(SCR *sp, MARK *rp)
 				++sp->rptlines[L_CHANGED];
 			}
 			break;
+		case LOG_BLOCK_APPEND:
+		case LOG_BLOCK_COPY:
+		case LOG_BLOCK_MOVE:
+			didop = 1;
+			if (log_block1(sp, p, data.size, 1))
+				goto err;
+			break;
 		case LOG_MARK:
 			didop = 1;
 			memmove(&lm, p + sizeof(u_char), sizeof(LMARK));
@@ -685,6 +826,12 @@ log_trace(SCR *sp, char *msg, recno_t rno, u_char *p)
 		memmove(&lno, p + sizeof(u_char), sizeof(recno_t));
 		TRACE(sp, "%lu: %s: RESET_B: %lu\n", rno, msg, lno);
 		break;
+	case LOG_BLOCK_APPEND:
+	case LOG_BLOCK_COPY:
+	case LOG_BLOCK_MOVE:
+		memmove(&lno, p + sizeof(u_char), sizeof(recno_t));
+		TRACE(sp, "%lu: %s:   BLOCK: %lu\n", rno, msg, lno);
+		break;
 	case LOG_MARK:
 		memmove(&lm, p + sizeof(u_char), sizeof(LMARK));
 		TRACE(sp,
@@ -16,3 +16,6 @@
 #define	LOG_LINE_RESET_F	6
 #define	LOG_LINE_RESET_B	7
 #define	LOG_MARK		8
+#define	LOG_BLOCK_APPEND	9
+#define	LOG_BLOCK_COPY		10
+#define	LOG_BLOCK_MOVE		11
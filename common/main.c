@@ -69,7 +69,7 @@ editor(GS *gp, int argc, char *argv[])
 
 	/* Structures shared by screens so stored in the GS structure. */
 	TAILQ_INIT(gp->frefq);
-	TAILQ_INIT(gp->dcb_store.textq);
+	TAILQ_INIT(gp->exfq);
 	SLIST_INIT(gp->cutq);
 	SLIST_INIT(gp->seqq);
 
@@ -101,9 +101,9 @@ editor(GS *gp, int argc, char *argv[])
 	F_SET(gp, G_SNAPSHOT);
 
 #ifdef DEBUG
-	while ((ch = getopt(argc, argv, "c:D:eFlRrSsT:t:vw:")) != EOF)
+	while ((ch = getopt(argc, argv, "c:D:eFlPRrSsT:t:vw:")) != EOF)
 #else
-	while ((ch = getopt(argc, argv, "c:eFlRrSst:vw:")) != EOF)
+	while ((ch = getopt(argc, argv, "c:eFlPRrSst:vw:")) != EOF)
 #endif
 		switch (ch) {
 		case 'c':		/* Run the command. */
@@ -142,6 +142,10 @@ editor(GS *gp, int argc, char *argv[])
 		case 'l':		/* Set lisp, showmatch options. */
 			lflag = 1;
 			break;
+		case 'P':		/* Pager mode. */
+			F_SET(gp, G_PAGER);
+			readonly = 1;
+			break;
 		case 'R':		/* Readonly. */
 			readonly = 1;
 			break;
@@ -357,6 +361,7 @@ editor(GS *gp, int argc, char *argv[])
 
 		if (file_init(sp, frp, NULL, 0))
 			goto err;
+		file_prefetch(sp);
 		if (EXCMD_RUNNING(gp)) {
 			(void)ex_cmd(sp);
 			if (F_ISSET(sp, SC_EXIT | SC_EXIT_FORCE)) {
@@ -443,6 +448,7 @@ v_end(GS *gp)
 			free(frp->tname);
 			free(frp);
 		}
+		free(gp->frefh);
 	}
 
 	/* Free key input queue. */
@@ -451,12 +457,12 @@ v_end(GS *gp)
 	/* Free cut buffers. */
 	cut_close(gp);
 
+	/* Free object pools. */
+	pool_close(gp);
+
 	/* Free map sequences. */
 	seq_close(gp);
 
-	/* Free default buffer storage. */
-	(void)text_lfree(gp->dcb_store.textq);
-
 	/* Close message catalogs. */
 	msg_close(gp);
 #endif
@@ -255,3 +255,68 @@ mark_insdel(SCR *sp, lnop_t op, recno_t lno)
 	}
 	return (0);
 }
+
+/*
+ * mark_block --
+ *	Update the marks for a block of cnt lines inserted or deleted
+ *	at lno.
+ *
+ * PUBLIC: int mark_block(SCR *, lnop_t, recno_t, recno_t);
+ */
+int
+mark_block(SCR *sp, lnop_t op, recno_t lno, recno_t cnt)
+{
+	LMARK *lmp;
+	recno_t lline;
+
+	switch (op) {
+	case LINE_APPEND:
+		/* All insert/append operations are done as inserts. */
+		abort();
+	case LINE_DELETE:
+		SLIST_FOREACH(lmp, sp->ep->marks, q)
+			if (lmp->lno >= lno) {
+				if (lmp->lno < lno + cnt) {
+					F_SET(lmp, MARK_DELETED);
+					(void)log_mark(sp, lmp);
+				} else
+					lmp->lno -= cnt;
+			}
+		break;
+	case LINE_INSERT:
+		/*
+		 * Same special case as mark_insdel(): if the block is all
+		 * that's in the file, it replaced the empty first line.
+		 */
+		if (!db_exist(sp, cnt + 1)) {
+			if (db_last(sp, &lline))
+				return (1);
+			if (lline == cnt)
+				return (0);
+		}
+
+		SLIST_FOREACH(lmp, sp->ep->marks, q)
+			if (lmp->lno >= lno)
+				lmp->lno += cnt;
+		break;
+	case LINE_RESET:
+		break;
+	}
+	return (0);
+}
+
+/*
+ * mark_move --
+ *	Update the marks for a block of cnt lines at fl moved after tl.
+ *	Marks in the block move with their lines.
+ *
+ * PUBLIC: void mark_move(SCR *, recno_t, recno_t, recno_t);
+ */
+void
+mark_move(SCR *sp, recno_t fl, recno_t cnt, recno_t tl)
+{
+	LMARK *lmp;
+
+	SLIST_FOREACH(lmp, sp->ep->marks, q)
+		lmp->lno = db_bmove_lno(lmp->lno, fl, cnt, tl);
+}
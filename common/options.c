@@ -70,6 +70,8 @@ OPTLIST const optlist[] = {
 	{L("combined"),	NULL,		OPT_0BOOL,	OPT_NOSET|OPT_WC},
 /* O_COMMENT	  4.4BSD */
 	{L("comment"),	NULL,		OPT_0BOOL,	0},
+/* O_DIRECTDRAW */
+	{L("directdraw"),	NULL,		OPT_0BOOL,	0},
 /* O_TMPDIR	    4BSD */
 	{L("directory"),	NULL,		OPT_STR,	0},
 /* O_EDCOMPATIBLE   4BSD */
@@ -82,14 +84,20 @@ OPTLIST const optlist[] = {
 	{L("expandtab"),	NULL,		OPT_0BOOL,	0},
 /* O_EXRC	System V (undocumented) */
 	{L("exrc"),	NULL,		OPT_0BOOL,	0},
+/* O_EXRCCACHE */
+	{L("exrccache"),	NULL,		OPT_0BOOL,	0},
 /* O_EXTENDED	  4.4BSD */
 	{L("extended"),	f_recompile,	OPT_0BOOL,	0},
 /* O_FILEC	  4.4BSD */
 	{L("filec"),	NULL,		OPT_STR,	0},
+/* O_FILECACHE */
+	{L("filecache"),	NULL,		OPT_NUM,	0},
 /* O_FILEENCODING */
 	{L("fileencoding"),f_encoding,	OPT_STR,	OPT_WC},
 /* O_FLASH	    HPUX */
 	{L("flash"),	NULL,		OPT_1BOOL,	0},
+/* O_FOLLOWTIME */
+	{L("followtime"),	NULL,		OPT_NUM,	0},
 /* O_HARDTABS	    4BSD */
 	{L("hardtabs"),	NULL,		OPT_NUM,	0},
 /* O_ICLOWER	  4.4BSD */
@@ -102,6 +110,8 @@ OPTLIST const optlist[] = {
 	{L("keytime"),	NULL,		OPT_NUM,	0},
 /* O_LEFTRIGHT	  4.4BSD */
 	{L("leftright"),	f_reformat,	OPT_0BOOL,	0},
+/* O_LINEINDEX */
+	{L("lineindex"),	NULL,		OPT_NUM,	0},
 /* O_LINES	  4.4BSD */
 	{L("lines"),	f_lines,	OPT_NUM,	OPT_NOSAVE},
 /* O_LISP	    4BSD
@@ -151,6 +161,8 @@ OPTLIST const optlist[] = {
 	{L("paragraphs"),	NULL,		OPT_STR,	OPT_PAIRS},
 /* O_PATH	  4.4BSD */
 	{L("path"),	NULL,		OPT_STR,	0},
+/* O_PREFETCH */
+	{L("prefetch"),	NULL,		OPT_NUM,	0},
 /* O_PRINT	  4.4BSD */
 	{L("print"),	f_print,	OPT_STR,	0},
 /* O_PROMPT	    4BSD */
@@ -200,6 +212,8 @@ OPTLIST const optlist[] = {
  *	and we ignore the option.
  */
 	{L("sourceany"),	NULL,		OPT_0BOOL,	OPT_NOSET},
+/* O_STATSFILE */
+	{L("statsfile"),	NULL,		OPT_STR,	0},
 /* O_TABSTOP	    4BSD */
 	{L("tabstop"),	f_reformat,	OPT_NUM,	OPT_NOZERO},
 /* O_TAGLENGTH	    4BSD */
@@ -218,6 +232,8 @@ OPTLIST const optlist[] = {
 	{L("tildeop"),	NULL,		OPT_0BOOL,	0},
 /* O_TIMEOUT	    4BSD (undocumented) */
 	{L("timeout"),	NULL,		OPT_1BOOL,	0},
+/* O_TRACEEVENTS */
+	{L("traceevents"),	f_traceevents,	OPT_NUM,	OPT_NOSAVE},
 /* O_TTYWERASE	  4.4BSD */
 	{L("ttywerase"),	f_ttywerase,	OPT_0BOOL,	0},
 /* O_VERBOSE	  4.4BSD */
@@ -230,6 +246,8 @@ OPTLIST const optlist[] = {
 	{L("w9600"),	f_w9600,	OPT_NUM,	OPT_NDISP|OPT_NOSAVE},
 /* O_WARN	    4BSD */
 	{L("warn"),	NULL,		OPT_1BOOL,	0},
+/* O_WIDESTORE */
+	{L("widestore"),	NULL,		OPT_0BOOL,	OPT_WC},
 /* O_WINDOW	    4BSD */
 	{L("window"),	f_window,	OPT_NUM,	0},
 /* O_WINDOWNAME	    4BSD */
@@ -358,6 +376,7 @@ opts_init(SCR *sp, int *oargs)
 	    L("directory=%s"), (s = getenv("TMPDIR")) == NULL ? _PATH_TMP : s);
 	OI(O_ESCAPETIME, L("escapetime=6"));
 	OI(O_FILEC, L("filec=\t"));
+	OI(O_FOLLOWTIME, L("followtime=5"));
 	OI(O_KEYTIME, L("keytime=6"));
 	OI(O_MATCHCHARS, L("matchchars=()[]{}"));
 	OI(O_MATCHTIME, L("matchtime=7"));
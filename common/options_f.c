@@ -23,6 +23,7 @@
 #include <unistd.h>
 
 #include "common.h"
+#include "../vi/vi.h"
 
 /*
  * PUBLIC: int f_altwerase(SCR *, OPTION *, char *, u_long *);
@@ -144,6 +145,7 @@ f_msgcat(SCR *sp, OPTION *op, char *str, u_long *valp)
 int
 f_print(SCR *sp, OPTION *op, char *str, u_long *valp)
 {
+	SCR *tsp;
 	int offset = op - sp->opts;
 
 	/* Preset the value, needed for reinitialization of lookup table. */
@@ -158,6 +160,14 @@ f_print(SCR *sp, OPTION *op, char *str, u_long *valp)
 	/* Reinitialize the key fast lookup table. */
 	v_key_ilookup(sp);
 
+	/* Character widths may have changed, toss the line width caches. */
+	TAILQ_FOREACH(tsp, sp->gp->dq, q)
+		if (tsp->ep != NULL)
+			vs_wc_end(tsp->ep);
+	TAILQ_FOREACH(tsp, sp->gp->hq, q)
+		if (tsp->ep != NULL)
+			vs_wc_end(tsp->ep);
+
 	/* Reformat the screen. */
 	F_SET(sp, SC_SCR_REFORMAT);
 	return (0);
@@ -207,6 +217,15 @@ f_reformat(SCR *sp, OPTION *op, char *str, u_long *valp)
 	return (0);
 }
 
+/*
+ * PUBLIC: int f_traceevents(SCR *, OPTION *, char *, u_long *);
+ */
+int
+f_traceevents(SCR *sp, OPTION *op, char *str, u_long *valp)
+{
+	return (trace_size(sp, *valp));
+}
+
 /*
  * PUBLIC: int f_ttywerase(SCR *, OPTION *, char *, u_long *);
  */
@@ -289,5 +308,11 @@ f_encoding(SCR *sp, OPTION *op, char *str, u_long *valp)
 {
 	int offset = op - sp->opts;
 
-	return conv_enc(sp, offset, str);
+	if (conv_enc(sp, offset, str))
+		return (1);
+
+	/* The lines decode differently, toss the line width cache. */
+	if (sp->ep != NULL)
+		vs_wc_end(sp->ep);
+	return (0);
 }
@@ -0,0 +1,380 @@
+/*-
+ * Copyright (c) 2026
+ *	The nvi2 contributors.  All rights reserved.
+ *
+ * See the LICENSE file for redistribution information.
+ */
+
+#include "config.h"
+
+#include <sys/types.h>
+#include <sys/queue.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+
+#include <bitstring.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "common.h"
+
+/*
+ * Pager mode.
+ *
+ * The DB_RECNO layer copies a file before it can be edited, into memory
+ * or into the recovery backing file.  When paging through a file (the -P
+ * option), existing files are read in place instead, using a read-only
+ * DB of our own.  The DB reads the file a window at a time, keeping only
+ * the byte offset of every PG_STEP'th line, found as the file is read.  A
+ * line is found by reading forward from the closest known offset, or from
+ * the last line returned, as most access is to nearby lines.
+ *
+ * There's no recovery file and no undo log, and the lines can't be changed,
+ * see db_paged().  The file is read as it was when opened, if it grows the
+ * new lines aren't seen, if it shrinks the missing lines are errors.
+ */
+#define	PG_STEP		1024		/* Lines between saved offsets. */
+#define	PG_WINDOW	(256 * 1024)	/* Minimum read window. */
+
+typedef struct {
+	int	 fd;			/* File descriptor. */
+	off_t	 size;			/* File size when opened. */
+
+	off_t	*off;			/* Offsets of lines 1, 1 + PG_STEP, ... */
+	size_t	 noff;			/* Known offsets. */
+	size_t	 aoff;			/* Allocated offsets. */
+	recno_t	 s_lno;			/* Scan: next line. */
+	off_t	 s_off;			/* Scan: next line's offset. */
+	recno_t	 nlines;		/* Lines, if the scan finished. */
+	int	 eof;			/* The scan finished. */
+
+	size_t	 b_blk;			/* Block of lines being read. */
+	off_t	 b_off[PG_STEP];	/* Block: line offsets. */
+	size_t	 b_cnt;			/* Block: known line offsets. */
+
+	char	*wp;			/* Window buffer. */
+	size_t	 wblen;			/* Window buffer length. */
+	off_t	 woff;			/* Window offset in the file. */
+	size_t	 wlen;			/* Window length. */
+} PAGER;
+
+static int	pg_close(DB *);
+static int	pg_del(const DB *, const DBT *, u_int);
+static int	pg_fd(const DB *);
+static int	pg_get(const DB *, const DBT *, DBT *, u_int);
+static int	pg_line(PAGER *, off_t, char **, size_t *);
+static int	pg_put(const DB *, DBT *, const DBT *, u_int);
+static int	pg_read(PAGER *, off_t, size_t, char **, size_t *);
+static int	pg_scan(PAGER *, recno_t);
+static int	pg_seq(const DB *, DBT *, DBT *, u_int);
+static int	pg_sync(const DB *, u_int);
+
+/*
+ * pager_open --
+ *	Open a file for paging, returning a read-only DB_RECNO look-alike.
+ *
+ * PUBLIC: DB *pager_open(char *);
+ */
+DB *
+pager_open(char *name)
+{
+	struct stat sb;
+	DB *dbp;
+	PAGER *pp;
+	int fd;
+
+	if ((fd = open(name, O_RDONLY | O_NONBLOCK)) == -1)
+		return (NULL);
+	if (fstat(fd, &sb)) {
+		(void)close(fd);
+		return (NULL);
+	}
+	if ((dbp = calloc(1, sizeof(DB))) == NULL ||
+	    (pp = calloc(1, sizeof(PAGER))) == NULL) {
+		free(dbp);
+		(void)close(fd);
+		errno = ENOMEM;
+		return (NULL);
+	}
+	pp->fd = fd;
+	pp->size = sb.st_size;
+	pp->s_lno = 1;
+
+	dbp->type = DB_RECNO;
+	dbp->close = pg_close;
+	dbp->del = pg_del;
+	dbp->fd = pg_fd;
+	dbp->get = pg_get;
+	dbp->put = pg_put;
+	dbp->seq = pg_seq;
+	dbp->sync = pg_sync;
+	dbp->internal = pp;
+	return (dbp);
+}
+
+/*
+ * pg_get --
+ *	Return a line.
+ */
+static int
+pg_get(const DB *dbp, const DBT *key, DBT *data, u_int flags)
+{
+	PAGER *pp;
+	recno_t lno;
+	off_t off;
+	size_t blk, len, n;
+	char *p;
+
+	pp = dbp->internal;
+	memcpy(&lno, key->data, sizeof(lno));
+	if (lno == 0 || (pp->eof && lno > pp->nlines))
+		return (1);
+
+	/* Make sure there's an offset to start from. */
+	if ((lno - 1) / PG_STEP >= pp->noff && pg_scan(pp, lno))
+		return (-1);
+	if (pp->eof && lno > pp->nlines)
+		return (1);
+
+	/*
+	 * Lines are read in blocks of PG_STEP, starting at a saved offset.
+	 * Keep the offsets of the lines of the block being read, access in
+	 * either direction is mostly to nearby lines.
+	 */
+	blk = (lno - 1) / PG_STEP;
+	if (pp->b_cnt == 0 || pp->b_blk != blk) {
+		pp->b_blk = blk;
+		pp->b_off[0] = pp->off[blk];
+		pp->b_cnt = 1;
+	}
+	for (n = (lno - 1) % PG_STEP; pp->b_cnt <= n; ++pp->b_cnt) {
+		off = pp->b_off[pp->b_cnt - 1];
+		if (off >= pp->size)
+			return (1);
+		if (pg_line(pp, off, &p, &len))
+			return (-1);
+		pp->b_off[pp->b_cnt] = off + len + 1;
+	}
+	if (pp->b_off[n] >= pp->size)
+		return (1);
+	if (pg_line(pp, pp->b_off[n], &p, &len))
+		return (-1);
+
+	data->data = p;
+	data->size = len;
+	return (0);
+}
+
+/*
+ * pg_seq --
+ *	Return the last line, the only sequential access there is.
+ */
+static int
+pg_seq(const DB *dbp, DBT *key, DBT *data, u_int flags)
+{
+	static recno_t lno;
+	PAGER *pp;
+
+	pp = dbp->internal;
+	if (flags != R_LAST) {
+		errno = EINVAL;
+		return (-1);
+	}
+	if (pg_scan(pp, OOBLNO))
+		return (-1);
+	if (pp->nlines == 0)
+		return (1);
+	lno = pp->nlines;
+	key->data = &lno;
+	key->size = sizeof(lno);
+	return (pg_get(dbp, key, data, 0));
+}
+
+/*
+ * pg_scan --
+ *	Find the offsets up to line lno, or up to the end of the file.
+ */
+static int
+pg_scan(PAGER *pp, recno_t lno)
+{
+	off_t *off, pos;
+	size_t len;
+	char *p, *s, *t;
+
+	for (pos = pp->s_off; !pp->eof &&
+	    (lno == OOBLNO || (lno - 1) / PG_STEP >= pp->noff);) {
+		/*
+		 * Line s_lno starts at s_off, and is one that has its offset
+		 * saved.
+		 */
+		if ((pp->s_lno - 1) % PG_STEP == 0 && pos == pp->s_off &&
+		    pp->noff == (pp->s_lno - 1) / PG_STEP) {
+			if (pp->noff == pp->aoff) {
+				len = pp->aoff == 0 ? 64 : pp->aoff * 2;
+				if ((off = realloc(pp->off,
+				    len * sizeof(off_t))) == NULL)
+					return (1);
+				pp->off = off;
+				pp->aoff = len;
+			}
+			pp->off[pp->noff++] = pp->s_off;
+			continue;
+		}
+
+		/*
+		 * At the end of the file, the last line doesn't need to
+		 * end in a newline.
+		 */
+		if (pos >= pp->size) {
+			pp->nlines = pp->s_lno - (pp->s_off == pp->size);
+			pp->eof = 1;
+			break;
+		}
+		if (pg_read(pp, pos, 1, &s, &len))
+			return (1);
+		for (p = s, t = s + len;
+		    (p = memchr(p, '\n', t - p)) != NULL;) {
+			++p;
+			++pp->s_lno;
+			pp->s_off = pos + (p - s);
+			if ((pp->s_lno - 1) % PG_STEP == 0)
+				break;
+		}
+		pos = p == NULL ? pos + len : pp->s_off;
+	}
+	return (0);
+}
+
+/*
+ * pg_line --
+ *	Return the line starting at an offset.
+ */
+static int
+pg_line(PAGER *pp, off_t off, char **lpp, size_t *lenp)
+{
+	size_t len, want;
+	char *p, *s;
+
+	for (want = 1;; want = len * 2) {
+		if (pg_read(pp, off, want, &s, &len))
+			return (1);
+		if ((p = memchr(s, '\n', len)) != NULL) {
+			len = p - s;
+			break;
+		}
+		if (off + (off_t)len >= pp->size)
+			break;
+	}
+	*lpp = s;
+	*lenp = len;
+	return (0);
+}
+
+/*
+ * pg_read --
+ *	Return at least len bytes of the file starting at an offset, or up
+ *	to the end of the file, reading a new window if they're not in the
+ *	current one.
+ */
+static int
+pg_read(PAGER *pp, off_t off, size_t len, char **bpp, size_t *lenp)
+{
+	ssize_t nr;
+	size_t cnt, wlen;
+	off_t woff;
+	char *bp;
+
+	if (off + (off_t)len > pp->size)
+		len = pp->size - off;
+	if (off < pp->woff || off + (off_t)len > pp->woff + (off_t)pp->wlen) {
+		/*
+		 * Start windows on a boundary, so reading lines backward
+		 * doesn't read a window for each line.
+		 */
+		woff = off - off % (PG_WINDOW / 2);
+		wlen = MAX(off - woff + len, PG_WINDOW);
+		if (woff + (off_t)wlen > pp->size)
+			wlen = pp->size - woff;
+		if (wlen > pp->wblen) {
+			if ((bp = realloc(pp->wp, wlen)) == NULL)
+				return (1);
+			pp->wp = bp;
+			pp->wblen = wlen;
+		}
+		pp->wlen = 0;
+		for (cnt = 0; cnt < wlen; cnt += nr)
+			if ((nr = pread(pp->fd,
+			    pp->wp + cnt, wlen - cnt, woff + cnt)) <= 0) {
+				if (nr == 0)
+					errno = EIO;
+				return (1);
+			}
+		pp->woff = woff;
+		pp->wlen = wlen;
+	}
+	*bpp = pp->wp + (off - pp->woff);
+	*lenp = pp->woff + pp->wlen - off;
+	return (0);
+}
+
+/*
+ * pg_put, pg_del --
+ *	The file can't be changed.
+ */
+static int
+pg_put(const DB *dbp, DBT *key, const DBT *data, u_int flags)
+{
+	errno = EROFS;
+	return (-1);
+}
+
+static int
+pg_del(const DB *dbp, const DBT *key, u_int flags)
+{
+	errno = EROFS;
+	return (-1);
+}
+
+/*
+ * pg_sync --
+ *	There's nothing to sync.
+ */
+static int
+pg_sync(const DB *dbp, u_int flags)
+{
+	return (0);
+}
+
+/*
+ * pg_fd --
+ *	Return the file's descriptor, for locking.
+ */
+static int
+pg_fd(const DB *dbp)
+{
+	return (((PAGER *)dbp->internal)->fd);
+}
+
+/*
+ * pg_close --
+ *	Close the file.
+ */
+static int
+pg_close(DB *dbp)
+{
+	PAGER *pp;
+	int rval;
+
+	pp = dbp->internal;
+	rval = close(pp->fd);
+	free(pp->off);
+	free(pp->wp);
+	free(pp);
+	free(dbp);
+	return (rval);
+}
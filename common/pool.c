@@ -0,0 +1,147 @@
+/*-
+ * Copyright (c) 2026
+ *	The nvi2 contributors.  All rights reserved.
+ *
+ * See the LICENSE file for redistribution information.
+ */
+
+#include "config.h"
+
+#include <sys/types.h>
+#include <sys/queue.h>
+#include <sys/time.h>
+
+#include <bitstring.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+
+/* Object sizes, by pool type. */
+static size_t const pool_size[P_NTYPES] = {
+	sizeof(TEXT),			/* P_TEXT */
+	sizeof(EXCMD),			/* P_EXCMD */
+	sizeof(RANGE),			/* P_RANGE */
+};
+
+#define	POOL_ALIGN(n)	(((n) + sizeof(void *) - 1) & ~(sizeof(void *) - 1))
+#define	POOL_SLAB_MIN	16		/* Objects in the first slab. */
+#define	POOL_SLAB_MAX	1024		/* Objects in the largest slabs. */
+
+static void	pool_free(POOL *);
+
+/*
+ * pool_get --
+ *	Return a zeroed object from a pool.
+ *
+ * PUBLIC: void *pool_get(SCR *, int);
+ */
+void *
+pool_get(SCR *sp, int type)
+{
+	POOL *pp;
+	size_t n, size;
+	char *p, *slab;
+	void **op;
+
+	pp = &sp->gp->pool[type];
+	if (pp->free == NULL) {
+		n = pp->nslab == 0 ?
+		    POOL_SLAB_MIN : MIN(pp->nslab * 2, POOL_SLAB_MAX);
+		size = POOL_ALIGN(pool_size[type]);
+		MALLOC(sp, slab, POOL_ALIGN(sizeof(void *)) + n * size);
+		if (slab == NULL)
+			return (NULL);
+		*(void **)slab = pp->slabs;
+		pp->slabs = slab;
+		pp->nslab = n;
+		for (p = slab + POOL_ALIGN(sizeof(void *)); n > 0; --n) {
+			*(void **)p = pp->free;
+			pp->free = p;
+			p += size;
+		}
+		STAT_INC(sp, pool_slab[type]);
+	}
+	op = pp->free;
+	pp->free = *op;
+	++pp->inuse;
+	STAT_INC(sp, pool_get[type]);
+
+	memset(op, 0, pool_size[type]);
+	return (op);
+}
+
+/*
+ * pool_put --
+ *	Return an object to its pool.
+ *
+ * PUBLIC: void pool_put(SCR *, int, void *);
+ */
+void
+pool_put(SCR *sp, int type, void *p)
+{
+	POOL *pp;
+
+	if (p == NULL)
+		return;
+	pp = &sp->gp->pool[type];
+	*(void **)p = pp->free;
+	pp->free = p;
+	--pp->inuse;
+}
+
+/*
+ * pool_reclaim --
+ *	At a command boundary, free the slabs of the pools that grew past
+ *	their first slab and have no objects in use.
+ *
+ * PUBLIC: void pool_reclaim(GS *);
+ */
+void
+pool_reclaim(GS *gp)
+{
+	POOL *pp;
+	int type;
+
+	for (type = 0; type < P_NTYPES; ++type) {
+		pp = &gp->pool[type];
+		if (pp->inuse != 0 || pp->nslab <= POOL_SLAB_MIN)
+			continue;
+		pool_free(pp);
+		++gp->stats.pool_empty[type];
+	}
+}
+
+/*
+ * pool_close --
+ *	Free the pools.
+ *
+ * PUBLIC: void pool_close(GS *);
+ */
+void
+pool_close(GS *gp)
+{
+	int type;
+
+	for (type = 0; type < P_NTYPES; ++type)
+		pool_free(&gp->pool[type]);
+}
+
+/*
+ * pool_free --
+ *	Free the slabs of a pool.
+ */
+static void
+pool_free(POOL *pp)
+{
+	void *slab;
+
+	while ((slab = pp->slabs) != NULL) {
+		pp->slabs = *(void **)slab;
+		free(slab);
+	}
+	pp->free = NULL;
+	pp->nslab = 0;
+}
@@ -0,0 +1,28 @@
+/*-
+ * Copyright (c) 2026
+ *	The nvi2 contributors.  All rights reserved.
+ *
+ * See the LICENSE file for redistribution information.
+ */
+
+/*
+ * Object pools.
+ *
+ * The small structures that come and go by the thousand -- TEXT structures
+ * for input lines, and the EXCMD and RANGE structures of the @, global and
+ * v commands -- are allocated from a pool per type instead of malloc(3).
+ * A pool carves its objects from slabs of doubling size, and keeps freed
+ * objects on a free list.  At command boundaries, a pool with no objects
+ * in use that has grown past its first slab frees all of its slabs at once.
+ */
+#define	P_TEXT		0		/* TEXT structures. */
+#define	P_EXCMD		1		/* EXCMD structures. */
+#define	P_RANGE		2		/* RANGE structures. */
+#define	P_NTYPES	3
+
+typedef struct _pool {
+	void	*free;			/* Free objects. */
+	void	*slabs;			/* Slabs, linked through their start. */
+	size_t	 nslab;			/* Objects in the last slab. */
+	size_t	 inuse;			/* Objects in use. */
+} POOL;
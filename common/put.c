@@ -33,7 +33,7 @@ put(SCR *sp, CB *cbp, CHAR_T *namep, MARK *cp, MARK *rp, int append, int cnt)
 {
 	CHAR_T name;
 	TEXT *ltp, *tp;
-	recno_t lno;
+	recno_t lno, n;
 	size_t blen, clen, len;
 	int rval, i, isempty;
 	CHAR_T *bp, *t;
@@ -79,13 +79,10 @@ put(SCR *sp, CB *cbp, CHAR_T *namep, MARK *cp, MARK *rp, int append, int cnt)
 			return (1);
 		if (lno == 0 && F_ISSET(cbp, CB_LMODE)) {
 			for (i = cnt; i > 0; i--) {
-				for (; tp != NULL;
-				    ++lno, ++sp->rptlines[L_ADDED],
-				    tp = TAILQ_NEXT(tp, q))
-					if (db_append(sp, 1, lno, tp->lb,
-					    tp->len))
-						return (1);
-				tp = TAILQ_FIRST(cbp->textq);
+				if (db_bappend(sp, lno, cbp->textq, &n))
+					return (1);
+				lno += n;
+				sp->rptlines[L_ADDED] += n;
 			}
 			rp->lno = 1;
 			rp->cno = 0;
@@ -93,17 +90,15 @@ put(SCR *sp, CB *cbp, CHAR_T *namep, MARK *cp, MARK *rp, int append, int cnt)
 		}
 	}
 
-	/* If a line mode buffer, append each new line into the file. */
+	/* If a line mode buffer, append the lines into the file as a block. */
 	if (F_ISSET(cbp, CB_LMODE)) {
 		lno = append ? cp->lno : cp->lno - 1;
 		rp->lno = lno + 1;
 		for (i = cnt; i > 0; i--) {
-			for (; tp != NULL;
-			    ++lno, ++sp->rptlines[L_ADDED],
-			    tp = TAILQ_NEXT(tp, q))
-				if (db_append(sp, 1, lno, tp->lb, tp->len))
-					return (1);
-			tp = TAILQ_FIRST(cbp->textq);
+			if (db_bappend(sp, lno, cbp->textq, &n))
+				return (1);
+			lno += n;
+			sp->rptlines[L_ADDED] += n;
 		}
 		rp->cno = 0;
 		(void)nonblank(sp, rp->lno, &rp->cno);
@@ -98,8 +98,61 @@
 
 #define	VI_DHEADER	"X-vi-data:"
 
+/*
+ * Finding the recovery file for a named file means reading the headers of
+ * every recovery file in the directory, which is slow when there are lots
+ * of them.  So, each user keeps an index of the recovery files they've seen
+ * in the file "index.<uid>" in the recovery directory.  The index is a list
+ * of records, appended while holding an exclusive lock on it:
+ *
+ *	+ recover.XXXXXX <mtime> <owner> <base64 file> <base64 path>
+ *	- recover.XXXXXX
+ *
+ * where a later record for a recovery file replaces any earlier one.
+ *
+ * The index is only a hint.  The directory is still read, and a record is
+ * only believed if the recovery file's modification time and owner match
+ * it.  Recovery files without a believable record have their headers read
+ * and a new record appended, records of recovery files that have gone away
+ * get deletion records, and the index is rewritten when it's malformed or
+ * mostly records that no longer matter.
+ */
+#define	RCV_INDEX	"index"
+
+typedef struct _rcvent {
+	char	*name;			/* Recovery file name. */
+	char	*file;			/* Original file name. */
+	char	*path;			/* Backing file path. */
+	time_t	 mtime;			/* Recovery file mtime. */
+	uid_t	 uid;			/* Recovery file owner. */
+	u_long	 seq;			/* Record number. */
+	int	 del;			/* Deletion record. */
+	int	 seen;			/* Recovery file exists. */
+} RCVENT;
+
+typedef struct _rcvidx {
+	int	 fd;			/* Locked index file descriptor. */
+	char	*path;			/* Index file path. */
+	char	*buf;			/* Index contents, decoded strings. */
+	RCVENT	*ents;			/* Current records, sorted by name. */
+	size_t	 nents;			/* Current record count. */
+	size_t	 nrecs;			/* Total record count. */
+	int	 bad;			/* Malformed records found. */
+} RCVIDX;
+
+#define	RCV_IDXOK(ep, sbp)						\
+	((ep) != NULL &&						\
+	    (ep)->mtime == (sbp)->st_mtime && (ep)->uid == (sbp)->st_uid)
+
 static int	 rcv_copy(SCR *, int, char *);
 static void	 rcv_email(SCR *, char *);
+static int	 rcv_entcmp(const void *, const void *);
+static void	 rcv_idxend(SCR *, RCVIDX *);
+static RCVENT	*rcv_idxfind(RCVIDX *, char *);
+static int	 rcv_idxload(SCR *, RCVIDX *);
+static int	 rcv_idxopen(SCR *, char *, int, RCVIDX *);
+static int	 rcv_idxput(SCR *,
+		    int, char *, char *, char *, time_t, uid_t);
 static int	 rcv_mailfile(SCR *, int, char *);
 static int	 rcv_mktemp(SCR *, char *, char *);
 static int	 rcv_dlnwrite(SCR *, const char *, const char *, FILE *);
@@ -297,9 +350,12 @@ rcv_sync(SCR *sp, u_int flags)
 err:		rval = 1;
 	}
 
-	/* REQUEST: end the file session. */
-	if (LF_ISSET(RCV_ENDSESSION) && file_end(sp, NULL, 1))
-		rval = 1;
+	/* REQUEST: end the file session, discard any kept files. */
+	if (LF_ISSET(RCV_ENDSESSION)) {
+		if (file_end(sp, NULL, 1))
+			rval = 1;
+		file_cache_end(sp);
+	}
 
 	return (rval);
 }
@@ -313,7 +369,9 @@ rcv_mailfile(SCR *sp, int issync, char *cp_path)
 {
 	EXF *ep;
 	GS *gp;
+	RCVIDX idx;
 	struct passwd *pw;
+	struct stat sb;
 	int len;
 	time_t now;
 	uid_t uid;
@@ -462,8 +520,15 @@ wout:		*t2++ = '\n';
 		}
 	}
 
+	/* Add the recovery file to the index. */
+	if (fflush(fp) == 0 && fstat(fileno(fp), &sb) == 0 &&
+	    rcv_idxopen(sp, dp, strlen(dp), &idx) == 0) {
+		(void)rcv_idxput(sp, idx.fd,
+		    mpath, t, cp_path, sb.st_mtime, sb.st_uid);
+		rcv_idxend(sp, &idx);
+	}
+
 	if (issync) {
-		fflush(fp);
 		rcv_email(sp, mpath);
 		free(mpath);
 	}
@@ -499,6 +564,8 @@ rcv_list(SCR *sp)
 	struct stat sb;
 	DIR *dirp;
 	FILE *fp;
+	RCVENT *ip;
+	RCVIDX idx;
 	int found;
 	char *p, *file, *path;
 	char *dtype, *data;
@@ -512,11 +579,15 @@ rcv_list(SCR *sp)
 		msgq_str(sp, M_SYSERR, p, "recdir: %s");
 		return (1);
 	}
+	if (rcv_idxopen(sp, p, strlen(p), &idx) == 0)
+		(void)rcv_idxload(sp, &idx);
 
 	/* Read the directory. */
 	for (found = 0; (dp = readdir(dirp)) != NULL;) {
 		if (strncmp(dp->d_name, "recover.", 8))
 			continue;
+		if ((ip = rcv_idxfind(&idx, dp->d_name)) != NULL)
+			ip->seen = 1;
 
 		/* If it's readable, it's recoverable. */
 		if ((fp = fopen(dp->d_name, "r")) == NULL)
@@ -540,23 +611,37 @@ rcv_list(SCR *sp)
 			continue;
 		}
 
-		/* Check the headers. */
-		for (file = NULL, path = NULL;
-		    file == NULL || path == NULL;) {
-			if ((st = rcv_dlnread(sp, &dtype, &data, fp))) {
-				if (st == 1)
-					msgq_str(sp, M_ERR, dp->d_name,
-					    "066|%s: malformed recovery file");
+		/* Check the headers, unless the index has them. */
+		(void)fstat(fileno(fp), &sb);
+		if (RCV_IDXOK(ip, &sb)) {
+			file = strdup(ip->file);
+			path = strdup(ip->path);
+			if (file == NULL || path == NULL) {
+				msgq(sp, M_SYSERR, NULL);
 				goto next;
 			}
-			if (dtype == NULL)
-				continue;
-			if (!strcmp(dtype, "file"))
-				file = data;
-			else if (!strcmp(dtype, "path"))
-				path = data;
-			else
-				free(data);
+		} else {
+			for (file = NULL, path = NULL;
+			    file == NULL || path == NULL;) {
+				if ((st =
+				    rcv_dlnread(sp, &dtype, &data, fp))) {
+					if (st == 1)
+						msgq_str(sp, M_ERR, dp->d_name,
+					    "066|%s: malformed recovery file");
+					goto next;
+				}
+				if (dtype == NULL)
+					continue;
+				if (!strcmp(dtype, "file"))
+					file = data;
+				else if (!strcmp(dtype, "path"))
+					path = data;
+				else
+					free(data);
+			}
+			if (idx.fd != -1)
+				(void)rcv_idxput(sp, idx.fd, dp->d_name,
+				    file, path, sb.st_mtime, sb.st_uid);
 		}
 
 		/*
@@ -571,6 +656,8 @@ rcv_list(SCR *sp)
 		if (stat(path, &sb) &&
 		    errno == ENOENT) {
 			(void)unlink(dp->d_name);
+			if (ip != NULL)
+				ip->seen = 0;
 			goto next;
 		}
 
@@ -588,6 +675,7 @@ next:		(void)fclose(fp);
 	if (found == 0)
 		(void)printf("%s: No files to recover\n", getprogname());
 	(void)closedir(dirp);
+	rcv_idxend(sp, &idx);
 	return (0);
 }
 
@@ -605,6 +693,8 @@ rcv_read(SCR *sp, FREF *frp)
 	DIR *dirp;
 	FILE *fp;
 	EXF *ep;
+	RCVENT *ip;
+	RCVIDX idx;
 	struct timespec rec_mtim = { 0, 0 };
 	int found, locked = 0, requested, sv_fd;
 	char *name, *p, *t, *rp, *recp, *pathp;
@@ -619,6 +709,8 @@ rcv_read(SCR *sp, FREF *frp)
 		msgq_str(sp, M_SYSERR, rp, "%s");
 		return (1);
 	}
+	if (rcv_idxopen(sp, rp, strlen(rp), &idx) == 0)
+		(void)rcv_idxload(sp, &idx);
 
 	name = frp->name;
 	sv_fd = -1;
@@ -626,6 +718,8 @@ rcv_read(SCR *sp, FREF *frp)
 	for (found = requested = 0; (dp = readdir(dirp)) != NULL;) {
 		if (strncmp(dp->d_name, "recover.", 8))
 			continue;
+		if ((ip = rcv_idxfind(&idx, dp->d_name)) != NULL)
+			ip->seen = 1;
 		if ((recpath = join(rp, dp->d_name)) == NULL) {
 			msgq(sp, M_SYSERR, NULL);
 			continue;
@@ -657,23 +751,37 @@ rcv_read(SCR *sp, FREF *frp)
 			continue;
 		}
 
-		/* Check the headers. */
-		for (file = NULL, path = NULL;
-		    file == NULL || path == NULL;) {
-			if ((st = rcv_dlnread(sp, &dtype, &data, fp))) {
-				if (st == 1)
-					msgq_str(sp, M_ERR, dp->d_name,
-					    "067|%s: malformed recovery file");
+		/* Check the headers, unless the index has them. */
+		(void)fstat(fileno(fp), &sb);
+		if (RCV_IDXOK(ip, &sb)) {
+			file = strdup(ip->file);
+			path = strdup(ip->path);
+			if (file == NULL || path == NULL) {
+				msgq(sp, M_SYSERR, NULL);
 				goto next;
 			}
-			if (dtype == NULL)
-				continue;
-			if (!strcmp(dtype, "file"))
-				file = data;
-			else if (!strcmp(dtype, "path"))
-				path = data;
-			else
-				free(data);
+		} else {
+			for (file = NULL, path = NULL;
+			    file == NULL || path == NULL;) {
+				if ((st =
+				    rcv_dlnread(sp, &dtype, &data, fp))) {
+					if (st == 1)
+						msgq_str(sp, M_ERR, dp->d_name,
+					    "067|%s: malformed recovery file");
+					goto next;
+				}
+				if (dtype == NULL)
+					continue;
+				if (!strcmp(dtype, "file"))
+					file = data;
+				else if (!strcmp(dtype, "path"))
+					path = data;
+				else
+					free(data);
+			}
+			if (idx.fd != -1)
+				(void)rcv_idxput(sp, idx.fd, dp->d_name,
+				    file, path, sb.st_mtime, sb.st_uid);
 		}
 		++found;
 
@@ -734,6 +842,7 @@ next:			free(recpath);
 		free(file);
 	}
 	(void)closedir(dirp);
+	rcv_idxend(sp, &idx);
 
 	if (recp == NULL) {
 		msgq_str(sp, M_INFO, name,
@@ -779,6 +888,283 @@ next:			free(recpath);
 	return (0);
 }
 
+/*
+ * rcv_idxdel --
+ *	Note in the index that a recovery file has been removed.
+ *
+ * PUBLIC: void rcv_idxdel(SCR *, char *);
+ */
+void
+rcv_idxdel(SCR *sp, char *mpath)
+{
+	RCVIDX idx;
+	char *p;
+
+	if ((p = strrchr(mpath, '/')) == NULL ||
+	    rcv_idxopen(sp, mpath, p - mpath, &idx))
+		return;
+	(void)rcv_idxput(sp, idx.fd, p + 1, NULL, NULL, 0, 0);
+	rcv_idxend(sp, &idx);
+}
+
+/*
+ * rcv_idxopen --
+ *	Open and lock the user's index in a recovery directory.
+ */
+static int
+rcv_idxopen(SCR *sp, char *dir, int dlen, RCVIDX *ip)
+{
+	struct stat sb, psb;
+	int fd;
+
+	memset(ip, 0, sizeof(*ip));
+	ip->fd = -1;
+	if (asprintf(&ip->path, "%.*s/" RCV_INDEX ".%lu",
+	    dlen, dir, (u_long)getuid()) == -1) {
+		ip->path = NULL;
+		return (1);
+	}
+
+	/*
+	 * The recovery directory is world writable, so don't follow links
+	 * and don't let anyone else create the index for us: try creating
+	 * it first, and only open an existing one if that fails.  The index
+	 * is replaced when it's rewritten, so once we hold the lock, make
+	 * sure it's still the index, and that it's a file we own.
+	 */
+	for (;;) {
+		if ((fd = open(ip->path, O_RDWR | O_APPEND | O_CREAT |
+		    O_EXCL | O_NOFOLLOW, S_IRUSR | S_IWUSR)) == -1) {
+			if (errno != EEXIST)
+				goto err;
+			if ((fd = open(ip->path,
+			    O_RDWR | O_APPEND | O_NOFOLLOW)) == -1) {
+				if (errno == ENOENT)
+					continue;
+				goto err;
+			}
+		}
+		(void)flock(fd, LOCK_EX);
+		if (fstat(fd, &sb) || lstat(ip->path, &psb))
+			goto err;
+		if (sb.st_dev == psb.st_dev && sb.st_ino == psb.st_ino)
+			break;
+		(void)close(fd);
+	}
+	if (!S_ISREG(sb.st_mode) || !S_ISREG(psb.st_mode) ||
+	    sb.st_uid != getuid())
+		goto err;
+	(void)fcntl(fd, F_SETFD, FD_CLOEXEC);
+	ip->fd = fd;
+	return (0);
+
+err:	if (fd != -1)
+		(void)close(fd);
+	free(ip->path);
+	ip->path = NULL;
+	return (1);
+}
+
+/*
+ * rcv_idxload --
+ *	Read the index, rewriting it if it's malformed or mostly obsolete.
+ */
+static int
+rcv_idxload(SCR *sp, RCVIDX *ip)
+{
+	struct stat sb;
+	RCVENT *ep;
+	ssize_t nr;
+	size_t cnt, len, off;
+	int fd, i;
+	char *dbuf, *f[6], *p, *t, *tmp;
+
+	if (fstat(ip->fd, &sb) || sb.st_size == 0)
+		return (0);
+
+	/* Read the index; the decoded strings follow it in the buffer. */
+	len = sb.st_size;
+	MALLOC_RET(sp, ip->buf, 2 * (len + 1));
+	for (off = 0; off < len; off += nr)
+		if ((nr = pread(ip->fd, ip->buf + off, len - off, off)) <= 0) {
+			len = off;
+			break;
+		}
+	ip->buf[len] = '\0';
+	dbuf = ip->buf + len + 1;
+
+	for (cnt = 0, p = ip->buf; (p = strchr(p, '\n')) != NULL; ++p)
+		++cnt;
+	CALLOC_RET(sp, ip->ents, cnt + 1, sizeof(RCVENT));
+
+	for (p = ip->buf; *p != '\0'; p = t) {
+		if ((t = strchr(p, '\n')) == NULL) {
+			++ip->bad;
+			break;
+		}
+		*t++ = '\0';
+		++ip->nrecs;
+		for (i = 0; i < 6 && (f[i] = strsep(&p, " ")) != NULL; ++i);
+		ep = ip->ents + ip->nents;
+		ep->seq = ip->nrecs;
+		if (p != NULL || i < 2 || strncmp(f[1], "recover.", 8) ||
+		    strchr(f[1], '/') != NULL)
+			goto bad;
+		ep->name = f[1];
+		if (i == 2 && !strcmp(f[0], "-")) {
+			ep->del = 1;
+			++ip->nents;
+			continue;
+		}
+		if (i != 6 || strcmp(f[0], "+"))
+			goto bad;
+		ep->mtime = strtoll(f[2], NULL, 10);
+		ep->uid = strtoul(f[3], NULL, 10);
+		ep->file = dbuf;
+		if ((nr = b64_pton(f[4], (u_char *)dbuf, len + 1)) == -1)
+			goto bad;
+		dbuf[nr] = '\0';
+		dbuf += nr + 1;
+		ep->path = dbuf;
+		if ((nr = b64_pton(f[5], (u_char *)dbuf, len + 1)) == -1)
+			goto bad;
+		dbuf[nr] = '\0';
+		dbuf += nr + 1;
+		++ip->nents;
+		continue;
+bad:		++ip->bad;
+	}
+
+	/* Sort by name, keeping the last record for each recovery file. */
+	qsort(ip->ents, ip->nents, sizeof(RCVENT), rcv_entcmp);
+	for (cnt = 0, ep = ip->ents; ep < ip->ents + ip->nents; ++ep) {
+		if (ep + 1 < ip->ents + ip->nents &&
+		    !strcmp(ep->name, ep[1].name))
+			continue;
+		if (!ep->del)
+			ip->ents[cnt++] = *ep;
+	}
+	ip->nents = cnt;
+
+	if (!ip->bad && ip->nrecs <= 2 * ip->nents + 32)
+		return (0);
+
+	/*
+	 * Rewrite the index.  The new index is locked before it replaces
+	 * the old one, so nobody else can get at it until we're done.
+	 */
+	if (asprintf(&tmp, "%s.XXXXXX", ip->path) == -1)
+		return (1);
+	if ((fd = mkstemp(tmp)) == -1) {
+		free(tmp);
+		return (1);
+	}
+	(void)flock(fd, LOCK_EX);
+	for (ep = ip->ents; ep < ip->ents + ip->nents; ++ep)
+		if (rcv_idxput(sp, fd,
+		    ep->name, ep->file, ep->path, ep->mtime, ep->uid))
+			goto err;
+	if (rename(tmp, ip->path))
+		goto err;
+	free(tmp);
+	(void)fcntl(fd, F_SETFL, O_APPEND);
+	(void)fcntl(fd, F_SETFD, FD_CLOEXEC);
+	(void)close(ip->fd);
+	ip->fd = fd;
+	ip->nrecs = ip->nents;
+	return (0);
+
+err:	(void)unlink(tmp);
+	(void)close(fd);
+	free(tmp);
+	return (1);
+}
+
+/*
+ * rcv_idxput --
+ *	Append a record to the index, a deletion record if file is NULL.
+ */
+static int
+rcv_idxput(SCR *sp, int fd,
+    char *name, char *file, char *path, time_t mtime, uid_t uid)
+{
+	size_t flen, len, plen;
+	int n, rval;
+	char *bp, *p;
+
+	if ((p = strrchr(name, '/')) != NULL)
+		name = p + 1;
+	if (file == NULL) {
+		if ((n = asprintf(&bp, "- %s\n", name)) == -1)
+			return (1);
+	} else {
+		flen = strlen(file);
+		plen = strlen(path);
+		len = strlen(name) +
+		    (flen + 2) / 3 * 4 + (plen + 2) / 3 * 4 + 64;
+		if ((bp = malloc(len)) == NULL)
+			return (1);
+		n = snprintf(bp, len,
+		    "+ %s %lld %lu ", name, (long long)mtime, (u_long)uid);
+		n += b64_ntop((u_char *)file, flen, bp + n, len - n);
+		bp[n++] = ' ';
+		n += b64_ntop((u_char *)path, plen, bp + n, len - n);
+		bp[n++] = '\n';
+	}
+	rval = write(fd, bp, n) != n;
+	free(bp);
+	return (rval);
+}
+
+/*
+ * rcv_idxfind --
+ *	Find the index record for a recovery file.
+ */
+static RCVENT *
+rcv_idxfind(RCVIDX *ip, char *name)
+{
+	RCVENT key;
+
+	if (ip->nents == 0)
+		return (NULL);
+	key.name = name;
+	key.seq = 0;
+	return (bsearch(&key, ip->ents, ip->nents, sizeof(RCVENT), rcv_entcmp));
+}
+
+/*
+ * rcv_idxend --
+ *	Record the recovery files that have gone away, and release the index.
+ */
+static void
+rcv_idxend(SCR *sp, RCVIDX *ip)
+{
+	RCVENT *ep;
+
+	if (ip->fd == -1)
+		return;
+	for (ep = ip->ents; ep < ip->ents + ip->nents; ++ep)
+		if (!ep->seen)
+			(void)rcv_idxput(sp, ip->fd, ep->name, NULL, NULL, 0, 0);
+	(void)close(ip->fd);
+	free(ip->path);
+	free(ip->buf);
+	free(ip->ents);
+}
+
+static int
+rcv_entcmp(const void *a, const void *b)
+{
+	const RCVENT *ea = a, *eb = b;
+	int cmp;
+
+	/* A key with no sequence number matches any record with the name. */
+	if ((cmp = strcmp(ea->name, eb->name)) != 0 || ea->seq == 0 ||
+	    eb->seq == 0)
+		return (cmp);
+	return (ea->seq < eb->seq ? -1 : ea->seq > eb->seq);
+}
+
 /*
  * rcv_copy --
  *	Copy a recovery file.
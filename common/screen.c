@@ -145,6 +145,10 @@ screen_end(SCR *sp)
 	/* The screen is no longer real. */
 	F_CLR(sp, SC_SCR_EX | SC_SCR_VI);
 
+	/* The last screen to go writes out the performance counters. */
+	if (TAILQ_EMPTY(sp->gp->dq) && TAILQ_EMPTY(sp->gp->hq))
+		stats_save(sp);
+
 	rval = 0;
 	if (v_screen_end(sp))			/* End vi. */
 		rval = 1;
@@ -162,7 +166,7 @@ screen_end(SCR *sp)
 
 	/* Free any text input. */
 	if (!TAILQ_EMPTY(sp->tiq))
-		text_lfree(sp->tiq);
+		text_lfree(sp, sp->tiq);
 
 	/* Free alternate file name. */
 	free(sp->alt_name);
@@ -234,7 +234,7 @@ f_search(SCR *sp, MARK *fm, MARK *rm, CHAR_T *ptrn, size_t plen,
 		    lno, coff, len != 0 ? len - 1 : len);
 #endif
 		/* Search the line. */
-		eval = regexec(&sp->re_c, l, 1, match,
+		eval = re_exec(sp, &sp->re_c, l, 1, match,
 		    (match[0].rm_so == 0 ? 0 : REG_NOTBOL) | REG_STARTEND);
 		if (eval == REG_NOMATCH)
 			continue;
@@ -367,7 +367,7 @@ b_search(SCR *sp, MARK *fm, MARK *rm, CHAR_T *ptrn, size_t plen,
 		TRACE(sp, "B search: %lu from 0 to %qu\n", lno, match[0].rm_eo);
 #endif
 		/* Search the line. */
-		eval = regexec(&sp->re_c, l, 1, match,
+		eval = re_exec(sp, &sp->re_c, l, 1, match,
 		    (match[0].rm_eo == len ? 0 : REG_NOTEOL) | REG_STARTEND);
 		if (eval == REG_NOMATCH)
 			continue;
@@ -402,7 +402,7 @@ b_search(SCR *sp, MARK *fm, MARK *rm, CHAR_T *ptrn, size_t plen,
 			if (match[0].rm_so >= len)
 				break;
 			match[0].rm_eo = len;
-			eval = regexec(&sp->re_c, l, 1, match,
+			eval = re_exec(sp, &sp->re_c, l, 1, match,
 			    (match[0].rm_so == 0 ? 0 : REG_NOTBOL) |
 			    REG_STARTEND);
 			if (eval == REG_NOMATCH)
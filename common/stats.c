@@ -0,0 +1,231 @@
+/*-
+ * Copyright (c) 2026
+ *	The nvi2 contributors.  All rights reserved.
+ *
+ * See the LICENSE file for redistribution information.
+ */
+
+#include "config.h"
+
+#include <sys/types.h>
+#include <sys/queue.h>
+#include <sys/time.h>
+
+#include <bitstring.h>
+#include <errno.h>
+#include <limits.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "common.h"
+
+static struct {
+	char	*name;			/* Counter name. */
+	size_t	 off;			/* Offset in the STATS structure. */
+	int	 istime;		/* If a time, in nanoseconds. */
+} const statlist[] = {
+	{"db_get.hit",		offsetof(STATS, db_hit),	0},
+	{"db_get.miss",		offsetof(STATS, db_miss),	0},
+	{"recno.get",		offsetof(STATS, rec_get),	0},
+	{"recno.put",		offsetof(STATS, rec_put),	0},
+	{"recno.del",		offsetof(STATS, rec_del),	0},
+	{"file2int.bytes",	offsetof(STATS, file2int),	0},
+	{"int2file.chars",	offsetof(STATS, int2file),	0},
+	{"regexec.calls",	offsetof(STATS, re_calls),	0},
+	{"regexec.time",	offsetof(STATS, re_time),	1},
+	{"log.records",		offsetof(STATS, log_recs),	0},
+	{"log.bytes",		offsetof(STATS, log_bytes),	0},
+	{"vs_paint.calls",	offsetof(STATS, vs_paint),	0},
+	{"vs_line.calls",	offsetof(STATS, vs_line),	0},
+	{"refresh.calls",	offsetof(STATS, refresh),	0},
+	{"refresh.time",	offsetof(STATS, refresh_time),	1},
+	{"key.events",		offsetof(STATS, keys),		0},
+	{"key.latency",		offsetof(STATS, key_time),	1},
+	{"key.latency_max",	offsetof(STATS, key_max),	1},
+	{"excmd.cache.hit",	offsetof(STATS, pc_hit),	0},
+	{"excmd.cache.miss",	offsetof(STATS, pc_miss),	0},
+	{"pool.text.get",	offsetof(STATS, pool_get[P_TEXT]),	0},
+	{"pool.text.slabs",	offsetof(STATS, pool_slab[P_TEXT]),	0},
+	{"pool.text.reclaim",	offsetof(STATS, pool_empty[P_TEXT]),	0},
+	{"pool.excmd.get",	offsetof(STATS, pool_get[P_EXCMD]),	0},
+	{"pool.excmd.slabs",	offsetof(STATS, pool_slab[P_EXCMD]),	0},
+	{"pool.excmd.reclaim",	offsetof(STATS, pool_empty[P_EXCMD]),	0},
+	{"pool.range.get",	offsetof(STATS, pool_get[P_RANGE]),	0},
+	{"pool.range.slabs",	offsetof(STATS, pool_slab[P_RANGE]),	0},
+	{"pool.range.reclaim",	offsetof(STATS, pool_empty[P_RANGE]),	0},
+	{NULL},
+};
+
+/*
+ * stats_now --
+ *	Return a monotonic timestamp in nanoseconds.
+ *
+ * PUBLIC: uint64_t stats_now(void);
+ */
+uint64_t
+stats_now(void)
+{
+	struct timespec ts;
+
+	timepoint_steady(&ts);
+	return ((uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec);
+}
+
+/*
+ * stats_display --
+ *	Display the counters, or write them to a file if fp isn't NULL.
+ *
+ * PUBLIC: int stats_display(SCR *, FILE *);
+ */
+int
+stats_display(SCR *sp, FILE *fp)
+{
+	uint64_t v;
+	int cnt;
+	char buf[64];
+
+	for (cnt = 0; statlist[cnt].name != NULL; ++cnt) {
+		v = *(uint64_t *)((char *)&sp->gp->stats + statlist[cnt].off);
+		if (statlist[cnt].istime)
+			(void)snprintf(buf, sizeof(buf), "%llu.%06llums",
+			    (unsigned long long)(v / 1000000),
+			    (unsigned long long)(v % 1000000));
+		else
+			(void)snprintf(buf, sizeof(buf),
+			    "%llu", (unsigned long long)v);
+		if (fp == NULL) {
+			(void)ex_printf(sp,
+			    "%-18s %s\n", statlist[cnt].name, buf);
+			if (INTERRUPTED(sp))
+				break;
+		} else
+			(void)fprintf(fp, "%s %s\n", statlist[cnt].name, buf);
+	}
+	return (fp != NULL && ferror(fp));
+}
+
+/*
+ * stats_save --
+ *	Write the counters to the statsfile, if it's set.
+ *
+ * PUBLIC: void stats_save(SCR *);
+ */
+void
+stats_save(SCR *sp)
+{
+	FILE *fp;
+	char *p;
+
+	if ((p = O_STR(sp, O_STATSFILE)) == NULL || *p == '\0')
+		return;
+	if ((fp = fopen(p, "w")) == NULL) {
+		msgq_str(sp, M_SYSERR, p, "%s");
+		return;
+	}
+	if (stats_display(sp, fp) | fclose(fp))
+		msgq_str(sp, M_SYSERR, p, "%s");
+}
+
+/*
+ * trace_size --
+ *	Set the size of the trace ring, discarding its contents.
+ *
+ * PUBLIC: int trace_size(SCR *, u_long);
+ */
+int
+trace_size(SCR *sp, u_long size)
+{
+	TRRING *trp;
+
+	trp = &sp->gp->tr;
+	free(trp->ring);
+	memset(trp, 0, sizeof(*trp));
+	if (size == 0)
+		return (0);
+	CALLOC_RET(sp, trp->ring, size, sizeof(TREV));
+	trp->size = size;
+	return (0);
+}
+
+/*
+ * trace_add --
+ *	Log a trace event, overwriting the oldest one if the ring is full.
+ *
+ * PUBLIC: void trace_add(GS *, int, int, u_long);
+ */
+void
+trace_add(GS *gp, int type, int phase, u_long arg)
+{
+	TREV *ep;
+
+	ep = gp->tr.ring + gp->tr.next;
+	ep->time = stats_now();
+	ep->arg = arg;
+	ep->type = type;
+	ep->phase = phase;
+	if (++gp->tr.next == gp->tr.size)
+		gp->tr.next = 0;
+	++gp->tr.cnt;
+}
+
+/*
+ * trace_dump --
+ *	Write the trace ring to a file in the Chrome trace event format.
+ *
+ * PUBLIC: int trace_dump(SCR *, char *);
+ */
+int
+trace_dump(SCR *sp, char *path)
+{
+	static char const *names[] = {
+		"key", "map", "command", "refresh", "paint", "update",
+	};
+	FILE *fp;
+	TREV *ep;
+	TRRING *trp;
+	size_t cnt, i, n;
+	int first, open[sizeof(names) / sizeof(names[0])];
+
+	trp = &sp->gp->tr;
+	if ((fp = fopen(path, "w")) == NULL) {
+		msgq_str(sp, M_SYSERR, path, "%s");
+		return (1);
+	}
+	(void)fprintf(fp, "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [");
+
+	/*
+	 * Start with the oldest event.  If the ring wrapped, the first end
+	 * events may have lost their begin events, skip them.
+	 */
+	memset(open, 0, sizeof(open));
+	cnt = trp->cnt < trp->size ? trp->cnt : trp->size;
+	i = trp->cnt < trp->size ? 0 : trp->next;
+	for (first = 1, n = 0; n < cnt; ++n, i = (i + 1) % trp->size) {
+		ep = trp->ring + i;
+		if (ep->phase == TR_BEGIN)
+			++open[ep->type];
+		else if (ep->phase == TR_END && open[ep->type]-- == 0) {
+			open[ep->type] = 0;
+			continue;
+		}
+		(void)fprintf(fp, "%s\n{\"name\": \"%s\", \"ph\": \"%c\", "
+		    "\"ts\": %llu.%03u, \"pid\": %ld, \"tid\": 1, %s"
+		    "\"args\": {\"arg\": %lu}}", first ? "" : ",",
+		    names[ep->type], ep->phase,
+		    (unsigned long long)(ep->time / 1000),
+		    (u_int)(ep->time % 1000), (long)getpid(),
+		    ep->phase == TR_INSTANT ? "\"s\": \"t\", " : "",
+		    (u_long)ep->arg);
+		first = 0;
+	}
+	(void)fprintf(fp, "\n]}\n");
+	if (ferror(fp) | fclose(fp)) {
+		msgq_str(sp, M_SYSERR, path, "%s");
+		return (1);
+	}
+	return (0);
+}
@@ -0,0 +1,83 @@
+/*-
+ * Copyright (c) 2026
+ *	The nvi2 contributors.  All rights reserved.
+ *
+ * See the LICENSE file for redistribution information.
+ */
+
+/*
+ * Performance counters.
+ *
+ * They're always on, so they have to be cheap: a counter is an increment,
+ * and a timer is a pair of clock_gettime(2) calls.  The times are kept in
+ * nanoseconds.  They're displayed by the :stats command, and written to the
+ * file named by the statsfile option when the editor exits.
+ */
+typedef struct _stats {
+	uint64_t db_hit;		/* Line cache hits. */
+	uint64_t db_miss;		/* Line cache misses. */
+	uint64_t rec_get;		/* Line store gets. */
+	uint64_t rec_put;		/* Line store puts. */
+	uint64_t rec_del;		/* Line store deletes. */
+	uint64_t file2int;		/* Bytes decoded from the file. */
+	uint64_t int2file;		/* Characters encoded for the file. */
+	uint64_t re_calls;		/* Regular expression matches. */
+	uint64_t re_time;		/* Regular expression match time. */
+	uint64_t log_recs;		/* Undo log records. */
+	uint64_t log_bytes;		/* Undo log bytes. */
+	uint64_t vs_paint;		/* Screen paints. */
+	uint64_t vs_line;		/* Screen lines displayed. */
+	uint64_t refresh;		/* Terminal refreshes. */
+	uint64_t refresh_time;		/* Terminal refresh time. */
+	uint64_t keys;			/* Key events from the terminal. */
+	uint64_t key_time;		/* Key to refreshed screen time. */
+	uint64_t key_max;		/* Maximum key latency. */
+	uint64_t pc_hit;		/* Parsed ex command cache hits. */
+	uint64_t pc_miss;		/* Parsed ex command cache misses. */
+	uint64_t pool_get[P_NTYPES];	/* Pool objects allocated. */
+	uint64_t pool_slab[P_NTYPES];	/* Pool slabs allocated. */
+	uint64_t pool_empty[P_NTYPES];	/* Pools emptied. */
+
+	uint64_t key_start;		/* Time of the pending key event. */
+} STATS;
+
+#define	STAT_INC(sp, f)		(++(sp)->gp->stats.f)
+#define	STAT_ADD(sp, f, n)	((sp)->gp->stats.f += (n))
+#define	STAT_START(t)		((t) = stats_now())
+#define	STAT_STOP(sp, f, t)	((sp)->gp->stats.f += stats_now() - (t))
+
+/*
+ * Trace ring.
+ *
+ * If the traceevents option is set, the stages of handling a key are logged
+ * into a ring of that many timestamped events, which the :trace command
+ * writes out in the Chrome trace format.  A disabled trace costs a pointer
+ * test per event.
+ */
+typedef struct _trev {
+	uint64_t time;			/* Timestamp, nanoseconds. */
+	uint32_t arg;			/* Argument, e.g. the key. */
+	u_int8_t type;			/* Event type. */
+#define	TR_KEY		0		/* Key read from the terminal. */
+#define	TR_MAP		1		/* Key map lookup. */
+#define	TR_COMMAND	2		/* Vi command. */
+#define	TR_REFRESH	3		/* Screen refresh. */
+#define	TR_PAINT	4		/* Screen paint. */
+#define	TR_UPDATE	5		/* Terminal update. */
+	char	 phase;			/* Chrome trace phase. */
+#define	TR_BEGIN	'B'
+#define	TR_END		'E'
+#define	TR_INSTANT	'i'
+} TREV;
+
+typedef struct _trring {
+	TREV	*ring;			/* Events, NULL if not tracing. */
+	size_t	 size;			/* Ring size. */
+	size_t	 next;			/* Next slot. */
+	uint64_t cnt;			/* Events logged. */
+} TRRING;
+
+#define	TR_EVENT(sp, t, ph, a) do {					\
+	if ((sp)->gp->tr.ring != NULL)					\
+		trace_add((sp)->gp, t, ph, a);				\
+} while (0)
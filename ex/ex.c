@@ -34,6 +34,8 @@ static EXCMDLIST const *
 static int	ex_discard(SCR *);
 static int	ex_line(SCR *, EXCMD *, MARK *, int *, int *);
 static int	ex_load(SCR *);
+static EX_PCE  *ex_pc_get(SCR *, EXCMD *, u_int32_t *);
+static void	ex_pc_put(SCR *, EXCMD *, EX_PCE *, CHAR_T *, CHAR_T *);
 static void	ex_unknown(SCR *, CHAR_T *, size_t);
 
 /*
@@ -83,6 +85,9 @@ ex(SCR **spp)
 	 */
 	LF_INIT(TXT_BACKSLASH | TXT_CNTRLD | TXT_CR);
 	for (;; ++gp->excmd.if_lno) {
+		/* Free the memory the last command grew the pools to. */
+		pool_reclaim(gp);
+
 		/* Display status line and flush. */
 		if (F_ISSET(sp, SC_STATUS)) {
 			if (!F_ISSET(sp, SC_EX_SILENT))
@@ -193,18 +198,20 @@ int
 ex_cmd(SCR *sp)
 {
 	enum nresult nret;
+	EX_PCE pce_new, *pce;
 	EX_PRIVATE *exp;
 	EXCMD *ecp;
 	GS *gp;
 	MARK cur;
-	recno_t lno;
-	size_t arg1_len, discard, len;
-	u_int32_t flags;
+	recno_t lno, nlines;
+	size_t arg1_len, discard, len, pclen;
+	u_int32_t flags, pchash;
 	long ltmp;
 	int at_found, gv_found;
 	int cnt, delim, isaddr, namelen;
 	int newscreen, notempty, tmp, vi_address;
 	CHAR_T *arg1, *s, *p, *t;
+	CHAR_T *pcs, pcbuf[EX_PC_TEXT];
 	CHAR_T ch = '\0';
 	CHAR_T *n;
 	char *np;
@@ -379,7 +386,33 @@ loop:	ecp = SLIST_FIRST(gp->ecq);
 	 */
 #define	SINGLE_CHAR_COMMANDS	L("\004!#&*<=>@~")
 	newscreen = 0;
+	pce = NULL;
+	pcs = NULL;
+	pclen = 0;
+	pchash = 0;
 	if (ecp->clen != 0 && ecp->cp[0] != '|' && ecp->cp[0] != '\n') {
+		/*
+		 * Commands from @ buffers, globals and sourced files are
+		 * likely to be run again: if this one's been seen before,
+		 * reuse its parse, otherwise keep a copy of the text so the
+		 * parse can be saved.
+		 */
+		if (FL_ISSET(ecp->agv_flags, AGV_ALL) || ecp->if_name != NULL) {
+			pcs = ecp->cp;
+			if ((pce = ex_pc_get(sp, ecp, &pchash)) != NULL) {
+				STAT_INC(sp, pc_hit);
+				if (pce->cmd == NULL) {
+					ecp->rcmd = pce->rcmd;
+					ecp->cmd = &ecp->rcmd;
+				} else
+					ecp->cmd = pce->cmd;
+				newscreen = F_ISSET(pce, PC_NEWSCREEN) ? 1 : 0;
+				goto pc_found;
+			}
+			STAT_INC(sp, pc_miss);
+			pclen = MIN(ecp->clen, EX_PC_TEXT);
+			MEMCPY(pcbuf, pcs, pclen);
+		}
 		if (STRCHR(SINGLE_CHAR_COMMANDS, *ecp->cp)) {
 			p = ecp->cp;
 			++ecp->cp;
@@ -509,7 +542,7 @@ skip_srch:	if (ecp->cmd == &cmds[C_VISUAL_EX] && F_ISSET(sp, SC_VI))
 			goto unknown;
 
 		/* Secure means no shell access. */
-		if (F_ISSET(ecp->cmd, E_SECURE) && O_ISSET(sp, O_SECURE)) {
+pc_found:	if (F_ISSET(ecp->cmd, E_SECURE) && O_ISSET(sp, O_SECURE)) {
 			ex_wemsg(sp, ecp->cmd->name, EXM_SECURE);
 			goto err;
 		}
@@ -625,8 +658,30 @@ skip_srch:	if (ecp->cmd == &cmds[C_VISUAL_EX] && F_ISSET(sp, SC_VI))
 	 * special cases we move past their special argument(s).  Then, we
 	 * do normal command processing on whatever is left.  Barf-O-Rama.
 	 */
+	if (pce != NULL) {
+		/* The command is in the cache, replay its parse. */
+		len = ecp->clen;
+		MEMCPY(pcs, pce->text + pce->len, pce->len);
+		if (F_ISSET(pce, PC_FORCE))
+			FL_SET(ecp->iflags, E_C_FORCE);
+		if ((arg1_len = pce->arg1_len) != 0)
+			arg1 = pcs + pce->arg1off;
+		vi_address = F_ISSET(pce, PC_VIADDR) ? 1 : 0;
+		ecp->trailing = F_ISSET(pce, PC_TRAILING) ? 1 : 0;
+		if (F_ISSET(pce, PC_NEWLINE))
+			F_SET(ecp, E_NEWLINE);
+		gp->if_lno += pce->nlines;
+		ecp->if_lno += pce->nlines;
+		ecp->save_cmd = pcs + pce->len + !ecp->trailing;
+		ecp->save_cmdlen = len - pce->len;
+		ecp->cp = pcs + pce->cpoff;
+		ecp->clen = pce->clen;
+		goto pc_done;
+	}
+
 	discard = 0;		/* Characters discarded from the command. */
 	arg1_len = 0;
+	nlines = 0;
 	ecp->save_cmd = ecp->cp;
 	if (ecp->cmd == &cmds[C_EDIT] || ecp->cmd == &cmds[C_EX] ||
 	    ecp->cmd == &cmds[C_NEXT] || ecp->cmd == &cmds[C_VISUAL_VI] ||
@@ -696,6 +751,7 @@ skip_srch:	if (ecp->cmd == &cmds[C_VISUAL_EX] && F_ISSET(sp, SC_VI))
 
 				++gp->if_lno;
 				++ecp->if_lno;
+				++nlines;
 			} else if (ch == '\n')
 				break;
 			*p++ = ch;
@@ -782,6 +838,7 @@ skip_srch:	if (ecp->cmd == &cmds[C_VISUAL_EX] && F_ISSET(sp, SC_VI))
 				if (tmp == '\n') {
 					++gp->if_lno;
 					++ecp->if_lno;
+					++nlines;
 				}
 				++discard;
 				--ecp->clen;
@@ -826,6 +883,40 @@ skip_srch:	if (ecp->cmd == &cmds[C_VISUAL_EX] && F_ISSET(sp, SC_VI))
 				*p = CH_LITERAL;
 	}
 
+	/*
+	 * Save the parse.  The multiple < and > commands have already done
+	 * their argument expansion, don't bother with them.
+	 */
+	if (pcs != NULL && ecp->cmd != &cmds[C_SHIFTL] &&
+	    ecp->cmd != &cmds[C_SHIFTR] &&
+	    (len = (ecp->save_cmd - pcs) - !ecp->trailing) <= pclen) {
+		memset(&pce_new, 0, sizeof(pce_new));
+		pce_new.len = len;
+		pce_new.hash = pchash;
+		if (ecp->cmd == &ecp->rcmd)
+			pce_new.rcmd = ecp->rcmd;
+		else
+			pce_new.cmd = ecp->cmd;
+		pce_new.cpoff = ecp->cp - pcs;
+		pce_new.clen = ecp->clen;
+		if ((pce_new.arg1_len = arg1_len) != 0)
+			pce_new.arg1off = arg1 - pcs;
+		pce_new.nlines = nlines;
+		if (FL_ISSET(ecp->iflags, E_C_FORCE))
+			F_SET(&pce_new, PC_FORCE);
+		if (F_ISSET(ecp, E_NEWLINE))
+			F_SET(&pce_new, PC_NEWLINE);
+		if (newscreen)
+			F_SET(&pce_new, PC_NEWSCREEN);
+		if (ecp->trailing)
+			F_SET(&pce_new, PC_TRAILING);
+		if (vi_address)
+			F_SET(&pce_new, PC_VIADDR);
+		ex_pc_put(sp, ecp, &pce_new, pcbuf, pcs);
+	}
+
+pc_done:
+
 	/*
 	 * Set the default addresses.  It's an error to specify an address for
 	 * a command that doesn't take them.  If two addresses are specified
@@ -1377,6 +1468,14 @@ addr_verify:
 		F_CLR(ecp, E_NRSEP);
 	}
 
+	/*
+	 * A startup run that executes anything other than option, map and
+	 * abbreviation commands can't be replayed from the startup cache.
+	 */
+	if (F_ISSET(exp, EXP_RCREC) && ecp->cmd != &cmds[C_SET] &&
+	    ecp->cmd != &cmds[C_MAP] && ecp->cmd != &cmds[C_ABBR])
+		F_SET(exp, EXP_RCDIRTY);
+
 	/*
 	 * Call the underlying function for the ex command.
 	 *
@@ -1607,7 +1706,9 @@ discard:	msgq(sp, M_BERR,
 		msgq(sp, M_BERR,
 		    "093|Ex command failed: mapped keys discarded");
 
-rfail:	tmp = 1;
+rfail:	if (F_ISSET(exp, EXP_RCREC))
+		F_SET(exp, EXP_RCDIRTY);
+	tmp = 1;
 	if (0)
 rsuccess:	tmp = 0;
 
@@ -2120,7 +2221,7 @@ ex_load(SCR *sp)
 			while ((rp = TAILQ_FIRST(ecp->rq)) != NULL)
 				if (rp->start > rp->stop) {
 					TAILQ_REMOVE(ecp->rq, rp, q);
-					free(rp);
+					pool_put(sp, P_RANGE, rp);
 				} else
 					break;
 
@@ -2145,7 +2246,7 @@ ex_load(SCR *sp)
 
 		/* Discard the EXCMD. */
 		SLIST_REMOVE_HEAD(gp->ecq, q);
-		free(ecp);
+		pool_put(sp, P_EXCMD, ecp);
 	}
 
 	/*
@@ -2189,12 +2290,12 @@ ex_discard(SCR *sp)
 		if (FL_ISSET(ecp->agv_flags, AGV_ALL)) {
 			while ((rp = TAILQ_FIRST(ecp->rq)) != NULL) {
 				TAILQ_REMOVE(ecp->rq, rp, q);
-				free(rp);
+				pool_put(sp, P_RANGE, rp);
 			}
 			free(ecp->o_cp);
 		}
 		SLIST_REMOVE_HEAD(gp->ecq, q);
-		free(ecp);
+		pool_put(sp, P_EXCMD, ecp);
 	}
 
 	ecp->if_name = NULL;
@@ -2202,6 +2303,98 @@ ex_discard(SCR *sp)
 	return (0);
 }
 
+/*
+ * ex_pc_hash --
+ *	Hash a command, up to its first possible separator.  Commands
+ *	that don't end there are still found, they just share the bucket.
+ */
+static u_int32_t
+ex_pc_hash(EXCMD *ecp)
+{
+	u_int32_t hash;
+	size_t len;
+	CHAR_T *p;
+
+	hash = 2166136261U;
+	for (p = ecp->cp,
+	    len = MIN(ecp->clen, EX_PC_TEXT); len > 0; --len, ++p) {
+		hash = (hash ^ (u_int32_t)*p) * 16777619U;
+		if (*p == '\n' || *p == '|')
+			break;
+	}
+	return (hash);
+}
+
+/*
+ * ex_pc_flags --
+ *	Return the state the parse of a command depends on.
+ */
+static u_int8_t
+ex_pc_flags(SCR *sp, EXCMD *ecp)
+{
+	u_int8_t flags;
+
+	flags = 0;
+	if (F_ISSET(sp, SC_VI))
+		flags |= PC_VI;
+	if (F_ISSET(ecp, E_VLITONLY))
+		flags |= PC_VLITONLY;
+	return (flags);
+}
+
+/*
+ * ex_pc_get --
+ *	Look up the parse of the command at ecp->cp.
+ */
+static EX_PCE *
+ex_pc_get(SCR *sp, EXCMD *ecp, u_int32_t *hashp)
+{
+	EX_PCE *pce;
+	u_int32_t hash;
+
+	*hashp = hash = ex_pc_hash(ecp);
+	pce = &EXP(sp)->pcache[hash & (EX_PC_SIZE - 1)];
+	if (pce->text == NULL || pce->hash != hash ||
+	    (pce->flags & (PC_VI | PC_VLITONLY)) != ex_pc_flags(sp, ecp))
+		return (NULL);
+
+	/*
+	 * A command that ran to the end of the text only matches the same
+	 * text; one ended by a separator matches any text that follows.
+	 */
+	if (pce->len > ecp->clen ||
+	    (!F_ISSET(pce, PC_TRAILING) && pce->len != ecp->clen) ||
+	    MEMCMP(pce->text, ecp->cp, pce->len))
+		return (NULL);
+	return (pce);
+}
+
+/*
+ * ex_pc_put --
+ *	Enter the parse of a command into the cache.  The original text is
+ *	at orig, the parsed text at parsed.  The cache is a hint, so memory
+ *	allocation failures are ignored.
+ */
+static void
+ex_pc_put(SCR *sp, EXCMD *ecp, EX_PCE *new, CHAR_T *orig, CHAR_T *parsed)
+{
+	EX_PCE *pce;
+	CHAR_T *text;
+
+	new->flags |= ex_pc_flags(sp, ecp);
+	pce = &EXP(sp)->pcache[new->hash & (EX_PC_SIZE - 1)];
+	if ((text = realloc(pce->text,
+	    new->len * 2 * sizeof(CHAR_T))) == NULL) {
+		free(pce->text);
+		pce->text = NULL;
+		return;
+	}
+	MEMCPY(text, orig, new->len);
+	MEMCPY(text + new->len, parsed, new->len);
+	*pce = *new;
+	pce->text = text;
+}
+
 /*
  * ex_unknown --
  *	Display an unknown command name.
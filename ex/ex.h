@@ -157,6 +157,38 @@ struct _excmd {
 	u_int32_t flags;		/* Current flags. */
 };
 
+/*
+ * Parsed command cache.  The commands of @ buffers and sourced files are
+ * often run over and over.  From the command name to the end of the
+ * command, the parse depends only on the text: which command it is, where
+ * its arguments are, and the quoting characters removed from them.  That
+ * part of the parse is kept, keyed by the text.  The addresses, the
+ * arguments themselves and file name expansion are parsed on every run.
+ */
+#define	EX_PC_SIZE	64		/* Entries, a power of 2. */
+#define	EX_PC_TEXT	256		/* Longest command kept. */
+typedef struct _ex_pce {
+	CHAR_T	*text;			/* Command text, then parsed text. */
+	size_t	 len;			/* Command length, with separator. */
+	u_int32_t hash;			/* Hash of the text. */
+	EXCMDLIST const *cmd;		/* Command, NULL if rcmd. */
+	EXCMDLIST rcmd;			/* Command table replacement. */
+	size_t	 cpoff;			/* Arguments offset. */
+	size_t	 clen;			/* Arguments length. */
+	size_t	 arg1off;		/* +cmd offset. */
+	size_t	 arg1_len;		/* +cmd length. */
+	recno_t	 nlines;		/* Escaped <newline>s. */
+
+#define	PC_FORCE	0x01		/* Force flag. */
+#define	PC_NEWLINE	0x02		/* Ended by a <newline>. */
+#define	PC_NEWSCREEN	0x04		/* Runs in a new screen. */
+#define	PC_TRAILING	0x08		/* Ended by a separator. */
+#define	PC_VIADDR	0x10		/* Vi address check. */
+#define	PC_VI		0x20		/* Parsed in vi (SC_VI). */
+#define	PC_VLITONLY	0x40		/* Parsed with E_VLITONLY. */
+	u_int8_t flags;
+} EX_PCE;
+
 /* Ex private, per-screen memory. */
 typedef struct _ex_private {
 					/* Tag file list. */
@@ -173,6 +205,8 @@ typedef struct _ex_private {
 
 	u_int32_t fdef;			/* Saved E_C_* default command flags. */
 
+	EX_PCE	 pcache[EX_PC_SIZE];	/* Parsed command cache. */
+
 	char	*ibp;			/* File line input buffer. */
 	size_t	 ibp_len;		/* File line input buffer length. */
 	CONVWIN	 ibcw;			/* File line input conversion buffer. */
@@ -189,6 +223,8 @@ typedef struct _ex_private {
 	size_t	 obp_len;		/* Ex output buffer length. */
 
 #define	EXP_CSCINIT	0x01		/* Cscope initialized. */
+#define	EXP_RCDIRTY	0x02		/* Startup run can't be cached. */
+#define	EXP_RCREC	0x04		/* Recording the startup run. */
 	u_int8_t flags;
 } EX_PRIVATE;
 #define	EXP(sp)	((EX_PRIVATE *)((sp)->ex_private))
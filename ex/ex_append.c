@@ -81,6 +81,8 @@ ex_aci(SCR *sp, EXCMD *cmdp, enum which cmd)
 
 	gp = sp->gp;
 	NEEDFILE(sp, cmdp);
+	if (db_paged(sp))
+		return (1);
 
 	/*
 	 * If doing a change, replace lines for as long as possible.  Then,
@@ -114,6 +114,7 @@ ex_next(SCR *sp, EXCMD *cmdp)
 		return (1);
 	if (noargs)
 		++sp->cargv;
+	file_prefetch(sp);
 
 	F_SET(sp, SC_FSWITCH);
 	return (0);
@@ -242,6 +243,7 @@ ex_rew(SCR *sp, EXCMD *cmdp)
 	if (file_init(sp, frp, NULL, FS_SETALT |
 	    (FL_ISSET(cmdp->iflags, E_C_FORCE) ? FS_FORCE : 0)))
 		return (1);
+	file_prefetch(sp);
 
 	/* Switch and display a file count with the welcome message. */
 	F_SET(sp, SC_FSWITCH | SC_STATUS_CNT);
@@ -78,9 +78,13 @@ ex_at(SCR *sp, EXCMD *cmdp)
 	 * the  range, continue to execute after a file/screen switch, which
 	 * means @ buffers are still useful in a multi-screen environment.
 	 */
-	CALLOC_RET(sp, ecp, 1, sizeof(EXCMD));
+	if ((ecp = pool_get(sp, P_EXCMD)) == NULL)
+		return (1);
 	TAILQ_INIT(ecp->rq);
-	CALLOC_RET(sp, rp, 1, sizeof(RANGE));
+	if ((rp = pool_get(sp, P_RANGE)) == NULL) {
+		pool_put(sp, P_EXCMD, ecp);
+		return (1);
+	}
 	rp->start = cmdp->addr1.lno;
 	if (F_ISSET(cmdp, E_ADDR_DEF)) {
 		rp->stop = rp->start;
@@ -102,7 +106,12 @@ ex_at(SCR *sp, EXCMD *cmdp)
 	TAILQ_FOREACH_REVERSE(tp, cbp->textq, _texth, q)
 		len += tp->len + 1;
 
-	MALLOC_RET(sp, ecp->cp, len * 2 * sizeof(CHAR_T));
+	MALLOC(sp, ecp->cp, len * 2 * sizeof(CHAR_T));
+	if (ecp->cp == NULL) {
+		pool_put(sp, P_RANGE, rp);
+		pool_put(sp, P_EXCMD, ecp);
+		return (1);
+	}
 	ecp->o_cp = ecp->cp;
 	ecp->o_clen = len;
 	ecp->cp[len] = '\0';
@@ -176,11 +176,21 @@ EXCMDLIST const cmds[] = {
 	    "f1o",
 	    "[Ff]g [file]",
 	    "bring a backgrounded screen into the foreground"},
+/* C_FOLLOW */
+	{L("follow"),	ex_follow,	E_VIONLY,
+	    "!",
+	    "fo[llow][!]",
+	    "follow the file as it grows"},
 /* C_GLOBAL */
 	{L("global"),	ex_global,	E_ADDR2_ALL,
 	    "!s",
 	    "[line [,line]] g[lobal][!] [;/]RE[;/] [commands]",
 	    "execute a global command on lines matching an RE"},
+/* C_GOTO */
+	{L("goto"),	ex_goto,	0,
+	    "c0",
+	    "go[to] [count]",
+	    "move to a byte offset in the file"},
 /* C_HELP */
 	{L("help"),	ex_help,	0,
 	    "",
@@ -317,11 +327,21 @@ EXCMDLIST const cmds[] = {
 	    "f1r",
 	    "so[urce] file",
 	    "read a file of ex commands"},
+/* C_SORT */
+	{L("sort"),	ex_sort,	E_ADDR2_ALL|E_ADDR_ZERODEF,
+	    "s",
+	    "[line [,line]] sor[t] [inru] [field] [/RE/]",
+	    "sort lines"},
 /* C_STOP */
 	{L("stop"),	ex_stop,	E_SECURE,
 	    "!",
 	    "st[op][!]",
 	    "suspend the edit session"},
+/* C_STATS */
+	{L("stats"),	ex_stats,	0,
+	    "!",
+	    "sta[ts][!]",
+	    "display or reset the performance counters"},
 /* C_SUSPEND */
 	{L("suspend"),	ex_stop,	E_SECURE,
 	    "!",
@@ -357,6 +377,11 @@ EXCMDLIST const cmds[] = {
 	    "!",
 	    "tagt[op][!]",
 	    "discard all tags"},
+/* C_TRACE */
+	{L("trace"),	ex_trace,	0,
+	    "!f1o",
+	    "tr[ace][!] [file]",
+	    "write or reset the trace event ring"},
 /* C_UNDO */
 	{L("undo"),	ex_undo,	E_AUTOPRINT,
 	    "",
@@ -382,6 +407,11 @@ EXCMDLIST const cmds[] = {
 	    "",
 	    "version",
 	    "display the program version information"},
+/* C_VGREP */
+	{L("vgrep"),	ex_vgrep,	0,
+	    "!s",
+	    "vg[rep][!] [;/]RE[;/] [file ...]",
+	    "search files for an RE, making the matches a tag list"},
 /* C_VISUAL_EX */
 	{L("visual"),	ex_visual,	E_ADDR1|E_ADDR_ZERODEF,
 	    "2c11",
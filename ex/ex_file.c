@@ -54,9 +54,8 @@ ex_file(SCR *sp, EXCMD *cmdp)
 		if (!F_ISSET(frp, FR_TMPFILE))
 			set_alt_name(sp, frp->name);
 
-		/* Free the previous name. */
-		free(frp->name);
-		frp->name = p;
+		/* Replace the previous name. */
+		file_setname(sp, frp, p);
 
 		/*
 		 * The file has a real name, it's no longer a temporary,
@@ -53,6 +53,10 @@ ex_filter(SCR *sp, EXCMD *cmdp, MARK *fm, MARK *tm, MARK *rp, CHAR_T *cmd, enum
 	if (rp->lno == 0)
 		rp->lno = 1;
 
+	/* Only writing to the utility leaves the file alone. */
+	if (ftype != FILTER_WRITE && db_paged(sp))
+		return (1);
+
 	/* We're going to need a shell. */
 	if (opts_empty(sp, O_SHELL, 0))
 		return (1);
@@ -0,0 +1,412 @@
+/*-
+ * Copyright (c) 2026
+ *	The nvi2 contributors.  All rights reserved.
+ *
+ * See the LICENSE file for redistribution information.
+ */
+
+#include "config.h"
+
+#include <sys/types.h>
+#include <sys/queue.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+
+#include <bitstring.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../common/common.h"
+
+/*
+ * Following a file.
+ *
+ * A followed file is checked for growth while vi waits for a command,
+ * every followtime tenths of a second.  The new bytes are read from where
+ * the last read stopped, and the complete lines among them are appended
+ * to the end of the file as a single block, without being logged.  A
+ * partial line is kept until its newline shows up.  Screens with the
+ * cursor on the last line are moved to the new last line.
+ *
+ * At most FOL_MAXREAD bytes are read each time, so a file growing faster
+ * than that is caught up over several checks instead of keeping vi from
+ * reading keys, and the read buffer stays bounded.  If the file shrinks,
+ * it's followed from its start, and if it's replaced, e.g., a log being
+ * rotated, the new file is followed once the old one has been read.
+ */
+#define	FOL_MAXREAD	(4 * 1024 * 1024)
+
+typedef struct {
+	char	*name;			/* File name. */
+	int	 fd;			/* File descriptor. */
+	dev_t	 dev;			/* Device. */
+	ino_t	 ino;			/* Inode. */
+	off_t	 off;			/* Offset of the next read. */
+	int	 replace;		/* The last line isn't complete. */
+
+	char	*bp;			/* Read buffer. */
+	size_t	 blen;			/* Read buffer length. */
+	size_t	 len;			/* Bytes of a partial line. */
+} FOLLOW;
+
+static int	fol_read(SCR *, FOLLOW *, int *);
+static int	fol_reopen(SCR *, FOLLOW *);
+static int	fol_start(SCR *, FOLLOW *);
+
+/*
+ * ex_follow -- :fo[llow][!]
+ *	Follow the file as it grows, or with !, stop following it.
+ *
+ * PUBLIC: int ex_follow(SCR *, EXCMD *);
+ */
+int
+ex_follow(SCR *sp, EXCMD *cmdp)
+{
+	struct stat sb;
+	FOLLOW *fp;
+	EXF *ep;
+
+	NEEDFILE(sp, cmdp);
+	ep = sp->ep;
+
+	if (FL_ISSET(cmdp->iflags, E_C_FORCE)) {
+		fol_end(ep);
+		return (0);
+	}
+	if (ep->follow != NULL)
+		return (0);
+	if (F_ISSET(sp->frp, FR_TMPFILE)) {
+		msgq(sp, M_ERR, "325|The file has no name to follow");
+		return (1);
+	}
+	if (db_paged(sp))
+		return (1);
+
+	CALLOC_RET(sp, fp, 1, sizeof(FOLLOW));
+	if ((fp->name = strdup(sp->frp->name)) == NULL) {
+		free(fp);
+		msgq(sp, M_SYSERR, NULL);
+		return (1);
+	}
+	if ((fp->fd = open(fp->name, O_RDONLY | O_NONBLOCK)) == -1 ||
+	    fstat(fp->fd, &sb)) {
+		msgq_str(sp, M_SYSERR, fp->name, "%s");
+		goto err;
+	}
+	if (!S_ISREG(sb.st_mode)) {
+		msgq_str(sp, M_ERR, fp->name, "326|%s is not a regular file");
+		goto err;
+	}
+	fp->dev = sb.st_dev;
+	fp->ino = sb.st_ino;
+	if (fol_start(sp, fp))
+		goto err;
+
+	ep->follow = fp;
+	F_SET(sp->gp, G_FOLLOW);
+	return (0);
+
+err:	if (fp->fd != -1)
+		(void)close(fp->fd);
+	free(fp->name);
+	free(fp);
+	return (1);
+}
+
+/*
+ * fol_start --
+ *	Find the offset in the file where the lines being edited end.
+ */
+static int
+fol_start(SCR *sp, FOLLOW *fp)
+{
+	struct stat sb;
+	recno_t cnt, last, lno;
+	off_t off;
+	size_t len, nlen;
+	CHAR_T *p;
+	char ch, *np;
+
+	/*
+	 * If the lines have been changed, the file was read too long ago to
+	 * know where they end, and following starts at the end of the file.
+	 */
+	if (F_ISSET(sp->ep, F_MODIFIED)) {
+		if (fstat(fp->fd, &sb)) {
+			msgq_str(sp, M_SYSERR, fp->name, "%s");
+			return (1);
+		}
+		fp->off = sb.st_size;
+		return (0);
+	}
+
+	/*
+	 * Otherwise, the lines are the start of the file, add up their
+	 * lengths as they were read.
+	 */
+	if (db_last(sp, &last))
+		return (1);
+	cnt = INTERRUPT_CHECK;
+	for (off = 0, nlen = 0, lno = 1; lno <= last; ++lno) {
+		if (cnt-- == 0) {
+			if (INTERRUPTED(sp))
+				return (1);
+			cnt = INTERRUPT_CHECK;
+		}
+		if (db_get(sp, lno, DBG_FATAL, &p, &len))
+			return (1);
+		INT2FILE(sp, p, len, np, nlen);
+		off += nlen + 1;
+	}
+
+	/*
+	 * If the last line was read before its newline was written, read it
+	 * again, and replace it once it's complete.
+	 */
+	if (last != 0 &&
+	    (pread(fp->fd, &ch, 1, off - 1) != 1 || ch != '\n')) {
+		off -= nlen + 1;
+		fp->replace = 1;
+	}
+	fp->off = off;
+	return (0);
+}
+
+/*
+ * fol_input --
+ *	Read any new lines of the followed files, returning 1 if any of
+ *	the files changed.
+ *
+ * PUBLIC: int fol_input(SCR *);
+ */
+int
+fol_input(SCR *sp)
+{
+	GS *gp;
+	SCR *tsp;
+	int changed, following;
+
+	gp = sp->gp;
+	changed = following = 0;
+	TAILQ_FOREACH(sp, gp->dq, q) {
+		if (sp->ep == NULL || sp->ep->follow == NULL)
+			continue;
+
+		/* Read each file once, for the first screen showing it. */
+		TAILQ_FOREACH(tsp, gp->dq, q)
+			if (tsp == sp || tsp->ep == sp->ep)
+				break;
+		if (tsp != sp)
+			continue;
+
+		/* On error, stop following the file. */
+		if (fol_read(sp, sp->ep->follow, &changed)) {
+			fol_end(sp->ep);
+			changed = 1;
+		} else
+			following = 1;
+	}
+	if (!following)
+		F_CLR(gp, G_FOLLOW);
+	return (changed);
+}
+
+/*
+ * fol_read --
+ *	Read the new lines of a followed file.
+ */
+static int
+fol_read(SCR *sp, FOLLOW *fp, int *changedp)
+{
+	struct stat sb;
+	EX_PRIVATE *exp;
+	EXF *ep;
+	SCR *tsp;
+	recno_t cnt, last;
+	size_t blen, len, rlen, wlen;
+	ssize_t nr;
+	int ismod, nolog, rval;
+	char *bp, *p, *t;
+	CHAR_T *wp;
+
+	ep = sp->ep;
+	if (fstat(fp->fd, &sb)) {
+		msgq_str(sp, M_SYSERR, fp->name, "%s");
+		return (1);
+	}
+	if (sb.st_size < fp->off) {
+		msgq_str(sp, M_INFO, fp->name,
+		    "328|%s: file truncated, following it from the start");
+		*changedp = 1;
+		fp->off = 0;
+		fp->len = 0;
+		fp->replace = 0;
+	}
+	if (sb.st_size == fp->off) {
+		if (fol_reopen(sp, fp))
+			*changedp = 1;
+		return (0);
+	}
+
+	/* Read the new bytes after any partial line. */
+	len = MIN(sb.st_size - fp->off, FOL_MAXREAD);
+	if (fp->len + len > fp->blen) {
+		if ((p = realloc(fp->bp, fp->len + len)) == NULL) {
+			msgq(sp, M_SYSERR, NULL);
+			return (1);
+		}
+		fp->bp = p;
+		fp->blen = fp->len + len;
+	}
+	for (; len > 0; len -= nr, fp->len += nr, fp->off += nr)
+		if ((nr = pread(fp->fd,
+		    fp->bp + fp->len, len, fp->off)) <= 0) {
+			if (nr == 0)
+				break;
+			msgq_str(sp, M_SYSERR, fp->name, "%s");
+			return (1);
+		}
+
+	/* Find and count the complete lines. */
+	for (len = fp->len; len > 0 && fp->bp[len - 1] != '\n'; --len);
+	if (len == 0)
+		return (0);
+	for (cnt = 0, p = fp->bp; p < fp->bp + len; ++p)
+		if (*p == '\n')
+			++cnt;
+
+	/*
+	 * If the lines were changed since the last line was read, it's
+	 * no longer the line to complete.
+	 */
+	if (fp->replace && F_ISSET(ep, F_MODIFIED))
+		fp->replace = 0;
+
+	if (db_last(sp, &last))
+		return (1);
+	GET_SPACE_RETC(sp, bp, blen, len + cnt * sizeof(size_t));
+
+	/* The lines aren't logged. */
+	ismod = F_ISSET(ep, F_MODIFIED);
+	nolog = F_ISSET(ep, F_NOLOG);
+	F_SET(ep, F_NOLOG);
+	rval = 1;
+
+	p = fp->bp;
+	if (fp->replace) {
+		exp = EXP(sp);
+		t = memchr(p, '\n', len);
+		if (FILE2INT5(sp, exp->ibcw, p, t - p, wp, wlen)) {
+			msgq(sp, M_ERR, "323|Invalid input. Truncated.");
+			goto err;
+		}
+		if (db_set(sp, last, wp, wlen))
+			goto err;
+		p = t + 1;
+		--cnt;
+		fp->replace = 0;
+	}
+
+	/* Append the rest as records, each preceded by its length. */
+	for (rlen = 0; p < fp->bp + len; p = t + 1) {
+		t = memchr(p, '\n', fp->bp + len - p);
+		wlen = t - p;
+		memmove(bp + rlen, &wlen, sizeof(size_t));
+		memmove(bp + rlen + sizeof(size_t), p, wlen);
+		rlen += sizeof(size_t) + wlen;
+	}
+	if (cnt != 0 && db_rappend(sp, last, cnt, bp, rlen))
+		goto err;
+
+	/* Screens at the end of the file stay there. */
+	if (cnt != 0)
+		TAILQ_FOREACH(tsp, sp->gp->dq, q)
+			if (tsp->ep == ep && tsp->lno >= last) {
+				tsp->lno = last + cnt;
+				tsp->cno = 0;
+			}
+
+	memmove(fp->bp, fp->bp + len, fp->len - len);
+	fp->len -= len;
+
+	/*
+	 * If the file wasn't modified, it still isn't, and once all of it
+	 * has been read, it's as recent as the file.
+	 */
+	if (!ismod)
+		F_CLR(ep, F_MODIFIED);
+	if (!ismod && fp->len == 0 &&
+	    fp->dev == ep->mdev && fp->ino == ep->minode) {
+#if defined HAVE_STRUCT_STAT_ST_MTIMESPEC
+		ep->mtim = sb.st_mtimespec;
+#elif defined HAVE_STRUCT_STAT_ST_MTIM
+		ep->mtim = sb.st_mtim;
+#else
+		ep->mtim.tv_sec = sb.st_mtime;
+		ep->mtim.tv_nsec = 0;
+#endif
+	}
+	*changedp = 1;
+	rval = 0;
+
+err:	if (!nolog)
+		F_CLR(ep, F_NOLOG);
+	FREE_SPACE(sp, bp, blen);
+	return (rval);
+}
+
+/*
+ * fol_reopen --
+ *	If the file has been read and another file has replaced it, start
+ *	following the new file.
+ */
+static int
+fol_reopen(SCR *sp, FOLLOW *fp)
+{
+	struct stat sb;
+	int fd;
+
+	if (stat(fp->name, &sb) ||
+	    (sb.st_dev == fp->dev && sb.st_ino == fp->ino))
+		return (0);
+	if ((fd = open(fp->name, O_RDONLY | O_NONBLOCK)) == -1 ||
+	    fstat(fd, &sb)) {
+		if (fd != -1)
+			(void)close(fd);
+		return (0);
+	}
+	msgq_str(sp, M_INFO, fp->name, "327|%s: file replaced, following it");
+	(void)close(fp->fd);
+	fp->fd = fd;
+	fp->dev = sb.st_dev;
+	fp->ino = sb.st_ino;
+	fp->off = 0;
+	fp->len = 0;
+	fp->replace = 0;
+	return (1);
+}
+
+/*
+ * fol_end --
+ *	Stop following a file.
+ *
+ * PUBLIC: void fol_end(EXF *);
+ */
+void
+fol_end(EXF *ep)
+{
+	FOLLOW *fp;
+
+	if ((fp = ep->follow) == NULL)
+		return;
+	(void)close(fp->fd);
+	free(fp->name);
+	free(fp->bp);
+	free(fp);
+	ep->follow = NULL;
+}
@@ -154,7 +154,8 @@ usage:		ex_emsg(sp, cmdp->cmd->usage, EXM_USAGE);
 		return (1);
 
 	/* Get an EXCMD structure. */
-	CALLOC_RET(sp, ecp, 1, sizeof(EXCMD));
+	if ((ecp = pool_get(sp, P_EXCMD)) == NULL)
+		return (1);
 	TAILQ_INIT(ecp->rq);
 
 	/*
@@ -169,7 +170,11 @@ usage:		ex_emsg(sp, cmdp->cmd->usage, EXM_USAGE);
 		len = 1;
 	}
 
-	MALLOC_RET(sp, ecp->cp, (len * 2) * sizeof(CHAR_T));
+	MALLOC(sp, ecp->cp, (len * 2) * sizeof(CHAR_T));
+	if (ecp->cp == NULL) {
+		pool_put(sp, P_EXCMD, ecp);
+		return (1);
+	}
 	ecp->o_cp = ecp->cp;
 	ecp->o_clen = len;
 	MEMCPY(ecp->cp + len, p, len);
@@ -196,8 +201,12 @@ usage:		ex_emsg(sp, cmdp->cmd->usage, EXM_USAGE);
 		if (cnt-- == 0) {
 			if (INTERRUPTED(sp)) {
 				SLIST_REMOVE_HEAD(sp->gp->ecq, q);
+				while ((rp = TAILQ_FIRST(ecp->rq)) != NULL) {
+					TAILQ_REMOVE(ecp->rq, rp, q);
+					pool_put(sp, P_RANGE, rp);
+				}
 				free(ecp->cp);
-				free(ecp);
+				pool_put(sp, P_EXCMD, ecp);
 				break;
 			}
 			search_busy(sp, btype);
@@ -209,7 +218,7 @@ usage:		ex_emsg(sp, cmdp->cmd->usage, EXM_USAGE);
 		match[0].rm_so = 0;
 		match[0].rm_eo = len;
 		switch (eval =
-		    regexec(&sp->re_c, dbp, 0, match, REG_STARTEND)) {
+		    re_exec(sp, &sp->re_c, dbp, 0, match, REG_STARTEND)) {
 		case 0:
 			if (cmd == V)
 				continue;
@@ -231,8 +240,7 @@ usage:		ex_emsg(sp, cmdp->cmd->usage, EXM_USAGE);
 		}
 
 		/* Allocate a new range, and append it to the list. */
-		CALLOC(sp, rp, 1, sizeof(RANGE));
-		if (rp == NULL)
+		if ((rp = pool_get(sp, P_RANGE)) == NULL)
 			return (1);
 		rp->start = rp->stop = start;
 		TAILQ_INSERT_TAIL(ecp->rq, rp, q);
@@ -292,10 +300,11 @@ ex_g_insdel(SCR *sp, lnop_t op, recno_t lno)
 			if (op == LINE_DELETE) {
 				if (rp->start > --rp->stop) {
 					TAILQ_REMOVE(ecp->rq, rp, q);
-					free(rp);
+					pool_put(sp, P_RANGE, rp);
 				}
 			} else {
-				CALLOC_RET(sp, nrp, 1, sizeof(RANGE));
+				if ((nrp = pool_get(sp, P_RANGE)) == NULL)
+					return (1);
 				nrp->start = lno + 1;
 				nrp->stop = rp->stop + 1;
 				rp->stop = lno - 1;
@@ -0,0 +1,107 @@
+/*-
+ * Copyright (c) 2026
+ *	The nvi2 contributors.  All rights reserved.
+ *
+ * See the LICENSE file for redistribution information.
+ */
+
+#include "config.h"
+
+#include <sys/types.h>
+#include <sys/queue.h>
+#include <sys/time.h>
+
+#include <bitstring.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "../common/common.h"
+
+static size_t goto_cno(SCR *, CHAR_T *, size_t, uint64_t);
+
+/*
+ * ex_goto -- :go[to] [count]
+ *	Move to the count'th byte of the file.
+ *
+ * PUBLIC: int ex_goto(SCR *, EXCMD *);
+ */
+int
+ex_goto(SCR *sp, EXCMD *cmdp)
+{
+	MARK abs;
+	recno_t last, lno;
+	uint64_t byte, col, pos;
+	size_t cnt, len, nlen;
+	CHAR_T *p;
+	char *np;
+
+	NEEDFILE(sp, cmdp);
+
+	/* Byte offsets count from 1, like line numbers. */
+	byte = FL_ISSET(cmdp->iflags, E_C_COUNT) && cmdp->count > 0 ?
+	    cmdp->count - 1 : 0;
+
+	if (db_last(sp, &last))
+		return (1);
+	if (last == 0)
+		return (0);
+
+	/*
+	 * If the file hasn't changed since it was read and has a line offset
+	 * index, find the line from the index.  Otherwise, add up the lines
+	 * as they'd be written.
+	 */
+	if (lidx_offset(sp, byte, &lno, &col)) {
+		cnt = INTERRUPT_CHECK;
+		for (lno = 1, pos = 0;; ++lno) {
+			if (cnt-- == 0) {
+				if (INTERRUPTED(sp))
+					return (1);
+				cnt = INTERRUPT_CHECK;
+			}
+			if (db_get(sp, lno, DBG_FATAL, &p, &len))
+				return (1);
+			INT2FILE(sp, p, len, np, nlen);
+			if (byte <= pos + nlen || lno == last)
+				break;
+			pos += nlen + 1;
+		}
+		col = byte - pos;
+	}
+	if (db_get(sp, lno, DBG_FATAL, &p, &len))
+		return (1);
+
+	abs.lno = sp->lno;
+	abs.cno = sp->cno;
+	(void)mark_set(sp, ABSMARK1, &abs, 1);
+
+	sp->lno = lno;
+	sp->cno = goto_cno(sp, p, len, col);
+	return (0);
+}
+
+/*
+ * goto_cno --
+ *	Return the character holding byte col of the written line.
+ */
+static size_t
+goto_cno(SCR *sp, CHAR_T *p, size_t len, uint64_t col)
+{
+	size_t hi, lo, mid, nlen;
+	char *np;
+
+	/*
+	 * The written length of the first n characters grows with n, find
+	 * the last character starting at or before the byte.
+	 */
+	for (lo = 0, hi = len; hi - lo > 1;) {
+		mid = lo + (hi - lo) / 2;
+		INT2FILE(sp, p, mid, np, nlen);
+		if (nlen <= col)
+			lo = mid;
+		else
+			hi = mid;
+	}
+	return (lo);
+}
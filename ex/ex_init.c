@@ -16,6 +16,7 @@
 #include <bitstring.h>
 #include <fcntl.h>
 #include <limits.h>
+#include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -28,6 +29,37 @@
 enum rc { NOEXIST, NOPERM, RCOK };
 static enum rc	exrc_isok(SCR *, struct stat *, char *, int, int);
 
+/*
+ * Startup cache.
+ *
+ * If the startup files set the exrccache option, the options, maps and
+ * abbreviations they leave behind are written to $HOME/.nexrc.cache, along
+ * with the environment variables and the stat(2) information of every
+ * startup file that was looked at.  Later sessions replay that state rather
+ * than executing the startup files, as long as none of the recorded inputs
+ * have changed.  Startup runs that execute anything other than set, map
+ * and abbreviate commands, or that fail, aren't cached.
+ */
+#define	RCC_MAGIC	"nvi startup cache 1"
+
+typedef struct {
+	char	*bp;			/* Record buffer. */
+	size_t	 blen;			/* Record buffer length. */
+	size_t	 len;			/* Record length. */
+	int	 error;			/* Allocation failed. */
+} RCBUF;
+
+static RCBUF rcin;			/* Inputs of the recorded run. */
+
+static void	rcc_add(RCBUF *, const char *, size_t);
+static void	rcc_env(RCBUF *, char *);
+static int	rcc_exec(SCR *, char *, size_t, int);
+static void	rcc_fmt(RCBUF *, const char *, ...);
+static int	rcc_load(SCR *, char *);
+static void	rcc_probe(RCBUF *, char *, struct stat *);
+static void	rcc_save(SCR *, char *, u_long *, char **);
+
+static int ex_exrc_run(SCR *);
 static int ex_run_file(SCR *, char *);
 
 /*
@@ -76,7 +108,7 @@ int
 ex_screen_end(SCR *sp)
 {
 	EX_PRIVATE *exp;
-	int rval;
+	int cnt, rval;
 
 	if ((exp = EXP(sp)) == NULL)
 		return (0);
@@ -96,6 +128,9 @@ ex_screen_end(SCR *sp)
 
 	free(exp->ibcw.bp1.c);
 
+	for (cnt = 0; cnt < EX_PC_SIZE; ++cnt)
+		free(exp->pcache[cnt].text);
+
 	if (ex_tag_free(sp))
 		rval = 1;
 
@@ -134,6 +169,67 @@ ex_optchange(SCR *sp, int offset, char *str, u_long *valp)
  */
 int
 ex_exrc(SCR *sp)
+{
+	EX_PRIVATE *exp;
+	OPTLIST const *op;
+	u_long oval[O_OPTIONCOUNT];
+	int cnt, rval;
+	char *cpath, *p, *ostr[O_OPTIONCOUNT];
+
+	if ((p = getenv("HOME")) == NULL || *p == '\0')
+		return (ex_exrc_run(sp));
+	if ((cpath = join(p, _PATH_NEXRCCACHE)) == NULL) {
+		msgq(sp, M_SYSERR, NULL);
+		return (1);
+	}
+	if (!rcc_load(sp, cpath)) {
+		free(cpath);
+		return (0);
+	}
+
+	/* Remember the option values, and record the startup run. */
+	for (op = optlist, cnt = 0; op->name != NULL; ++op, ++cnt) {
+		oval[cnt] = O_VAL(sp, cnt);
+		ostr[cnt] = NULL;
+		if (op->type == OPT_STR && O_STR(sp, cnt) != NULL &&
+		    (ostr[cnt] = strdup(O_STR(sp, cnt))) == NULL)
+			rcin.error = 1;
+	}
+	exp = EXP(sp);
+	F_CLR(exp, EXP_RCDIRTY);
+	F_SET(exp, EXP_RCREC);
+
+	/* Only maps from the startup files can be told apart. */
+	if (SLIST_FIRST(sp->gp->seqq) != NULL)
+		F_SET(exp, EXP_RCDIRTY);
+	rcin.len = 0;
+	rcc_fmt(&rcin, "u %lu\n", (u_long)geteuid());
+	rcc_env(&rcin, "NEXINIT");
+	rcc_env(&rcin, "EXINIT");
+	rcc_env(&rcin, "HOME");
+
+	rval = ex_exrc_run(sp);
+
+	F_CLR(exp, EXP_RCREC);
+	if (!rval && O_ISSET(sp, O_EXRCCACHE) && !rcin.error &&
+	    !F_ISSET(exp, EXP_RCDIRTY) &&
+	    !F_ISSET(sp, SC_EXIT | SC_EXIT_FORCE))
+		rcc_save(sp, cpath, oval, ostr);
+
+	for (cnt = 0; cnt < O_OPTIONCOUNT; ++cnt)
+		free(ostr[cnt]);
+	free(rcin.bp);
+	memset(&rcin, 0, sizeof(rcin));
+	free(cpath);
+	return (rval);
+}
+
+/*
+ * ex_exrc_run --
+ *	Execute the startup sources.
+ */
+static int
+ex_exrc_run(SCR *sp)
 {
 	struct stat hsb, lsb;
 	char *p, *path;
@@ -284,7 +380,8 @@ ex_run_str(SCR *sp, char *name, CHAR_T *str, size_t len, int ex_flags, int nocop
 
 	gp = sp->gp;
 	if (EXCMD_RUNNING(gp)) {
-		CALLOC_RET(sp, ecp, 1, sizeof(EXCMD));
+		if ((ecp = pool_get(sp, P_EXCMD)) == NULL)
+			return (1);
 		SLIST_INSERT_HEAD(gp->ecq, ecp, q);
 	} else
 		ecp = &gp->excmd;
@@ -356,8 +453,13 @@ exrc_isok(SCR *sp, struct stat *sbp, char *path, int rootown, int rootid)
 	char *a, *b, *buf;
 
 	/* Check for the file's existence. */
-	if (stat(path, sbp))
+	if (stat(path, sbp)) {
+		if (F_ISSET(EXP(sp), EXP_RCREC))
+			rcc_probe(&rcin, path, NULL);
 		return (NOEXIST);
+	}
+	if (F_ISSET(EXP(sp), EXP_RCREC))
+		rcc_probe(&rcin, path, sbp);
 
 	/* Check ownership permissions. */
 	euid = geteuid();
@@ -374,7 +476,11 @@ exrc_isok(SCR *sp, struct stat *sbp, char *path, int rootown, int rootid)
 	}
 	return (RCOK);
 
-denied:	a = msg_print(sp, path, &nf1);
+denied:	/* The cache would lose the error message. */
+	if (F_ISSET(EXP(sp), EXP_RCREC))
+		F_SET(EXP(sp), EXP_RCDIRTY);
+
+	a = msg_print(sp, path, &nf1);
 	if (strchr(path, '/') == NULL && (buf = getcwd(NULL, 0)) != NULL) {
 		char *p;
 
@@ -421,3 +527,338 @@ err:		free(buf);
 		FREE_SPACE(sp, a, 0);
 	return (NOPERM);
 }
+
+/*
+ * rcc_load --
+ *	Restore the startup state from the cache file, if it's current.
+ *	Returns 0 if the startup files don't need to be run.
+ */
+static int
+rcc_load(SCR *sp, char *path)
+{
+	struct stat sb;
+	RCBUF tmp;
+	ssize_t nr;
+	size_t len;
+	int fd, rval;
+	char *bp, *ep, *p;
+
+	if ((fd = open(path, O_RDONLY)) < 0)
+		return (1);
+
+	/* The cache file has to be as trustworthy as a $HOME .exrc file. */
+	bp = NULL;
+	rval = 1;
+	if (fstat(fd, &sb) || !S_ISREG(sb.st_mode) ||
+	    (sb.st_uid != geteuid() && geteuid() != 0) ||
+	    sb.st_mode & (S_IWGRP | S_IWOTH) || sb.st_size > 1024 * 1024 ||
+	    (bp = malloc(sb.st_size + 1)) == NULL)
+		goto err;
+	for (len = 0; len < (size_t)sb.st_size; len += nr)
+		if ((nr = read(fd, bp + len, sb.st_size - len)) <= 0)
+			goto err;
+	bp[len] = '\0';
+	ep = bp + len;
+
+	/*
+	 * Compare each recorded input against the current one, then check
+	 * the saved state is well-formed before changing anything.
+	 */
+	memset(&tmp, 0, sizeof(tmp));
+	rcc_fmt(&tmp, RCC_MAGIC " %d\n", (int)sizeof(CHAR_T));
+	for (p = bp;;) {
+		if (tmp.error || tmp.len > (size_t)(ep - p) ||
+		    memcmp(p, tmp.bp, tmp.len))
+			break;
+		p += tmp.len;
+		tmp.len = 0;
+		if (*p == 'u')
+			rcc_fmt(&tmp, "u %lu\n", (u_long)geteuid());
+		else if (*p == 'e') {
+			char name[32];
+
+			if (sscanf(p, "e %31[A-Z_] ", name) != 1)
+				break;
+			rcc_env(&tmp, name);
+		} else if (*p == 'f') {
+			char *fp, *t;
+
+			if (sscanf(p, "f %zu ", &len) != 1 ||
+			    (t = memchr(p, '\n', ep - p)) == NULL ||
+			    len >= (size_t)(ep - t) ||
+			    (fp = strndup(t + 1, len)) == NULL)
+				break;
+			rcc_probe(&tmp, fp, stat(fp, &sb) ? NULL : &sb);
+			free(fp);
+		} else {
+			if (!rcc_exec(sp, p, ep - p, 0))
+				rval = rcc_exec(sp, p, ep - p, 1);
+			break;
+		}
+	}
+	free(tmp.bp);
+
+err:	free(bp);
+	(void)close(fd);
+	return (rval);
+}
+
+/*
+ * rcc_exec --
+ *	Check, or replay, the option and map records of the cache file.
+ */
+static int
+rcc_exec(SCR *sp, char *p, size_t len, int apply)
+{
+	ARGS *argv[2], a, b;
+	CHAR_T *wp;
+	size_t nlen, ilen, olen, wlen;
+	int flags, hasname, hasout, rval, stype;
+	char *ep, *s, *t;
+
+	for (ep = p + len;; p = t + 1) {
+		if ((t = memchr(p, '\n', ep - p)) == NULL)
+			return (1);
+		switch (*p) {
+		case '.':
+			return (t != p + 1 || t + 1 != ep);
+		case 'o':
+			if (sscanf(p, "o %zu\n", &len) != 1 ||
+			    len >= (size_t)(ep - t) || t[len + 1] != '\n')
+				return (1);
+			if (apply) {
+				if ((s = strndup(t + 1, len)) == NULL)
+					return (1);
+				CHAR2INT(sp, s, len + 1, wp, wlen);
+				a.bp = wp;
+				a.blen = wlen;
+				a.len = wlen - 1;
+				a.flags = 0;
+				b.bp = NULL;
+				b.len = 0;
+				argv[0] = &a;
+				argv[1] = &b;
+				rval = opts_set(sp, argv, NULL);
+				free(s);
+				if (rval)
+					return (1);
+			}
+			t += len + 1;
+			break;
+		case 'm':
+			if (sscanf(p, "m %d %d %d %zu %zu %d %zu\n", &stype,
+			    &flags, &hasname, &nlen, &ilen, &hasout, &olen) != 7 ||
+			    nlen > (size_t)(ep - t) || ilen > (size_t)(ep - t) ||
+			    olen > (size_t)(ep - t) || ilen == 0 ||
+			    (len = (nlen + ilen + olen) * sizeof(CHAR_T)) >=
+			    (size_t)(ep - t) || t[len + 1] != '\n')
+				return (1);
+			if (apply) {
+				/* Copy out, the records aren't aligned. */
+				if ((wp = malloc(len)) == NULL)
+					return (1);
+				memcpy(wp, t + 1, len);
+				rval = seq_set(sp, hasname ? wp : NULL, nlen,
+				    wp + nlen, ilen, hasout ? wp + nlen + ilen :
+				    NULL, olen, stype, flags);
+				free(wp);
+				if (rval)
+					return (1);
+			}
+			t += len + 1;
+			break;
+		default:
+			return (1);
+		}
+	}
+	/* NOTREACHED */
+}
+
+/*
+ * rcc_save --
+ *	Write the state left behind by the startup files to the cache file.
+ */
+static void
+rcc_save(SCR *sp, char *path, u_long *oval, char **ostr)
+{
+	OPTLIST const *op;
+	RCBUF out, val;
+	SEQ *qp;
+	size_t nlen;
+	int cnt, fd;
+	char *np, *tpath;
+
+	memset(&out, 0, sizeof(out));
+	memset(&val, 0, sizeof(val));
+	tpath = NULL;
+	rcc_fmt(&out, RCC_MAGIC " %d\n", (int)sizeof(CHAR_T));
+	rcc_add(&out, rcin.bp, rcin.len);
+
+	/* Options that were changed, as arguments to the set command. */
+	for (op = optlist, cnt = 0; op->name != NULL; ++op, ++cnt) {
+		if (op->type == OPT_STR) {
+			if (O_STR(sp, cnt) == ostr[cnt] || (ostr[cnt] != NULL &&
+			    O_STR(sp, cnt) != NULL &&
+			    !strcmp(O_STR(sp, cnt), ostr[cnt])))
+				continue;
+			if (O_STR(sp, cnt) == NULL)
+				goto err;
+		} else if (O_VAL(sp, cnt) == oval[cnt])
+			continue;
+		INT2CHAR(sp, op->name, STRLEN(op->name) + 1, np, nlen);
+		val.len = 0;
+		switch (op->type) {
+		case OPT_0BOOL:
+		case OPT_1BOOL:
+			rcc_fmt(&val, "%s%s", O_ISSET(sp, cnt) ? "" : "no", np);
+			break;
+		case OPT_NUM:
+			rcc_fmt(&val, "%s=%lu", np, O_VAL(sp, cnt));
+			break;
+		case OPT_STR:
+			rcc_fmt(&val, "%s=%s", np, O_STR(sp, cnt));
+			break;
+		}
+		rcc_fmt(&out, "o %zu\n", val.len);
+		rcc_add(&out, val.bp, val.len);
+		rcc_add(&out, "\n", 1);
+	}
+
+	/* Maps and abbreviations. */
+	SLIST_FOREACH(qp, sp->gp->seqq, q) {
+		if (!F_ISSET(qp, SEQ_USERDEF))
+			continue;
+		rcc_fmt(&out, "m %d %d %d %zu %zu %d %zu\n", (int)qp->stype,
+		    (int)qp->flags, qp->name != NULL, qp->name == NULL ?
+		    0 : qp->nlen, qp->ilen, qp->output != NULL, qp->olen);
+		if (qp->name != NULL)
+			rcc_add(&out,
+			    (char *)qp->name, qp->nlen * sizeof(CHAR_T));
+		rcc_add(&out, (char *)qp->input, qp->ilen * sizeof(CHAR_T));
+		if (qp->output != NULL)
+			rcc_add(&out,
+			    (char *)qp->output, qp->olen * sizeof(CHAR_T));
+		rcc_add(&out, "\n", 1);
+	}
+	rcc_add(&out, ".\n", 2);
+	if (out.error || val.error)
+		goto err;
+
+	/* Replace the cache file atomically, it may be read concurrently. */
+	if ((tpath = join(path, "XXXXXX")) == NULL)
+		goto err;
+	tpath[strlen(path)] = '.';
+	if ((fd = mkstemp(tpath)) < 0)
+		goto serr;
+	if (write(fd, out.bp, out.len) != (ssize_t)out.len) {
+		(void)close(fd);
+		(void)unlink(tpath);
+		goto serr;
+	}
+	if (close(fd) || rename(tpath, path)) {
+		(void)unlink(tpath);
+serr:		msgq_str(sp, M_SYSERR, path, "%s");
+	}
+
+err:	free(tpath);
+	free(out.bp);
+	free(val.bp);
+}
+
+/*
+ * rcc_probe --
+ *	Add the record of a stat(2) of a startup file.
+ */
+static void
+rcc_probe(RCBUF *rp, char *path, struct stat *sbp)
+{
+	struct timespec ts;
+
+	if (sbp == NULL)
+		rcc_fmt(rp, "f %zu -\n", strlen(path));
+	else {
+#if defined HAVE_STRUCT_STAT_ST_MTIMESPEC
+		ts = sbp->st_mtimespec;
+#elif defined HAVE_STRUCT_STAT_ST_MTIM
+		ts = sbp->st_mtim;
+#else
+		ts.tv_sec = sbp->st_mtime;
+		ts.tv_nsec = 0;
+#endif
+		rcc_fmt(rp, "f %zu %llu %llu %lld %lld.%09ld %lu %lo\n",
+		    strlen(path), (unsigned long long)sbp->st_dev,
+		    (unsigned long long)sbp->st_ino, (long long)sbp->st_size,
+		    (long long)ts.tv_sec, (long)ts.tv_nsec,
+		    (u_long)sbp->st_uid, (u_long)sbp->st_mode);
+	}
+	rcc_add(rp, path, strlen(path));
+	rcc_add(rp, "\n", 1);
+}
+
+/*
+ * rcc_env --
+ *	Add the record of an environment variable.
+ */
+static void
+rcc_env(RCBUF *rp, char *name)
+{
+	char *p;
+
+	if ((p = getenv(name)) == NULL)
+		rcc_fmt(rp, "e %s -\n", name);
+	else {
+		rcc_fmt(rp, "e %s %zu\n", name, strlen(p));
+		rcc_add(rp, p, strlen(p));
+		rcc_add(rp, "\n", 1);
+	}
+}
+
+/*
+ * rcc_fmt --
+ *	Append formatted text to a record buffer.
+ */
+static void
+rcc_fmt(RCBUF *rp, const char *fmt, ...)
+{
+	va_list ap;
+	int len;
+
+	va_start(ap, fmt);
+	len = vsnprintf(NULL, 0, fmt, ap);
+	va_end(ap);
+	if (len < 0) {
+		rp->error = 1;
+		return;
+	}
+	rcc_add(rp, NULL, len + 1);
+	if (rp->error)
+		return;
+	va_start(ap, fmt);
+	(void)vsnprintf(rp->bp + rp->len - len - 1, len + 1, fmt, ap);
+	va_end(ap);
+	--rp->len;
+}
+
+/*
+ * rcc_add --
+ *	Append bytes to a record buffer, or just make room for them.
+ */
+static void
+rcc_add(RCBUF *rp, const char *p, size_t len)
+{
+	size_t blen;
+	char *bp;
+
+	if (rp->len + len > rp->blen) {
+		blen = MAX(rp->blen * 2, rp->len + len + 256);
+		if ((bp = realloc(rp->bp, blen)) == NULL) {
+			rp->error = 1;
+			return;
+		}
+		rp->bp = bp;
+		rp->blen = blen;
+	}
+	if (p != NULL)
+		memcpy(rp->bp + rp->len, p, len);
+	rp->len += len;
+}
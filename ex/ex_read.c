@@ -53,6 +53,8 @@ ex_read(SCR *sp, EXCMD *cmdp)
 	char *p;
 
 	gp = sp->gp;
+	if (db_paged(sp))
+		return (1);
 
 	/*
 	 * 0 args: read the current pathname.
@@ -212,10 +214,8 @@ ex_read(SCR *sp, EXCMD *cmdp)
 			 */
 			if (F_ISSET(sp->frp, FR_TMPFILE) &&
 			    !F_ISSET(sp->frp, FR_EXNAMED)) {
-				if ((p = strdup(name)) != NULL) {
-					free(sp->frp->name);
-					sp->frp->name = p;
-				}
+				if ((p = strdup(name)) != NULL)
+					file_setname(sp, sp->frp, p);
 				/*
 				 * The file has a real name, it's no longer a
 				 * temporary, clear the temporary file flags.
@@ -0,0 +1,440 @@
+/*-
+ * Copyright (c) 2026
+ *	The nvi2 contributors.  All rights reserved.
+ *
+ * See the LICENSE file for redistribution information.
+ */
+
+#include "config.h"
+
+#include <sys/types.h>
+#include <sys/queue.h>
+#include <sys/time.h>
+
+#include <bitstring.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../common/common.h"
+
+typedef struct {
+	size_t	 off;			/* Key offset in the key buffer. */
+	size_t	 len;			/* Key length. */
+	recno_t	 lno;			/* Line offset in the range. */
+	int	 rank;			/* Numeric: none, negative, positive. */
+} SORTKEY;
+
+typedef struct {
+	CHAR_T	*kbuf;			/* Key buffer. */
+#define	SORT_FOLD	0x01		/* Ignore case. */
+#define	SORT_NUMERIC	0x02		/* Compare the first number. */
+#define	SORT_REVERSE	0x04		/* Reverse the order. */
+#define	SORT_UNIQUE	0x08		/* Drop duplicate keys. */
+	u_int8_t flags;
+} SORT;
+
+typedef struct {
+	SORT	*s;
+	SORTKEY	*a;			/* Entries. */
+	SORTKEY	*tmp;			/* Scratch space, as large as a. */
+	size_t	 mid;			/* Merge point, or 0 to sort. */
+	size_t	 n;			/* Entry count. */
+	pthread_t tid;
+	int	 started;		/* If running in a thread. */
+} SORTJOB;
+
+#define	SORT_MAXJOBS	16		/* Most threads used. */
+#define	SORT_MINPAR	65536		/* Fewest lines sorted in parallel. */
+#define	SORT_MINRUN	16		/* Insertion sort below this. */
+
+static int	 sort_cmp(SORT *, SORTKEY *, SORTKEY *);
+static void	*sort_job(void *);
+static int	 sort_keys(SCR *, EXCMD *, SORT *, u_long, int, SORTKEY *);
+static void	 sort_merge(SORT *, SORTKEY *, size_t, size_t, SORTKEY *);
+static void	 sort_msort(SORT *, SORTKEY *, size_t, SORTKEY *);
+static void	 sort_run(SORT *, SORTKEY *, size_t, SORTKEY *);
+static void	 sort_start(SORT *, SORTJOB *, SORTKEY *, SORTKEY *, int);
+
+/*
+ * ex_sort -- [line [,line]] sor[t] [inru] [field] [/RE/]
+ *	Sort lines.
+ *
+ * PUBLIC: int ex_sort(SCR *, EXCMD *);
+ */
+int
+ex_sort(SCR *sp, EXCMD *cmdp)
+{
+	SORT s;
+	SORTKEY *k, *tmp;
+	recno_t i, n, ncnt, *perm;
+	u_long field;
+	int delim, rval, usere;
+	CHAR_T *p, *ptrn, *t;
+
+	NEEDFILE(sp, cmdp);
+
+	/*
+	 * Parse the options.  As for the global command, any non-alphanumeric
+	 * character delimits an RE, and the key starts after its match.
+	 */
+	memset(&s, 0, sizeof(s));
+	field = 0;
+	usere = 0;
+	for (p = cmdp->argc == 0 ? L("") : cmdp->argv[0]->bp; *p != '\0';) {
+		if (cmdskip(*p)) {
+			++p;
+			continue;
+		}
+		switch (*p) {
+		case 'i':
+			F_SET(&s, SORT_FOLD);
+			++p;
+			continue;
+		case 'n':
+			F_SET(&s, SORT_NUMERIC);
+			++p;
+			continue;
+		case 'r':
+			F_SET(&s, SORT_REVERSE);
+			++p;
+			continue;
+		case 'u':
+			F_SET(&s, SORT_UNIQUE);
+			++p;
+			continue;
+		}
+		if (ISDIGIT(*p)) {
+			for (field = 0; ISDIGIT(*p); ++p)
+				field = field * 10 + (*p - '0');
+			continue;
+		}
+		if (usere || is09azAZ(*p) ||
+		    *p == '\\' || *p == '|' || *p == '\n') {
+			ex_emsg(sp, cmdp->cmd->usage, EXM_USAGE);
+			return (1);
+		}
+
+		/*
+		 * Get the pattern string, toss escaped delimiters and nul
+		 * terminate it, see ex_g_setup().  The nul can't overwrite
+		 * any of the options that follow.
+		 */
+		delim = *p++;
+		for (ptrn = t = p;;) {
+			if (p[0] == '\0' || p[0] == delim) {
+				if (p[0] == delim)
+					++p;
+				break;
+			}
+			if (p[0] == '\\') {
+				if (p[1] == delim)
+					++p;
+				else if (p[1] == '\\')
+					*t++ = *p++;
+			}
+			*t++ = *p++;
+		}
+		*t = '\0';
+		if (t == ptrn) {
+			if (sp->re == NULL) {
+				ex_emsg(sp, NULL, EXM_NOPREVRE);
+				return (1);
+			}
+			if (!F_ISSET(sp, SC_RE_SEARCH) &&
+			    re_compile(sp, sp->re, sp->re_len,
+			    NULL, NULL, &sp->re_c, RE_C_SEARCH))
+				return (1);
+		} else if (re_compile(sp, ptrn, t - ptrn,
+		    &sp->re, &sp->re_len, &sp->re_c, RE_C_SEARCH))
+			return (1);
+		usere = 1;
+	}
+
+	/* Empty files and single lines are already sorted. */
+	if (cmdp->addr1.lno == 0 || cmdp->addr1.lno >= cmdp->addr2.lno)
+		return (0);
+	n = cmdp->addr2.lno - cmdp->addr1.lno + 1;
+
+	k = tmp = NULL;
+	perm = NULL;
+	rval = 1;
+	CALLOC_GOTO(sp, k, n, sizeof(SORTKEY));
+	CALLOC_GOTO(sp, tmp, n, sizeof(SORTKEY));
+	if (sort_keys(sp, cmdp, &s, field, usere, k))
+		goto err;
+
+	sort_run(&s, k, n, tmp);
+
+	/* Build the permutation, dropping duplicates. */
+	MALLOC_GOTO(sp, perm, n * sizeof(recno_t));
+	for (ncnt = 0, i = 0; i < n; ++i) {
+		if (F_ISSET(&s, SORT_UNIQUE) && ncnt != 0 &&
+		    sort_cmp(&s, &k[i - 1], &k[i]) == 0)
+			continue;
+		perm[ncnt++] = k[i].lno;
+	}
+
+	/* If nothing moved, don't touch the file. */
+	for (i = 0; i < ncnt && perm[i] == i; ++i);
+	if (i == n) {
+		rval = 0;
+		goto err;
+	}
+	if (db_bpermute(sp, cmdp->addr1.lno, n, perm, ncnt))
+		goto err;
+
+	sp->rptlines[L_CHANGED] += ncnt;
+	sp->rptlines[L_DELETED] += n - ncnt;
+	sp->lno = cmdp->addr1.lno;
+	sp->cno = 0;
+	rval = 0;
+
+err:
+alloc_err:
+	free(s.kbuf);
+	free(perm);
+	free(tmp);
+	free(k);
+	return (rval);
+}
+
+/*
+ * sort_keys --
+ *	Copy the sort keys of the lines into a single buffer.
+ */
+static int
+sort_keys(SCR *sp, EXCMD *cmdp, SORT *s, u_long field, int usere, SORTKEY *k)
+{
+	regmatch_t match[1];
+	recno_t lno;
+	size_t blen, klen, len, off, skip;
+	u_long f;
+	int cnt, eval;
+	SORTKEY *kp;
+	CHAR_T *dbp, *ep, *p;
+
+	blen = 0;
+	cnt = INTERRUPT_CHECK;
+	for (off = 0, lno = cmdp->addr1.lno; lno <= cmdp->addr2.lno; ++lno) {
+		if (cnt-- == 0) {
+			if (INTERRUPTED(sp))
+				return (1);
+			cnt = INTERRUPT_CHECK;
+		}
+		if (db_get(sp, lno, DBG_FATAL, &dbp, &len))
+			return (1);
+		kp = &k[lno - cmdp->addr1.lno];
+		kp->lno = lno - cmdp->addr1.lno;
+		kp->off = off;
+
+		/* Lines the RE doesn't match have empty keys. */
+		skip = 0;
+		if (usere) {
+			match[0].rm_so = 0;
+			match[0].rm_eo = len;
+			switch (eval = re_exec(sp,
+			    &sp->re_c, dbp, 1, match, REG_STARTEND)) {
+			case 0:
+				skip = match[0].rm_eo;
+				break;
+			case REG_NOMATCH:
+				skip = len;
+				break;
+			default:
+				re_error(sp, eval, &sp->re_c);
+				return (1);
+			}
+		}
+
+		/* Fields are separated by blanks, leading blanks ignored. */
+		for (f = 1; f <= field; ++f) {
+			for (; skip < len && ISBLANK(dbp[skip]); ++skip);
+			if (f == field)
+				break;
+			for (; skip < len && !ISBLANK(dbp[skip]); ++skip);
+		}
+		dbp += skip;
+		len -= skip;
+
+		/*
+		 * Numeric keys are the digits of the first number, without
+		 * leading zeroes, ranked by sign.
+		 */
+		if (F_ISSET(s, SORT_NUMERIC)) {
+			for (ep = dbp + len, p = dbp; p < ep && !ISDIGIT(*p); ++p);
+			if (p == ep) {
+				kp->len = 0;
+				continue;
+			}
+			kp->rank = p > dbp && p[-1] == '-' ? 1 : 2;
+			for (; p < ep && *p == '0'; ++p);
+			for (dbp = p; p < ep && ISDIGIT(*p); ++p);
+			if ((len = p - dbp) == 0)
+				kp->rank = 2;
+		}
+		kp->len = len;
+
+		klen = off + len;
+		BINC_RETW(sp, s->kbuf, blen, klen);
+		if (F_ISSET(s, SORT_FOLD) && !F_ISSET(s, SORT_NUMERIC))
+			for (p = s->kbuf + off; len-- > 0; ++dbp)
+				*p++ = TOLOWER(*dbp);
+		else
+			MEMCPY(s->kbuf + off, dbp, len);
+		off = klen;
+	}
+	return (0);
+}
+
+/*
+ * sort_cmp --
+ *	Compare two keys.
+ */
+static int
+sort_cmp(SORT *s, SORTKEY *a, SORTKEY *b)
+{
+	size_t len;
+	int r;
+
+	if (F_ISSET(s, SORT_NUMERIC)) {
+		/* Negative numbers compare in reverse order of magnitude. */
+		if (a->rank != b->rank)
+			r = a->rank < b->rank ? -1 : 1;
+		else {
+			if (a->len != b->len)
+				r = a->len < b->len ? -1 : 1;
+			else
+				r = MEMCMP(s->kbuf + a->off,
+				    s->kbuf + b->off, a->len);
+			if (a->rank == 1)
+				r = -r;
+		}
+	} else {
+		len = a->len < b->len ? a->len : b->len;
+		if ((r = MEMCMP(s->kbuf + a->off, s->kbuf + b->off, len)) == 0)
+			r = a->len < b->len ? -1 : a->len > b->len;
+	}
+	return (F_ISSET(s, SORT_REVERSE) ? -r : r);
+}
+
+/*
+ * sort_run --
+ *	Sort the entries.  Large sorts are split into chunks sorted by
+ *	separate threads, and the sorted runs merged in pairs, also in
+ *	parallel.
+ */
+static void
+sort_run(SORT *s, SORTKEY *a, size_t n, SORTKEY *tmp)
+{
+	SORTJOB job[SORT_MAXJOBS];
+	size_t b[SORT_MAXJOBS + 1];
+	long ncpu;
+	int i, njob, w;
+
+	ncpu = n < SORT_MINPAR ? 1 : sysconf(_SC_NPROCESSORS_ONLN);
+	njob = ncpu < 1 ? 1 : ncpu > SORT_MAXJOBS ? SORT_MAXJOBS : ncpu;
+	for (i = 0; i <= njob; ++i)
+		b[i] = n / njob * i + n % njob * i / njob;
+
+	for (i = 0; i < njob; ++i) {
+		job[i].mid = 0;
+		job[i].n = b[i + 1] - b[i];
+		sort_start(s, &job[i], a + b[i], tmp + b[i], njob > 1);
+	}
+	for (i = 0; i < njob; ++i)
+		if (job[i].started)
+			(void)pthread_join(job[i].tid, NULL);
+
+	for (w = 1; w < njob; w *= 2) {
+		for (i = 0; i + w < njob; i += w * 2) {
+			job[i].mid = b[i + w] - b[i];
+			job[i].n = b[MIN(i + w * 2, njob)] - b[i];
+			sort_start(s, &job[i], a + b[i], tmp + b[i], 1);
+		}
+		for (i = 0; i + w < njob; i += w * 2)
+			if (job[i].started)
+				(void)pthread_join(job[i].tid, NULL);
+	}
+}
+
+/*
+ * sort_start --
+ *	Start a job in a thread, or run it if that fails.
+ */
+static void
+sort_start(SORT *s, SORTJOB *jp, SORTKEY *a, SORTKEY *tmp, int thread)
+{
+	jp->s = s;
+	jp->a = a;
+	jp->tmp = tmp;
+	jp->started = thread &&
+	    pthread_create(&jp->tid, NULL, sort_job, jp) == 0;
+	if (!jp->started)
+		(void)sort_job(jp);
+}
+
+/*
+ * sort_job --
+ *	Sort or merge a run of entries.
+ */
+static void *
+sort_job(void *arg)
+{
+	SORTJOB *jp;
+
+	jp = arg;
+	if (jp->mid == 0)
+		sort_msort(jp->s, jp->a, jp->n, jp->tmp);
+	else
+		sort_merge(jp->s, jp->a, jp->mid, jp->n, jp->tmp);
+	return (NULL);
+}
+
+/*
+ * sort_msort --
+ *	Stable merge sort.
+ */
+static void
+sort_msort(SORT *s, SORTKEY *a, size_t n, SORTKEY *tmp)
+{
+	SORTKEY t;
+	size_t i, j, mid;
+
+	if (n <= SORT_MINRUN) {
+		for (i = 1; i < n; ++i) {
+			t = a[i];
+			for (j = i; j > 0 && sort_cmp(s, &a[j - 1], &t) > 0; --j)
+				a[j] = a[j - 1];
+			a[j] = t;
+		}
+		return;
+	}
+	mid = n / 2;
+	sort_msort(s, a, mid, tmp);
+	sort_msort(s, a + mid, n - mid, tmp + mid);
+	sort_merge(s, a, mid, n, tmp);
+}
+
+/*
+ * sort_merge --
+ *	Merge two adjacent sorted runs, the first one is copied aside.
+ */
+static void
+sort_merge(SORT *s, SORTKEY *a, size_t mid, size_t n, SORTKEY *tmp)
+{
+	size_t i, j, o;
+
+	if (sort_cmp(s, &a[mid - 1], &a[mid]) <= 0)
+		return;
+	memcpy(tmp, a, mid * sizeof(SORTKEY));
+	for (i = 0, j = mid, o = 0; i < mid && j < n;)
+		if (sort_cmp(s, &tmp[i], &a[j]) <= 0)
+			a[o++] = tmp[i++];
+		else
+			a[o++] = a[j++];
+	memcpy(a + o, tmp + i, (mid - i) * sizeof(SORTKEY));
+}
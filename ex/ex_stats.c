@@ -0,0 +1,71 @@
+/*-
+ * Copyright (c) 2026
+ *	The nvi2 contributors.  All rights reserved.
+ *
+ * See the LICENSE file for redistribution information.
+ */
+
+#include "config.h"
+
+#include <sys/types.h>
+#include <sys/queue.h>
+#include <sys/time.h>
+
+#include <bitstring.h>
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../common/common.h"
+
+/*
+ * ex_stats -- :stats[!]
+ *	Display the performance counters, and reset them if forced.
+ *
+ * PUBLIC: int ex_stats(SCR *, EXCMD *);
+ */
+int
+ex_stats(SCR *sp, EXCMD *cmdp)
+{
+	GS *gp;
+
+	gp = sp->gp;
+	if (FL_ISSET(cmdp->iflags, E_C_FORCE)) {
+		memset(&gp->stats, 0, sizeof(gp->stats));
+		return (0);
+	}
+	(void)stats_display(sp, NULL);
+	return (0);
+}
+
+/*
+ * ex_trace -- :trace[!] [file]
+ *	Write the trace ring to a file, or reset it if forced.
+ *
+ * PUBLIC: int ex_trace(SCR *, EXCMD *);
+ */
+int
+ex_trace(SCR *sp, EXCMD *cmdp)
+{
+	TRRING *trp;
+	size_t len;
+	char *np;
+
+	trp = &sp->gp->tr;
+	if (FL_ISSET(cmdp->iflags, E_C_FORCE)) {
+		trp->next = 0;
+		trp->cnt = 0;
+	}
+	if (cmdp->argc == 0) {
+		if (!FL_ISSET(cmdp->iflags, E_C_FORCE))
+			msgq(sp, M_INFO, "332|%lu events logged, ring size %lu",
+			    (u_long)trp->cnt, (u_long)trp->size);
+		return (0);
+	}
+	if (trp->ring == NULL) {
+		msgq(sp, M_ERR, "333|The traceevents option isn't set");
+		return (1);
+	}
+	INT2CHAR(sp, cmdp->argv[0]->bp, cmdp->argv[0]->len + 1, np, len);
+	return (trace_dump(sp, np));
+}
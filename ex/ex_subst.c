@@ -543,7 +543,7 @@ nextmatch:	match[0].rm_so = 0;
 		match[0].rm_eo = len;
 
 		/* Get the next match. */
-		eval = regexec(re, s + offset, 10, match, eflags);
+		eval = re_exec(sp, re, s + offset, 10, match, eflags);
 
 		/*
 		 * There wasn't a match or if there was an error, deal with
@@ -1293,6 +1293,26 @@ re_error(SCR *sp, int errcode, regex_t *preg)
 	}
 }
 
+/*
+ * re_exec --
+ *	Match a regular expression, keeping count of the calls and time.
+ *
+ * PUBLIC: int re_exec(SCR *, regex_t *, CHAR_T *, size_t, regmatch_t *, int);
+ */
+int
+re_exec(SCR *sp, regex_t *preg, CHAR_T *str, size_t nmatch,
+    regmatch_t *pmatch, int eflags)
+{
+	uint64_t t;
+	int eval;
+
+	STAT_START(t);
+	eval = regexec(preg, str, nmatch, pmatch, eflags);
+	STAT_STOP(sp, re_time, t);
+	STAT_INC(sp, re_calls);
+	return (eval);
+}
+
 /*
  * re_sub --
  * 	Do the substitution for a regular expression.
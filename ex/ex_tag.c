@@ -148,6 +148,9 @@ ex_tag_next(SCR *sp, EXCMD *cmdp)
 		tag_msg(sp, TAG_EMPTY, NULL);
 		return (1);
 	}
+	if (F_ISSET(tqp, TAG_VGREP) &&
+	    vgrep_drain(sp, tqp, TAILQ_NEXT(tqp->current, q) == NULL))
+		return (1);
 	if ((tp = TAILQ_NEXT(tqp->current, q)) == NULL) {
 		msgq(sp, M_ERR, "282|Already at the last tag of this group");
 		return (1);
@@ -496,7 +499,9 @@ ex_tag_display(SCR *sp)
 	 * is numbered, and the current tag entry has an asterisk appended.
 	 */
 	for (cnt = 1, tqp = TAILQ_FIRST(exp->tq); !INTERRUPTED(sp) &&
-	    tqp != NULL; ++cnt, tqp = TAILQ_NEXT(tqp, q))
+	    tqp != NULL; ++cnt, tqp = TAILQ_NEXT(tqp, q)) {
+		if (F_ISSET(tqp, TAG_VGREP))
+			(void)vgrep_drain(sp, tqp, 0);
 		TAILQ_FOREACH(tp, tqp->tagq, q) {
 			if (tp == TAILQ_FIRST(tqp->tagq))
 				(void)ex_printf(sp, "%2d ", cnt);
@@ -524,6 +529,7 @@ ex_tag_display(SCR *sp)
 			}
 			(void)ex_printf(sp, "\n");
 		}
+	}
 	return (0);
 }
 
@@ -619,6 +625,10 @@ tagq_copy(SCR *sp, TAGQ *otqp, TAGQ **tqpp)
 	if (otqp->tag != NULL)
 		tqp->tag = tqp->buf;
 
+	/* A running vgrep search stays with the original queue. */
+	tqp->vgrep = NULL;
+	F_CLR(tqp, TAG_VGREP);
+
 	*tqpp = tqp;
 	return (0);
 }
@@ -683,6 +693,8 @@ tagq_free(SCR *sp, TAGQ *tqp)
 	TAG *tp;
 
 	exp = EXP(sp);
+	if (F_ISSET(tqp, TAG_VGREP))
+		vgrep_free(tqp);
 	while ((tp = TAILQ_FIRST(tqp->tagq)) != NULL) {
 		TAILQ_REMOVE(tqp->tagq, tp, q);
 		free(tp);
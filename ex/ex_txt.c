@@ -70,7 +70,7 @@ ex_txt(SCR *sp, TEXTH *tiqh, ARG_CHAR_T prompt, u_int32_t flags)
 	if (!TAILQ_EMPTY(tiqh)) {
 		tp = TAILQ_FIRST(tiqh);
 		if (TAILQ_NEXT(tp, q) != NULL || tp->lb_len < 32) {
-			text_lfree(tiqh);
+			text_lfree(sp, tiqh);
 			goto newtp;
 		}
 		tp->len = 0;
@@ -185,7 +185,7 @@ newtp:		if ((tp = text_init(sp, NULL, 0, 32)) == NULL)
 			if (LF_ISSET(TXT_DOTTERM) && tp->len == tp->ai + 1 &&
 			    tp->lb[tp->len - 1] == '.') {
 notlast:			TAILQ_REMOVE(tiqh, tp, q);
-				text_free(tp);
+				text_free(sp, tp);
 				goto done;
 			}
 
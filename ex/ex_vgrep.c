@@ -0,0 +1,474 @@
+/*-
+ * Copyright (c) 2026
+ *	The nvi2 contributors.  All rights reserved.
+ *
+ * See the LICENSE file for redistribution information.
+ */
+
+#include "config.h"
+
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <sys/queue.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+
+#include <bitstring.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../common/common.h"
+#include "tag.h"
+
+/*
+ * A :vgrep search runs in a pool of threads, each of which takes the next
+ * file in the list, and records the numbers of the matching lines.  The
+ * results are moved into the tag queue in file order, as the files are
+ * searched, so the first match can be used while the search goes on.
+ */
+typedef struct {
+	char	*name;			/* File name. */
+	recno_t	*lnos;			/* Matching line numbers. */
+	size_t	 nlnos;			/* Matching line count. */
+	size_t	 alnos;			/* Matching line numbers allocated. */
+	int	 errnum;		/* Error, if the search failed. */
+	int	 done;			/* If searched. */
+} VGFILE;
+
+typedef struct {
+	SCR		*sp;		/* Screen, for the conversions. */
+	char2wchar_t	 file2int;	/* File conversion, when started. */
+	regex_t		 re;		/* Compiled RE. */
+	pthread_mutex_t	 mtx;		/* Lock for everything following. */
+	pthread_cond_t	 cond;		/* A file was searched. */
+	pthread_t	 tid[16];	/* Threads. */
+	int		 nthreads;	/* Thread count. */
+	VGFILE		*files;		/* Files. */
+	size_t		 nfiles;	/* File count. */
+	size_t		 next;		/* Next file to search. */
+	size_t		 ndrained;	/* Files moved into the tag queue. */
+	int		 stop;		/* Stop searching. */
+	int		 fg;		/* Searching without threads. */
+} VGREP;
+
+#define	VG_BINARY	4096		/* Bytes checked for a nul. */
+#define	VG_CHECK	4096		/* Lines between stop checks. */
+#define	VG_WAIT		100		/* Milliseconds between interrupt checks. */
+
+static int	 vgrep_file(VGREP *, VGFILE *, CONVWIN *);
+static int	 vgrep_tag(SCR *, TAGQ *, char *, recno_t);
+static void	*vgrep_thread(void *);
+
+/*
+ * ex_vgrep -- vg[rep] [;/]RE[;/] [file ...]
+ *	Search files for an RE, and make the matches a tag queue.
+ *
+ * PUBLIC: int ex_vgrep(SCR *, EXCMD *);
+ */
+int
+ex_vgrep(SCR *sp, EXCMD *cmdp)
+{
+	TAGQ *tqp;
+	VGREP *vg;
+	size_t i, len, nlen;
+	long ncpu;
+	int delim;
+	char **ap, *np, *tag;
+	CHAR_T *p, *ptrn, *t;
+
+	/*
+	 * Skip leading white space.  As for the global command, any
+	 * non-alphanumeric character can delimit the RE.
+	 */
+	if (cmdp->argc == 0)
+		goto usage;
+	for (p = cmdp->argv[0]->bp; cmdskip(*p); ++p);
+	if (*p == '\0' || is09azAZ(*p) ||
+	    *p == '\\' || *p == '|' || *p == '\n') {
+usage:		ex_emsg(sp, cmdp->cmd->usage, EXM_USAGE);
+		return (1);
+	}
+	delim = *p++;
+
+	/* Get the pattern string, toss escaped delimiters. */
+	for (ptrn = t = p;;) {
+		if (p[0] == '\0' || p[0] == delim) {
+			if (p[0] == delim)
+				++p;
+			break;
+		}
+		if (p[0] == '\\') {
+			if (p[1] == delim)
+				++p;
+			else if (p[1] == '\\')
+				*t++ = *p++;
+		}
+		*t++ = *p++;
+	}
+	*t = '\0';
+
+	/* If the pattern string is empty, use the last one. */
+	if (t == ptrn) {
+		if (sp->re == NULL) {
+			ex_emsg(sp, NULL, EXM_NOPREVRE);
+			return (1);
+		}
+		if (!F_ISSET(sp, SC_RE_SEARCH) &&
+		    re_compile(sp, sp->re, sp->re_len,
+		    NULL, NULL, &sp->re_c, RE_C_SEARCH))
+			return (1);
+	} else {
+		if (re_compile(sp, ptrn, t - ptrn,
+		    &sp->re, &sp->re_len, &sp->re_c, RE_C_SEARCH))
+			return (1);
+		sp->searchdir = FORWARD;
+	}
+
+	/* The rest of the arguments are the files, the default is the list. */
+	for (; cmdskip(*p); ++p);
+	if (*p != '\0' && argv_exp2(sp, cmdp, p, STRLEN(p)))
+		return (1);
+
+	CALLOC_RET(sp, vg, 1, sizeof(VGREP));
+	vg->sp = sp;
+	if (cmdp->argc > 1) {
+		vg->nfiles = cmdp->argc - 1;
+		CALLOC_GOTO(sp, vg->files, vg->nfiles, sizeof(VGFILE));
+		for (i = 0; i < vg->nfiles; ++i) {
+			INT2CHAR(sp, cmdp->argv[i + 1]->bp,
+			    cmdp->argv[i + 1]->len + 1, np, nlen);
+			if ((vg->files[i].name = strdup(np)) == NULL)
+				goto alloc_err;
+		}
+	} else if (sp->argv != NULL && sp->argv[0] != NULL) {
+		for (ap = sp->argv; *ap != NULL; ++ap)
+			++vg->nfiles;
+		CALLOC_GOTO(sp, vg->files, vg->nfiles, sizeof(VGFILE));
+		for (i = 0; i < vg->nfiles; ++i)
+			if ((vg->files[i].name = strdup(sp->argv[i])) == NULL)
+				goto alloc_err;
+	} else if (sp->frp != NULL && !F_ISSET(sp->frp, FR_TMPFILE)) {
+		vg->nfiles = 1;
+		CALLOC_GOTO(sp, vg->files, 1, sizeof(VGFILE));
+		if ((vg->files[0].name = strdup(sp->frp->name)) == NULL)
+			goto alloc_err;
+	} else {
+		msgq(sp, M_ERR, "331|No files to search");
+		goto err;
+	}
+
+	/*
+	 * Compile a copy of the RE for the search, it's shared by the
+	 * threads, regexec(3) doesn't change it.
+	 */
+	if (re_compile(sp, sp->re, sp->re_len, NULL, NULL, &vg->re, 0))
+		goto err;
+
+	/* Get a tag queue, named by the pattern. */
+	INT2CHAR(sp, sp->re, sp->re_len + 1, tag, len);
+	CALLOC(sp, tqp, 1, sizeof(TAGQ) + len);
+	if (tqp == NULL) {
+		regfree(&vg->re);
+		goto err;
+	}
+	TAILQ_INIT(tqp->tagq);
+	tqp->tag = tqp->buf;
+	memcpy(tqp->tag, tag, len);
+	tqp->tlen = len - 1;
+	tqp->vgrep = vg;
+	F_SET(tqp, TAG_VGREP);
+
+	/*
+	 * Start the threads.  The threads use the file conversion as it was
+	 * when the search started, but the iconv descriptors belong to the
+	 * screen and can't be shared, so searches with a conversion that
+	 * uses them are done now, without threads.  If there are no threads,
+	 * the search is done now, too.
+	 */
+	(void)pthread_mutex_init(&vg->mtx, NULL);
+	(void)pthread_cond_init(&vg->cond, NULL);
+	if ((ncpu = sysconf(_SC_NPROCESSORS_ONLN)) < 1)
+		ncpu = 1;
+	if ((vg->file2int = conv_file2int_mt(sp)) == NULL) {
+		vg->file2int = sp->conv.file2int;
+		ncpu = 0;
+	}
+	for (i = 0; i < vg->nfiles && i < (size_t)ncpu &&
+	    i < sizeof(vg->tid) / sizeof(vg->tid[0]); ++i) {
+		if (pthread_create(&vg->tid[i], NULL, vgrep_thread, vg))
+			break;
+		++vg->nthreads;
+	}
+	if (vg->nthreads == 0) {
+		vg->fg = 1;
+		(void)vgrep_thread(vg);
+	}
+
+	/* Wait for the first match. */
+	if (vgrep_drain(sp, tqp, 1) || INTERRUPTED(sp))
+		goto qerr;
+	if ((tqp->current = TAILQ_FIRST(tqp->tagq)) == NULL) {
+		tag_msg(sp, TAG_SEARCH, tqp->tag);
+		goto qerr;
+	}
+	return (tagq_push(sp, tqp, 0, FL_ISSET(cmdp->iflags, E_C_FORCE)));
+
+qerr:	tagq_free(sp, tqp);
+	return (1);
+
+alloc_err:
+err:	if (vg->files != NULL)
+		for (i = 0; i < vg->nfiles; ++i)
+			free(vg->files[i].name);
+	free(vg->files);
+	free(vg);
+	return (1);
+}
+
+/*
+ * vgrep_drain --
+ *	Move the matches of the searched files into the tag queue, waiting
+ *	for at least one more if wait is set.  If the wait is interrupted,
+ *	the search is stopped, and the matches already in the tag queue are
+ *	kept.
+ *
+ * PUBLIC: int vgrep_drain(SCR *, TAGQ *, int);
+ */
+int
+vgrep_drain(SCR *sp, TAGQ *tqp, int wait)
+{
+	struct timespec ts;
+	struct timeval tv;
+	VGFILE *fp;
+	VGREP *vg;
+	size_t i;
+	int added, rval;
+
+	vg = tqp->vgrep;
+	added = rval = 0;
+	(void)pthread_mutex_lock(&vg->mtx);
+	while (vg->ndrained < vg->nfiles) {
+		fp = &vg->files[vg->ndrained];
+		if (!fp->done) {
+			if (!wait || added || vg->stop)
+				break;
+
+			/* Wake up every so often to check for interrupts. */
+			(void)gettimeofday(&tv, NULL);
+			tv.tv_usec += VG_WAIT * 1000;
+			ts.tv_sec = tv.tv_sec + tv.tv_usec / 1000000;
+			ts.tv_nsec = tv.tv_usec % 1000000 * 1000;
+			if (pthread_cond_timedwait(&vg->cond,
+			    &vg->mtx, &ts) != ETIMEDOUT)
+				continue;
+			(void)pthread_mutex_unlock(&vg->mtx);
+			if (INTERRUPTED(sp)) {
+				vgrep_free(tqp);
+				return (1);
+			}
+			(void)pthread_mutex_lock(&vg->mtx);
+			continue;
+		}
+		++vg->ndrained;
+
+		/* The file's results don't change once it's searched. */
+		(void)pthread_mutex_unlock(&vg->mtx);
+		if (fp->errnum != 0) {
+			errno = fp->errnum;
+			msgq_str(sp, M_SYSERR, fp->name, "%s");
+		}
+		for (i = 0; i < fp->nlnos && !rval; ++i, ++added)
+			rval = vgrep_tag(sp, tqp, fp->name, fp->lnos[i]);
+		free(fp->lnos);
+		fp->lnos = NULL;
+		(void)pthread_mutex_lock(&vg->mtx);
+		if (rval)
+			break;
+	}
+	(void)pthread_mutex_unlock(&vg->mtx);
+
+	/* Once all of the files are searched, the threads are done. */
+	if (vg->ndrained == vg->nfiles)
+		vgrep_free(tqp);
+	return (rval);
+}
+
+/*
+ * vgrep_free --
+ *	Stop a search, and discard the results not yet in the tag queue.
+ *
+ * PUBLIC: void vgrep_free(TAGQ *);
+ */
+void
+vgrep_free(TAGQ *tqp)
+{
+	VGREP *vg;
+	size_t i;
+	int n;
+
+	vg = tqp->vgrep;
+	(void)pthread_mutex_lock(&vg->mtx);
+	vg->stop = 1;
+	(void)pthread_mutex_unlock(&vg->mtx);
+	for (n = 0; n < vg->nthreads; ++n)
+		(void)pthread_join(vg->tid[n], NULL);
+	(void)pthread_cond_destroy(&vg->cond);
+	(void)pthread_mutex_destroy(&vg->mtx);
+
+	regfree(&vg->re);
+	for (i = 0; i < vg->nfiles; ++i) {
+		free(vg->files[i].name);
+		free(vg->files[i].lnos);
+	}
+	free(vg->files);
+	free(vg);
+	tqp->vgrep = NULL;
+	F_CLR(tqp, TAG_VGREP);
+}
+
+/*
+ * vgrep_tag --
+ *	Append a tag for a matching line to the tag queue.  The search
+ *	string is the line number, which ctag_search() understands.
+ */
+static int
+vgrep_tag(SCR *sp, TAGQ *tqp, char *name, recno_t lno)
+{
+	TAG *tp;
+	size_t nlen, slen, wlen;
+	char buf[sizeof(u_long) * 3 + 1];
+	CHAR_T *wp;
+
+	slen = snprintf(buf, sizeof(buf), "%lu", (u_long)lno);
+	nlen = strlen(name);
+	CALLOC_RET(sp, tp, 1,
+	    sizeof(TAG) + nlen + 1 + (slen + 1) * sizeof(CHAR_T));
+	tp->fname = (char *)tp->buf;
+	memcpy(tp->fname, name, nlen + 1);
+	tp->fnlen = nlen;
+	tp->search = (CHAR_T *)(tp->fname + nlen + 1);
+	CHAR2INT(sp, buf, slen + 1, wp, wlen);
+	MEMCPY(tp->search, wp, (tp->slen = slen) + 1);
+	TAILQ_INSERT_TAIL(tqp->tagq, tp, q);
+	return (0);
+}
+
+/*
+ * vgrep_thread --
+ *	Search files until there are no more.
+ */
+static void *
+vgrep_thread(void *arg)
+{
+	CONVWIN cw;
+	VGFILE *fp;
+	VGREP *vg;
+	int errnum;
+
+	vg = arg;
+	memset(&cw, 0, sizeof(cw));
+	for (;;) {
+		(void)pthread_mutex_lock(&vg->mtx);
+		if (vg->stop || vg->next == vg->nfiles) {
+			(void)pthread_mutex_unlock(&vg->mtx);
+			break;
+		}
+		fp = &vg->files[vg->next++];
+		(void)pthread_mutex_unlock(&vg->mtx);
+
+		errnum = vgrep_file(vg, fp, &cw);
+
+		(void)pthread_mutex_lock(&vg->mtx);
+		fp->errnum = errnum;
+		fp->done = 1;
+		(void)pthread_cond_broadcast(&vg->cond);
+		(void)pthread_mutex_unlock(&vg->mtx);
+	}
+	free(cw.bp1.c);
+	return (NULL);
+}
+
+/*
+ * vgrep_file --
+ *	Search a file, return an errno value if it fails.  Files that look
+ *	binary, that is, with a nul near the start, are skipped.
+ */
+static int
+vgrep_file(VGREP *vg, VGFILE *fp, CONVWIN *cw)
+{
+	struct stat sb;
+	regmatch_t match[1];
+	recno_t lno, *lnos;
+	size_t len, wlen;
+	int cnt, fd, stop;
+	char *e, *map, *p, *t;
+	CHAR_T *wp;
+
+	if ((fd = open(fp->name, O_RDONLY, 0)) < 0)
+		return (errno);
+	if (fstat(fd, &sb)) {
+		(void)close(fd);
+		return (errno);
+	}
+	if (!S_ISREG(sb.st_mode) || sb.st_size == 0) {
+		(void)close(fd);
+		return (0);
+	}
+	if ((map = mmap(NULL, sb.st_size,
+	    PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED) {
+		(void)close(fd);
+		return (errno);
+	}
+	(void)close(fd);
+	e = map + sb.st_size;
+	if (memchr(map, '\0', MIN(sb.st_size, VG_BINARY)) != NULL)
+		goto done;
+
+	cnt = VG_CHECK;
+	for (lno = 1, p = map; p < e; ++lno, p = t + 1) {
+		if (cnt-- == 0) {
+			(void)pthread_mutex_lock(&vg->mtx);
+			/* Without threads, the search is interrupted here. */
+			if (vg->fg && INTERRUPTED(vg->sp))
+				vg->stop = 1;
+			stop = vg->stop;
+			(void)pthread_mutex_unlock(&vg->mtx);
+			if (stop)
+				break;
+			cnt = VG_CHECK;
+		}
+		if ((t = memchr(p, '\n', e - p)) == NULL)
+			t = e;
+		len = t - p;
+#ifdef USE_WIDECHAR
+		if (vg->file2int(vg->sp, p, len, cw, &wlen, &wp))
+			continue;
+#else
+		wp = p;
+		wlen = len;
+#endif
+		match[0].rm_so = 0;
+		match[0].rm_eo = wlen;
+		if (regexec(&vg->re, wp, 1, match, REG_STARTEND) != 0)
+			continue;
+		if (fp->nlnos == fp->alnos) {
+			fp->alnos = fp->alnos == 0 ? 64 : fp->alnos * 2;
+			if ((lnos = realloc(fp->lnos,
+			    fp->alnos * sizeof(recno_t))) == NULL) {
+				(void)munmap(map, sb.st_size);
+				return (errno);
+			}
+			fp->lnos = lnos;
+		}
+		fp->lnos[fp->nlnos++] = lno;
+	}
+
+done:	(void)munmap(map, sb.st_size);
+	return (0);
+}
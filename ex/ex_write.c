@@ -236,10 +236,8 @@ exwr(SCR *sp, EXCMD *cmdp, enum which cmd)
 		 */
 		if (F_ISSET(sp->frp, FR_TMPFILE) &&
 		    !F_ISSET(sp->frp, FR_EXNAMED)) {
-			if ((n = v_strdup(sp, name, nlen - 1)) != NULL) {
-				free(sp->frp->name);
-				sp->frp->name = n;
-			}
+			if ((n = v_strdup(sp, name, nlen - 1)) != NULL)
+				file_setname(sp, sp->frp, n);
 			/*
 			 * The file has a real name, it's no longer a
 			 * temporary, clear the temporary file flags.
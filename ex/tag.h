@@ -100,7 +100,10 @@ struct _tagq {			/* Tag queue. */
 	char	*tag;		/* Tag string. */
 	size_t	 tlen;		/* Tag string length. */
 
+	void	*vgrep;		/* Running :vgrep search. */
+
 #define	TAG_CSCOPE	0x01	/* Cscope tag. */
+#define	TAG_VGREP	0x02	/* Vgrep tag, still being searched. */
 	u_int8_t flags;
 
 	char	 buf[1];	/* Variable length buffer. */
@@ -30,8 +30,21 @@
  *	is returned.  Second, empty lines include lines that have only white
  *	space in them, because the vi search functions don't care about white
  *	space, and this makes it easier for them to be consistent.
+ *
+ *	The motions spend most of their time skipping runs of characters of
+ *	one kind, so cs_fspan() and cs_bspan() skip a run within the current
+ *	line directly in the line buffer, classifying the characters through
+ *	a table instead of calling the ctype functions for each of them.
  */
 
+static u_char cs_ctab[256];		/* Character classes. */
+static int cs_cinit;			/* If the table is built. */
+
+#define	CS_CLASS(ch)							\
+	((UCHAR_T)(ch) <= 0xff ? cs_ctab[(UCHAR_T)(ch)] : cs_class(ch))
+
+static int	cs_class(CHAR_T);
+
 /*
  * cs_init --
  *	Initialize character stream routines.
@@ -41,8 +54,13 @@
 int
 cs_init(SCR *sp, VCS *csp)
 {
-	int isempty;
+	int ch, isempty;
 
+	if (!cs_cinit) {
+		for (ch = 0; ch <= 0xff; ++ch)
+			cs_ctab[ch] = cs_class(ch);
+		cs_cinit = 1;
+	}
 	if (db_eget(sp, csp->cs_lno, &csp->cs_bp, &csp->cs_len, &isempty)) {
 		if (isempty)
 			msgq(sp, M_BERR, "177|Empty file");
@@ -119,13 +137,7 @@ cs_fspace(SCR *sp, VCS *csp)
 {
 	if (csp->cs_flags != 0 || !ISBLANK(csp->cs_ch))
 		return (0);
-	for (;;) {
-		if (cs_next(sp, csp))
-			return (1);
-		if (csp->cs_flags != 0 || !ISBLANK(csp->cs_ch))
-			break;
-	}
-	return (0);
+	return (cs_fspan(sp, csp, CS_CBLANK));
 }
 
 /*
@@ -137,14 +149,40 @@ cs_fspace(SCR *sp, VCS *csp)
 int
 cs_fblank(SCR *sp, VCS *csp)
 {
-	for (;;) {
-		if (cs_next(sp, csp))
+	do {
+		if (cs_fspan(sp, csp, CS_CBLANK))
 			return (1);
-		if (csp->cs_flags == CS_EOL || csp->cs_flags == CS_EMP ||
-		    (csp->cs_flags == 0 && ISBLANK(csp->cs_ch)))
-			continue;
-		break;
-	}
+	} while (csp->cs_flags == CS_EOL || csp->cs_flags == CS_EMP);
+	return (0);
+}
+
+/*
+ * cs_fspan --
+ *	Retrieve the next character, and if it's in one of the classes,
+ *	eat forward over the rest of the run in the line.  Stops on the
+ *	first character not in the classes, or at the end of the line.
+ *
+ * PUBLIC: int cs_fspan(SCR *, VCS *, int);
+ */
+int
+cs_fspan(SCR *sp, VCS *csp, int mask)
+{
+	CHAR_T *p, *ep;
+
+	if (cs_next(sp, csp))
+		return (1);
+	if (csp->cs_flags != 0 || !(CS_CLASS(csp->cs_ch) & mask))
+		return (0);
+	for (p = csp->cs_bp + csp->cs_cno + 1,
+	    ep = csp->cs_bp + csp->cs_len; p < ep; ++p)
+		if (!(CS_CLASS(*p) & mask)) {
+			csp->cs_cno = p - csp->cs_bp;
+			csp->cs_ch = *p;
+			return (0);
+		}
+	csp->cs_cno = csp->cs_len - 1;
+	csp->cs_ch = ep[-1];
+	csp->cs_flags = CS_EOL;
 	return (0);
 }
 
@@ -206,13 +244,56 @@ cs_prev(SCR *sp, VCS *csp)
 int
 cs_bblank(SCR *sp, VCS *csp)
 {
-	for (;;) {
-		if (cs_prev(sp, csp))
+	do {
+		if (cs_bspan(sp, csp, CS_CBLANK))
 			return (1);
-		if (csp->cs_flags == CS_EOL || csp->cs_flags == CS_EMP ||
-		    (csp->cs_flags == 0 && ISBLANK(csp->cs_ch)))
-			continue;
-		break;
-	}
+	} while (csp->cs_flags == CS_EOL || csp->cs_flags == CS_EMP);
+	return (0);
+}
+
+/*
+ * cs_bspan --
+ *	Retrieve the previous character, and if it's in one of the classes,
+ *	eat backward over the rest of the run in the line.  Stops on the
+ *	first character not in the classes, or at the start of the line.
+ *
+ * PUBLIC: int cs_bspan(SCR *, VCS *, int);
+ */
+int
+cs_bspan(SCR *sp, VCS *csp, int mask)
+{
+	CHAR_T *p;
+
+	if (cs_prev(sp, csp))
+		return (1);
+	if (csp->cs_flags != 0 || !(CS_CLASS(csp->cs_ch) & mask))
+		return (0);
+	for (p = csp->cs_bp + csp->cs_cno; p > csp->cs_bp; --p)
+		if (!(CS_CLASS(p[-1]) & mask)) {
+			csp->cs_cno = (p - 1) - csp->cs_bp;
+			csp->cs_ch = p[-1];
+			return (0);
+		}
+	csp->cs_cno = 0;
+	csp->cs_ch = csp->cs_bp[0];
+	csp->cs_flags = csp->cs_lno == 1 ? CS_SOF : CS_EOL;
 	return (0);
 }
+
+/*
+ * cs_class --
+ *	Return the class of a character.
+ */
+static int
+cs_class(CHAR_T ch)
+{
+	switch (ch) {
+	case '.': case '?': case '!':
+		return (CS_CEND);
+	case ')': case ']': case '"': case '\'':
+		return (CS_CCLOSE);
+	}
+	if (ISBLANK(ch))
+		return (CS_CBLANK);
+	return (inword(ch) ? CS_CWORD : CS_CPUNCT);
+}
@@ -66,6 +66,8 @@ v_iA(SCR *sp, VICMD *vp)
 {
 	size_t len;
 
+	if (db_paged(sp))
+		return (1);
 	if (!db_get(sp, vp->m_start.lno, 0, NULL, &len))
 		sp->cno = len == 0 ? 0 : len - 1;
 
@@ -89,6 +91,10 @@ v_ia(SCR *sp, VICMD *vp)
 	int isempty;
 	CHAR_T *p;
 
+	/* Check before the cursor moves past the end of the line. */
+	if (db_paged(sp))
+		return (1);
+
 	flags = set_txt_std(sp, vp, 0);
 	sp->showmode = SM_APPEND;
 	sp->lno = vp->m_start.lno;
@@ -121,6 +127,8 @@ v_ia(SCR *sp, VICMD *vp)
 int
 v_iI(SCR *sp, VICMD *vp)
 {
+	if (db_paged(sp))
+		return (1);
 	sp->cno = 0;
 	if (nonblank(sp, vp->m_start.lno, &sp->cno))
 		return (1);
@@ -145,6 +153,9 @@ v_ii(SCR *sp, VICMD *vp)
 	int isempty;
 	CHAR_T *p;
 
+	if (db_paged(sp))
+		return (1);
+
 	flags = set_txt_std(sp, vp, 0);
 	sp->showmode = SM_INSERT;
 	sp->lno = vp->m_start.lno;
@@ -196,6 +207,9 @@ io(SCR *sp, VICMD *vp, enum which cmd)
 	u_int32_t flags;
 	CHAR_T *p;
 
+	if (db_paged(sp))
+		return (1);
+
 	flags = set_txt_std(sp, vp, TXT_ADDNEWLINE | TXT_APPENDEOL);
 	sp->showmode = SM_INSERT;
 
@@ -247,6 +261,9 @@ v_change(SCR *sp, VICMD *vp)
 	CHAR_T *bp;
 	CHAR_T *p;
 
+	if (db_paged(sp))
+		return (1);
+
 	/*
 	 * 'c' can be combined with motion commands that set the resulting
 	 * cursor position, i.e. "cG".  Clear the VM_RCM flags and make the
@@ -386,6 +403,9 @@ v_Replace(SCR *sp, VICMD *vp)
 	int isempty;
 	CHAR_T *p;
 
+	if (db_paged(sp))
+		return (1);
+
 	flags = set_txt_std(sp, vp, 0);
 	sp->showmode = SM_REPLACE;
 
@@ -420,6 +440,9 @@ v_subst(SCR *sp, VICMD *vp)
 	int isempty;
 	CHAR_T *p;
 
+	if (db_paged(sp))
+		return (1);
+
 	flags = set_txt_std(sp, vp, 0);
 	sp->showmode = SM_CHANGE;
 
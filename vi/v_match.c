@@ -23,6 +23,10 @@
 #include "../common/common.h"
 #include "vi.h"
 
+static int	 v_mi_build(SCR *, MINDEX *, recno_t);
+static MINDEX	*v_mi_get(SCR *);
+static int	*v_mi_sum(SCR *, MINDEX *, recno_t, int);
+
 /*
  * v_match -- %
  *	Search to matching character.
@@ -32,12 +36,10 @@
 int
 v_match(SCR *sp, VICMD *vp)
 {
-	VCS cs;
 	MARK *mp;
 	size_t cno, len, off;
-	int cnt, isempty, matchc, startc, (*gc)(SCR *, VCS *);
+	int found, isempty;
 	CHAR_T *p;
-	CHAR_T *cp;
 	const CHAR_T *match_chars;
 
 	/*
@@ -66,41 +68,19 @@ v_match(SCR *sp, VICMD *vp)
 nomatch:		msgq(sp, M_BERR, "184|No match character on this line");
 			return (1);
 		}
-		startc = p[off];
-		cp = STRCHR(match_chars, startc);
-		if (cp != NULL) {
-			cnt = cp - match_chars;
-			matchc = match_chars[cnt ^ 1];
-			gc = cnt & 1 ? cs_prev : cs_next;
+		if (STRCHR(match_chars, p[off]) != NULL)
 			break;
-		}
 	}
 
-	cs.cs_lno = vp->m_start.lno;
-	cs.cs_cno = off;
-	if (cs_init(sp, &cs))
+	vp->m_stop.lno = vp->m_start.lno;
+	vp->m_stop.cno = off;
+	if (v_mi_find(sp, &vp->m_stop, &found))
 		return (1);
-	for (cnt = 1;;) {
-		if (gc(sp, &cs))
-			return (1);
-		if (cs.cs_flags != 0) {
-			if (cs.cs_flags == CS_EOF || cs.cs_flags == CS_SOF)
-				break;
-			continue;
-		}
-		if (cs.cs_ch == startc)
-			++cnt;
-		else if (cs.cs_ch == matchc && --cnt == 0)
-			break;
-	}
-	if (cnt) {
+	if (!found) {
 		msgq(sp, M_BERR, "185|Matching character not found");
 		return (1);
 	}
 
-	vp->m_stop.lno = cs.cs_lno;
-	vp->m_stop.cno = cs.cs_cno;
-
 	/*
 	 * If moving right, non-motion commands move to the end of the range.
 	 * Delete and yank stay at the start.
@@ -170,3 +150,243 @@ v_buildmcs(SCR *sp, char *str)
 #endif
 	return (0);
 }
+
+/*
+ * v_mi_find --
+ *	Find the partner of the bracket at a position, and move the mark
+ *	to it.  The found flag is cleared if there isn't one.
+ *
+ * PUBLIC: int v_mi_find(SCR *, MARK *, int *);
+ */
+int
+v_mi_find(SCR *sp, MARK *mp, int *foundp)
+{
+	MINDEX *mip;
+	recno_t lno;
+	size_t len, off;
+	int cnt, k, *sum;
+	CHAR_T *p, matchc, startc;
+
+	*foundp = 0;
+	if (db_get(sp, mp->lno, DBG_FATAL, &p, &len))
+		return (1);
+	startc = p[mp->cno];
+	k = STRCHR(VIP(sp)->mcs, startc) - VIP(sp)->mcs;
+	matchc = VIP(sp)->mcs[k ^ 1];
+	mip = v_mi_get(sp);
+
+	cnt = 1;
+	lno = mp->lno;
+	if (!(k & 1))
+		for (off = mp->cno + 1;; off = 0) {
+			for (; off < len; ++off)
+				if (p[off] == startc)
+					++cnt;
+				else if (p[off] == matchc && --cnt == 0)
+					goto found;
+
+			/* Step over the blocks that can't hold the partner. */
+			for (; mip != NULL && lno % MI_BLOCK == 0;
+			    lno += MI_BLOCK) {
+				if ((sum = v_mi_sum(sp,
+				    mip, lno / MI_BLOCK, k / 2)) == NULL ||
+				    cnt + sum[1] <= 0)
+					break;
+				cnt += sum[0];
+			}
+			if (db_get(sp, ++lno, 0, &p, &len))
+				return (0);
+		}
+	else
+		for (off = mp->cno;; off = len) {
+			while (off > 0)
+				if (p[--off] == startc)
+					++cnt;
+				else if (p[off] == matchc && --cnt == 0)
+					goto found;
+
+			/*
+			 * Step over the blocks that can't hold the partner.
+			 * Walking backward, the lowest depth is relative to
+			 * the end of the block.
+			 */
+			for (; mip != NULL && lno % MI_BLOCK == 1 &&
+			    lno > MI_BLOCK; lno -= MI_BLOCK) {
+				if ((sum = v_mi_sum(sp, mip,
+				    lno / MI_BLOCK - 1, k / 2)) == NULL ||
+				    cnt + sum[1] - sum[0] <= 0)
+					break;
+				cnt -= sum[0];
+			}
+			if (lno == 1 || db_get(sp, --lno, 0, &p, &len))
+				return (0);
+		}
+
+found:	mp->lno = lno;
+	mp->cno = off;
+	*foundp = 1;
+	return (0);
+}
+
+/*
+ * v_mi_get --
+ *	Return the file's bracket depth index, if it's usable.
+ */
+static MINDEX *
+v_mi_get(SCR *sp)
+{
+	EXF *ep;
+	MINDEX *mip;
+	size_t i, len;
+	CHAR_T *mcs;
+
+	ep = sp->ep;
+	mcs = VIP(sp)->mcs;
+	if ((mip = MIP(ep)) == NULL) {
+		if ((mip = calloc(1, sizeof(MINDEX))) == NULL)
+			return (NULL);
+		ep->mindex = mip;
+	}
+	if (mip->mcs != NULL && !STRCMP(mip->mcs, mcs))
+		return (mip->npairs == 0 ? NULL : mip);
+
+	/*
+	 * The match characters changed.  The summaries are sized by the
+	 * number of pairs, toss them.  Blocks are only summarized for
+	 * characters that fit in the class table and appear once.
+	 */
+	free(mip->mcs);
+	free(mip->valid);
+	free(mip->sum);
+	mip->valid = NULL;
+	mip->sum = NULL;
+	mip->nblk = 0;
+	memset(mip->cls, 0, sizeof(mip->cls));
+	mip->npairs = 0;
+	len = STRLEN(mcs);
+	if ((mip->mcs = v_wstrdup(sp, mcs, len)) == NULL)
+		return (NULL);
+	for (i = 0; i < len; ++i) {
+		if ((UCHAR_T)mcs[i] > 0xff || mip->cls[mcs[i]] != 0)
+			return (NULL);
+		mip->cls[mcs[i]] = i + 1;
+	}
+	mip->npairs = len / 2;
+	return (mip);
+}
+
+/*
+ * v_mi_sum --
+ *	Return a block's net and lowest depth for a bracket pair, or NULL
+ *	if the block can't be used.
+ */
+static int *
+v_mi_sum(SCR *sp, MINDEX *mip, recno_t b, int k)
+{
+	recno_t nblk;
+	u_char *valid;
+	int *sum;
+
+	/*
+	 * The lines being input aren't in the file yet, and the lines
+	 * after them are shifted, see db_get().
+	 */
+	if (F_ISSET(sp, SC_TINPUT) &&
+	    (b + 1) * MI_BLOCK >= ((TEXT *)TAILQ_FIRST(sp->tiq))->lno)
+		return (NULL);
+
+	if (b >= mip->nblk) {
+		nblk = b + 64;
+		if ((valid = realloc(mip->valid, nblk)) == NULL)
+			return (NULL);
+		mip->valid = valid;
+		if ((sum = realloc(mip->sum,
+		    nblk * mip->npairs * 2 * sizeof(int))) == NULL)
+			return (NULL);
+		mip->sum = sum;
+		memset(mip->valid + mip->nblk, 0, nblk - mip->nblk);
+		mip->nblk = nblk;
+	}
+	if (!mip->valid[b] && v_mi_build(sp, mip, b))
+		return (NULL);
+	return (mip->sum + (b * mip->npairs + k) * 2);
+}
+
+/*
+ * v_mi_build --
+ *	Summarize a block of lines.
+ */
+static int
+v_mi_build(SCR *sp, MINDEX *mip, recno_t b)
+{
+	recno_t lno;
+	size_t len;
+	int c, k, *sum;
+	CHAR_T *p;
+
+	sum = mip->sum + b * mip->npairs * 2;
+	memset(sum, 0, mip->npairs * 2 * sizeof(int));
+	for (lno = b * MI_BLOCK + 1; lno <= (b + 1) * MI_BLOCK; ++lno) {
+		if (db_get(sp, lno, 0, &p, &len)) {
+			/* A block past the end of the file is no use. */
+			if (lno == b * MI_BLOCK + 1)
+				return (1);
+			break;
+		}
+		for (; len > 0; --len, ++p) {
+			if ((UCHAR_T)*p > 0xff || (c = mip->cls[*p]) == 0 ||
+			    (k = (c - 1) / 2) >= mip->npairs)
+				continue;
+			if (c & 1)
+				++sum[k * 2];
+			else if (--sum[k * 2] < sum[k * 2 + 1])
+				sum[k * 2 + 1] = sum[k * 2];
+		}
+	}
+	mip->valid[b] = 1;
+	return (0);
+}
+
+/*
+ * v_mi_change --
+ *	Discard the bracket depth index blocks invalidated by a change to
+ *	the file.
+ *
+ * PUBLIC: void v_mi_change(SCR *, recno_t, lnop_t);
+ */
+void
+v_mi_change(SCR *sp, recno_t lno, lnop_t op)
+{
+	MINDEX *mip;
+	recno_t b;
+
+	if ((mip = MIP(sp->ep)) == NULL)
+		return;
+	b = lno == 0 ? 0 : (lno - 1) / MI_BLOCK;
+	if (b >= mip->nblk)
+		return;
+	if (op == LINE_RESET)
+		mip->valid[b] = 0;
+	else
+		memset(mip->valid + b, 0, mip->nblk - b);
+}
+
+/*
+ * v_mi_end --
+ *	Discard a file's bracket depth index.
+ *
+ * PUBLIC: void v_mi_end(EXF *);
+ */
+void
+v_mi_end(EXF *ep)
+{
+	MINDEX *mip;
+
+	if ((mip = MIP(ep)) == NULL)
+		return;
+	free(mip->mcs);
+	free(mip->valid);
+	free(mip->sum);
+	free(mip);
+	ep->mindex = NULL;
+}
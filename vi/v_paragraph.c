@@ -23,6 +23,8 @@
 #include "../common/common.h"
 #include "vi.h"
 
+static int	v_pi_build(SCR *, PINDEX *, recno_t);
+
 #define	INTEXT_CHECK do {						\
 	if (len == 0 || v_isempty(p, len)) {				\
 		if (!--cnt)						\
@@ -120,6 +122,16 @@ v_paragraphf(SCR *sp, VICMD *vp)
 	}
 
 	for (;;) {
+		/* Step over blocks that can't change the state. */
+		if (lno % PI_BLOCK == 0 && v_pi_skip(sp, lno / PI_BLOCK,
+		    pstate == P_INTEXT ? PI_EMPTY | PI_PARA : PI_TEXT)) {
+			do {
+				lno += PI_BLOCK;
+			} while (v_pi_skip(sp, lno / PI_BLOCK,
+			    pstate == P_INTEXT ? PI_EMPTY | PI_PARA : PI_TEXT));
+			if (db_get(sp, lno, DBG_FATAL, &p, &len))
+				return (1);
+		}
 		lastlno = lno;
 		lastlen = len;
 		if (db_get(sp, ++lno, 0, &p, &len))
@@ -273,6 +285,10 @@ v_paragraphb(SCR *sp, VICMD *vp)
 	}
 
 	for (;;) {
+		while ((lno - 1) % PI_BLOCK == 0 && lno > PI_BLOCK &&
+		    v_pi_skip(sp, (lno - 1) / PI_BLOCK - 1,
+		    pstate == P_INTEXT ? PI_EMPTY | PI_PARA : PI_TEXT))
+			lno -= PI_BLOCK;
 		if (db_get(sp, --lno, 0, &p, &len))
 			goto sof;
 		switch (pstate) {
@@ -340,3 +356,154 @@ v_buildps(SCR *sp, char *p_p, char *s_p)
 	vip->ps = p;
 	return (0);
 }
+
+/*
+ * v_pi_skip --
+ *	Return if a block of lines has none of the kinds of lines in
+ *	the mask, and can be stepped over.
+ *
+ * PUBLIC: int v_pi_skip(SCR *, recno_t, int);
+ */
+int
+v_pi_skip(SCR *sp, recno_t b, int mask)
+{
+	EXF *ep;
+	PINDEX *pip;
+	recno_t nblk;
+	u_char *flags;
+	char *ps, *sect;
+
+	ep = sp->ep;
+	if ((ps = VIP(sp)->ps) == NULL)
+		ps = "";
+	if ((sect = O_STR(sp, O_SECTIONS)) == NULL)
+		sect = "";
+	if ((pip = PIP(ep)) == NULL) {
+		if ((pip = calloc(1, sizeof(PINDEX))) == NULL)
+			return (0);
+		ep->pindex = pip;
+	}
+
+	/* The index is per file, the macros per screen; rebuild if changed. */
+	if (pip->ps == NULL || strcmp(pip->ps, ps) ||
+	    pip->sect == NULL || strcmp(pip->sect, sect)) {
+		free(pip->ps);
+		free(pip->sect);
+		pip->ps = strdup(ps);
+		pip->sect = strdup(sect);
+		if (pip->ps == NULL || pip->sect == NULL)
+			return (0);
+		if (pip->nblk != 0)
+			memset(pip->flags, 0, pip->nblk);
+	}
+
+	if (b >= pip->nblk) {
+		nblk = b + 64;
+		if ((flags = realloc(pip->flags, nblk)) == NULL)
+			return (0);
+		memset(flags + pip->nblk, 0, nblk - pip->nblk);
+		pip->flags = flags;
+		pip->nblk = nblk;
+	}
+	if (!(pip->flags[b] & PI_VALID) && v_pi_build(sp, pip, b))
+		return (0);
+	return ((pip->flags[b] & (PI_FULL | mask)) == PI_FULL);
+}
+
+/*
+ * v_pi_build --
+ *	Summarize a block of lines.
+ */
+static int
+v_pi_build(SCR *sp, PINDEX *pip, recno_t b)
+{
+	recno_t lno;
+	size_t len;
+	int f;
+	CHAR_T *p;
+	char *lp;
+
+	for (f = PI_VALID | PI_FULL,
+	    lno = b * PI_BLOCK + 1; lno <= (b + 1) * PI_BLOCK; ++lno) {
+		if (db_get(sp, lno, 0, &p, &len)) {
+			if (lno == b * PI_BLOCK + 1)
+				return (1);
+			f &= ~PI_FULL;
+			break;
+		}
+		if (len == 0 || v_isempty(p, len)) {
+			f |= PI_EMPTY;
+			continue;
+		}
+		f |= PI_TEXT;
+		switch (p[0]) {
+		case '\014':
+			f |= PI_PARA | PI_SECT;
+			break;
+		case '{':
+			f |= PI_SECT;
+			break;
+		case '}':
+			f |= PI_CLOSE;
+			break;
+		case '.':
+			if (len < 2)
+				break;
+			for (lp = pip->ps; *lp != '\0'; lp += 2)
+				if (lp[0] == p[1] && ((lp[1] == ' ' && len == 2) ||
+				    (len > 2 && lp[1] == p[2])))
+					f |= PI_PARA;
+			for (lp = pip->sect; *lp != '\0'; lp += 2)
+				if (lp[0] == p[1] && ((lp[1] == ' ' && len == 2) ||
+				    (len > 2 && lp[1] == p[2])))
+					f |= PI_SECT;
+			break;
+		}
+	}
+	pip->flags[b] = f;
+	return (0);
+}
+
+/*
+ * v_pi_change --
+ *	Discard the paragraph and section index blocks invalidated by a
+ *	change to the file.
+ *
+ * PUBLIC: void v_pi_change(SCR *, recno_t, lnop_t);
+ */
+void
+v_pi_change(SCR *sp, recno_t lno, lnop_t op)
+{
+	PINDEX *pip;
+	recno_t b;
+
+	if ((pip = PIP(sp->ep)) == NULL)
+		return;
+	b = lno == 0 ? 0 : (lno - 1) / PI_BLOCK;
+	if (b >= pip->nblk)
+		return;
+	if (op == LINE_RESET)
+		pip->flags[b] = 0;
+	else
+		memset(pip->flags + b, 0, pip->nblk - b);
+}
+
+/*
+ * v_pi_end --
+ *	Discard a file's paragraph and section index.
+ *
+ * PUBLIC: void v_pi_end(EXF *);
+ */
+void
+v_pi_end(EXF *ep)
+{
+	PINDEX *pip;
+
+	if ((pip = PIP(ep)) == NULL)
+		return;
+	free(pip->ps);
+	free(pip->sect);
+	free(pip->flags);
+	free(pip);
+	ep->pindex = NULL;
+}
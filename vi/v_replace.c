@@ -52,6 +52,9 @@ v_replace(SCR *sp, VICMD *vp)
 
 	vip = VIP(sp);
 
+	if (db_paged(sp))
+		return (1);
+
 	/*
 	 * If the line doesn't exist, or it's empty, replacement isn't
 	 * allowed.  It's not hard to implement, but:
@@ -184,7 +187,7 @@ next:		if (v_event_get(sp, &ev, 0, 0))
 		if (db_append(sp, 1, vp->m_start.lno, tp->lb, tp->len))
 err_ret:		rval = 1;
 		else {
-			text_free(tp);
+			text_free(sp, tp);
 			rval = 0;
 		}
 	} else {
@@ -62,6 +62,7 @@ v_sectionf(SCR *sp, VICMD *vp)
 {
 	recno_t cnt, lno;
 	size_t len;
+	int mask;
 	CHAR_T *p;
 	char *list, *lp;
 
@@ -90,8 +91,15 @@ v_sectionf(SCR *sp, VICMD *vp)
 		}
 	}
 
+	/* Step over blocks without sections. */
+	mask = ISMOTION(vp) ? PI_SECT | PI_CLOSE : PI_SECT;
 	cnt = F_ISSET(vp, VC_C1SET) ? vp->count : 1;
-	for (lno = vp->m_start.lno; !db_get(sp, ++lno, 0, &p, &len);) {
+	for (lno = vp->m_start.lno;;) {
+		while (lno % PI_BLOCK == 0 &&
+		    v_pi_skip(sp, lno / PI_BLOCK, mask))
+			lno += PI_BLOCK;
+		if (db_get(sp, ++lno, 0, &p, &len))
+			break;
 		if (len == 0)
 			continue;
 		if (p[0] == '{' || (ISMOTION(vp) && p[0] == '}')) {
@@ -184,7 +192,12 @@ v_sectionb(SCR *sp, VICMD *vp)
 		return (1);
 
 	cnt = F_ISSET(vp, VC_C1SET) ? vp->count : 1;
-	for (lno = vp->m_start.lno; !db_get(sp, --lno, 0, &p, &len);) {
+	for (lno = vp->m_start.lno;;) {
+		while ((lno - 1) % PI_BLOCK == 0 && lno > PI_BLOCK &&
+		    v_pi_skip(sp, (lno - 1) / PI_BLOCK - 1, PI_SECT))
+			lno -= PI_BLOCK;
+		if (db_get(sp, --lno, 0, &p, &len))
+			break;
 		if (len == 0)
 			continue;
 		if (p[0] == '{') {
@@ -79,8 +79,14 @@ v_sentencef(SCR *sp, VICMD *vp)
 		}
 	}
 
+	/*
+	 * Outside of a sentence end, nothing but sentence punctuation
+	 * changes the state, skip to it a line at a time.
+	 */
 	for (state = NONE;;) {
-		if (cs_next(sp, &cs))
+		if (state == NONE ? cs_fspan(sp, &cs,
+		    CS_CBLANK | CS_CWORD | CS_CPUNCT | CS_CCLOSE) :
+		    cs_next(sp, &cs))
 			return (1);
 		if (cs.cs_flags == CS_EOF)
 			break;
@@ -237,8 +243,13 @@ v_sentenceb(SCR *sp, VICMD *vp)
 				break;
 		}
 
+	/*
+	 * Characters other than blanks and sentence punctuation leave last
+	 * unset, skip them a line at a time once it's clear.
+	 */
 	for (last = 0;;) {
-		if (cs_prev(sp, &cs))
+		if (last ? cs_prev(sp, &cs) :
+		    cs_bspan(sp, &cs, CS_CWORD | CS_CPUNCT))
 			return (1);
 		if (cs.cs_flags == CS_SOF)	/* SOF is a movement sink. */
 			break;
@@ -293,7 +293,7 @@ v_txt(
 		tp = TAILQ_FIRST(tiqh);
 		if (TAILQ_NEXT(tp, q) != NULL ||
 		    tp->lb_len < (len + 32) * sizeof(CHAR_T)) {
-			text_lfree(tiqh);
+			text_lfree(sp, tiqh);
 			goto newtp;
 		}
 		tp->ai = tp->insert = tp->offset = tp->owrite = 0;
@@ -1814,7 +1814,7 @@ txt_backup(SCR *sp, TEXTH *tiqh, TEXT *tp, u_int32_t *flagsp)
 
 	/* Release the current TEXT. */
 	TAILQ_REMOVE(tiqh, tp, q);
-	text_free(tp);
+	text_free(sp, tp);
 
 	/* Update the old line on the screen. */
 	if (vs_change(sp, ntp->lno + 1, LINE_DELETE))
@@ -2698,9 +2698,8 @@ static int
 txt_showmatch(SCR *sp, TEXT *tp)
 {
 	GS *gp;
-	VCS cs;
-	MARK m;
-	int cnt, endc, startc;
+	MARK m, match;
+	int found;
 
 	gp = sp->gp;
 
@@ -2719,36 +2718,22 @@ txt_showmatch(SCR *sp, TEXT *tp)
 	if (vs_sm_position(sp, &m, 0, P_TOP))
 		return (1);
 
-	/* Initialize the getc() interface. */
-	cs.cs_lno = tp->lno;
-	cs.cs_cno = tp->cno - 1;
-	if (cs_init(sp, &cs))
-		return (1);
-	startc = STRCHR(VIP(sp)->mcs, endc = cs.cs_ch)[-1];
-
 	/* Search for the match. */
-	for (cnt = 1;;) {
-		if (cs_prev(sp, &cs))
-			return (1);
-		if (cs.cs_flags != 0) {
-			if (cs.cs_flags == CS_EOF || cs.cs_flags == CS_SOF) {
-				msgq(sp, M_BERR,
-				    "Unmatched %s", KEY_NAME(sp, endc));
-				return (0);
-			}
-			continue;
-		}
-		if (cs.cs_ch == endc)
-			++cnt;
-		else if (cs.cs_ch == startc && --cnt == 0)
-			break;
+	match.lno = tp->lno;
+	match.cno = tp->cno - 1;
+	if (v_mi_find(sp, &match, &found))
+		return (1);
+	if (!found) {
+		msgq(sp, M_BERR,
+		    "Unmatched %s", KEY_NAME(sp, tp->lb[tp->cno - 1]));
+		return (0);
 	}
 
 	/* If the match is on the screen, move to it. */
-	if (cs.cs_lno < m.lno || (cs.cs_lno == m.lno && cs.cs_cno < m.cno))
+	if (match.lno < m.lno || (match.lno == m.lno && match.cno < m.cno))
 		return (0);
-	sp->lno = cs.cs_lno;
-	sp->cno = cs.cs_cno;
+	sp->lno = match.lno;
+	sp->cno = match.cno;
 	if (vs_refresh(sp, 1))
 		return (1);
 
@@ -97,9 +97,9 @@ v_wordw(SCR *sp, VICMD *vp)
 static int
 fword(SCR *sp, VICMD *vp, enum which type)
 {
-	enum { INWORD, NOTWORD } state;
 	VCS cs;
 	u_long cnt;
+	int mask;
 
 	cnt = F_ISSET(vp, VC_C1SET) ? vp->count : 1;
 	cs.cs_lno = vp->m_start.lno;
@@ -137,14 +137,10 @@ fword(SCR *sp, VICMD *vp, enum which type)
 	 */
 	if (type == BIGWORD)
 		while (cnt--) {
-			for (;;) {
-				if (cs_next(sp, &cs))
-					return (1);
-				if (cs.cs_flags == CS_EOF)
-					goto ret;
-				if (cs.cs_flags != 0 || ISBLANK(cs.cs_ch))
-					break;
-			}
+			if (cs_fspan(sp, &cs, CS_CNONBLANK))
+				return (1);
+			if (cs.cs_flags == CS_EOF)
+				goto ret;
 			/*
 			 * If a motion command and we're at the end of the
 			 * last word, we're done.  Delete and yank eat any
@@ -167,22 +163,12 @@ fword(SCR *sp, VICMD *vp, enum which type)
 		}
 	else
 		while (cnt--) {
-			state = cs.cs_flags == 0 &&
-			    inword(cs.cs_ch) ? INWORD : NOTWORD;
-			for (;;) {
-				if (cs_next(sp, &cs))
-					return (1);
-				if (cs.cs_flags == CS_EOF)
-					goto ret;
-				if (cs.cs_flags != 0 || ISBLANK(cs.cs_ch))
-					break;
-				if (state == INWORD) {
-					if (!inword(cs.cs_ch))
-						break;
-				} else
-					if (inword(cs.cs_ch))
-						break;
-			}
+			mask = cs.cs_flags == 0 &&
+			    inword(cs.cs_ch) ? CS_CWORD : CS_CNOTWORD;
+			if (cs_fspan(sp, &cs, mask))
+				return (1);
+			if (cs.cs_flags == CS_EOF)
+				goto ret;
 			/* See comment above. */
 			if (cnt == 0 && ISMOTION(vp)) {
 				if ((ISCMD(vp->rkp, 'd') ||
@@ -257,9 +243,9 @@ v_worde(SCR *sp, VICMD *vp)
 static int
 eword(SCR *sp, VICMD *vp, enum which type)
 {
-	enum { INWORD, NOTWORD } state;
 	VCS cs;
 	u_long cnt;
+	int mask;
 
 	cnt = F_ISSET(vp, VC_C1SET) ? vp->count : 1;
 	cs.cs_lno = vp->m_start.lno;
@@ -290,14 +276,10 @@ eword(SCR *sp, VICMD *vp, enum which type)
 	 */
 start:	if (type == BIGWORD)
 		while (cnt--) {
-			for (;;) {
-				if (cs_next(sp, &cs))
-					return (1);
-				if (cs.cs_flags == CS_EOF)
-					goto ret;
-				if (cs.cs_flags != 0 || ISBLANK(cs.cs_ch))
-					break;
-			}
+			if (cs_fspan(sp, &cs, CS_CNONBLANK))
+				return (1);
+			if (cs.cs_flags == CS_EOF)
+				goto ret;
 			/*
 			 * When we reach the start of the word after the last
 			 * word, we're done.  If we changed state, back up one
@@ -317,22 +299,12 @@ start:	if (type == BIGWORD)
 		}
 	else
 		while (cnt--) {
-			state = cs.cs_flags == 0 &&
-			    inword(cs.cs_ch) ? INWORD : NOTWORD;
-			for (;;) {
-				if (cs_next(sp, &cs))
-					return (1);
-				if (cs.cs_flags == CS_EOF)
-					goto ret;
-				if (cs.cs_flags != 0 || ISBLANK(cs.cs_ch))
-					break;
-				if (state == INWORD) {
-					if (!inword(cs.cs_ch))
-						break;
-				} else
-					if (inword(cs.cs_ch))
-						break;
-			}
+			mask = cs.cs_flags == 0 &&
+			    inword(cs.cs_ch) ? CS_CWORD : CS_CNOTWORD;
+			if (cs_fspan(sp, &cs, mask))
+				return (1);
+			if (cs.cs_flags == CS_EOF)
+				goto ret;
 			/* See comment above. */
 			if (cnt == 0) {
 				if (cs.cs_flags == 0 && cs_prev(sp, &cs))
@@ -403,9 +375,9 @@ v_wordb(SCR *sp, VICMD *vp)
 static int
 bword(SCR *sp, VICMD *vp, enum which type)
 {
-	enum { INWORD, NOTWORD } state;
 	VCS cs;
 	u_long cnt;
+	int mask;
 
 	cnt = F_ISSET(vp, VC_C1SET) ? vp->count : 1;
 	cs.cs_lno = vp->m_start.lno;
@@ -437,14 +409,10 @@ bword(SCR *sp, VICMD *vp, enum which type)
 	 */
 start:	if (type == BIGWORD)
 		while (cnt--) {
-			for (;;) {
-				if (cs_prev(sp, &cs))
-					return (1);
-				if (cs.cs_flags == CS_SOF)
-					goto ret;
-				if (cs.cs_flags != 0 || ISBLANK(cs.cs_ch))
-					break;
-			}
+			if (cs_bspan(sp, &cs, CS_CNONBLANK))
+				return (1);
+			if (cs.cs_flags == CS_SOF)
+				goto ret;
 			/*
 			 * When we reach the end of the word before the last
 			 * word, we're done.  If we changed state, move forward
@@ -464,22 +432,12 @@ start:	if (type == BIGWORD)
 		}
 	else
 		while (cnt--) {
-			state = cs.cs_flags == 0 &&
-			    inword(cs.cs_ch) ? INWORD : NOTWORD;
-			for (;;) {
-				if (cs_prev(sp, &cs))
-					return (1);
-				if (cs.cs_flags == CS_SOF)
-					goto ret;
-				if (cs.cs_flags != 0 || ISBLANK(cs.cs_ch))
-					break;
-				if (state == INWORD) {
-					if (!inword(cs.cs_ch))
-						break;
-				} else
-					if (inword(cs.cs_ch))
-						break;
-			}
+			mask = cs.cs_flags == 0 &&
+			    inword(cs.cs_ch) ? CS_CWORD : CS_CNOTWORD;
+			if (cs_bspan(sp, &cs, mask))
+				return (1);
+			if (cs.cs_flags == CS_SOF)
+				goto ret;
 			/* See comment above. */
 			if (cnt == 0) {
 				if (cs.cs_flags == 0 && cs_next(sp, &cs))
@@ -34,6 +34,7 @@ static VIKEYS const
 static gcret_t	v_cmd(SCR *, VICMD *, VICMD *, VICMD *, int *, int *);
 static int	v_count(SCR *, ARG_CHAR_T, u_long *);
 static void	v_dtoh(SCR *);
+static int	v_follow(SCR *);
 static int	v_init(SCR *);
 static gcret_t	v_key(SCR *, int, EVENT *, u_int32_t);
 static int	v_motion(SCR *, VICMD *, VICMD *, int *);
@@ -84,6 +85,9 @@ vi(SCR **spp)
 	(void)sp->gp->scr_rename(sp, sp->frp->name, 1);
 
 	for (vip = VIP(sp), rval = 0;;) {
+		/* Free the memory the last command grew the pools to. */
+		pool_reclaim(gp);
+
 		/* Resolve messages. */
 		if (!MAPPED_KEYS_WAITING(sp) && vs_resolve(sp, NULL, 0))
 			goto ret;
@@ -129,6 +133,13 @@ vi(SCR **spp)
 			goto ex_continue;
 		}
 
+		/*
+		 * If files are being followed, read their new lines until
+		 * there's a key.
+		 */
+		if (F_ISSET(gp, G_FOLLOW) && v_follow(sp))
+			goto ret;
+
 		/* Refresh the command structure. */
 		memset(vp, 0, sizeof(VICMD));
 
@@ -223,8 +234,12 @@ vi(SCR **spp)
 		v_comlog(sp, vp);
 #endif
 		/* Call the function. */
-ex_continue:	if (vp->kp->func(sp, vp))
+ex_continue:	TR_EVENT(sp, TR_COMMAND, TR_BEGIN, vp->key);
+		if (vp->kp->func(sp, vp)) {
+			TR_EVENT(sp, TR_COMMAND, TR_END, 1);
 			goto err;
+		}
+		TR_EVENT(sp, TR_COMMAND, TR_END, 0);
 gc_event:
 #ifdef DEBUG
 		/* Make sure no function left the temporary space locked. */
@@ -1218,6 +1233,27 @@ v_key(
 	/* NOTREACHED */
 }
 
+/*
+ * v_follow --
+ *	Wait for a key, reading the new lines of followed files every
+ *	followtime tenths of a second.
+ */
+static int
+v_follow(SCR *sp)
+{
+	GS *gp;
+
+	for (gp = sp->gp; F_ISSET(gp, G_FOLLOW) && gp->i_cnt == 0;) {
+		if (fol_input(sp) &&
+		    (vs_resolve(sp, NULL, 0) || vs_refresh(sp, 0)))
+			return (1);
+		if (v_event_get(sp, NULL,
+		    MAX(O_VAL(sp, O_FOLLOWTIME), 1) * 100, EC_TIMEOUT))
+			return (1);
+	}
+	return (0);
+}
+
 #if defined(DEBUG) && defined(COMLOG)
 /*
  * v_comlog --
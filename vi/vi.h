@@ -159,9 +159,24 @@ typedef struct _vcs {
 	int	 cs_flags;		/* Return flags. */
 } VCS;
 
+/*
+ * Character classes for cs_fspan() and cs_bspan().  Every character is in
+ * exactly one class; the sentence punctuation has classes of its own so the
+ * sentence motions can skip the text between sentence ends.
+ */
+#define	CS_CBLANK	0x01		/* Blank. */
+#define	CS_CWORD	0x02		/* Word, see inword(). */
+#define	CS_CPUNCT	0x04		/* Other non-blank. */
+#define	CS_CCLOSE	0x08		/* Sentence close: ) ] " ' */
+#define	CS_CEND		0x10		/* Sentence end: . ? ! */
+#define	CS_CNOTWORD	(CS_CPUNCT | CS_CCLOSE | CS_CEND)
+#define	CS_CNONBLANK	(CS_CWORD | CS_CNOTWORD)
+
 int	cs_bblank(SCR *, VCS *);
+int	cs_bspan(SCR *, VCS *, int);
 int	cs_fblank(SCR *, VCS *);
 int	cs_fspace(SCR *, VCS *);
+int	cs_fspan(SCR *, VCS *, int);
 int	cs_init(SCR *, VCS *);
 int	cs_next(SCR *, VCS *);
 int	cs_prev(SCR *, VCS *);
@@ -316,6 +331,100 @@ typedef struct _vi_private {
 /* Vi private area. */
 #define	VIP(sp)	((VI_PRIVATE *)((sp)->vi_private))
 
+/*
+ * Line width cache.
+ *
+ * The screen columns of recently displayed lines are kept per file, so
+ * vertical motion and paging over long, folded lines don't rescan the
+ * line.  The cache is direct-mapped on the line number.  Each entry is
+ * tagged with the screen width, tabstop and display options it was built
+ * for, and the db_* routines discard the entries a change invalidates.
+ * The screen line break offsets used by vs_colpos() are built on demand.
+ *
+ * The cache also keeps the screen lines taken by each block of WC_BLOCK
+ * lines, so scrolling a long way can step over whole blocks.  A block is
+ * summed the first time a scroll reaches it, for the screen width, tabstop
+ * and display options in the cache, and changes discard the sums.
+ */
+#define	WC_SLOTS	256		/* Cache slots, power of 2. */
+#define	WC_BLOCK	256		/* Lines per screen line block. */
+typedef struct _wcent {
+	recno_t	 lno;		/* 1-N: line number, OOBLNO if unused. */
+	size_t	 cols;		/* Screen columns. */
+	u_long	 ts;		/* Tabstop. */
+	size_t	 ncols;		/* vs_columns() display width. */
+	size_t	 diff;		/* vs_columns() last character width. */
+	size_t	*brk;		/* Screen line offset, column pairs. */
+	size_t	 nbrk;		/* Screen line breaks. */
+
+#define	WC_LEFTRIGHT	0x01	/* O_LEFTRIGHT set. */
+#define	WC_LIST		0x02	/* O_LIST set. */
+#define	WC_NUMBER	0x04	/* O_NUMBER set. */
+	u_int8_t flags;
+} WCENT;
+
+typedef struct _wcache {
+	WCENT	 ent[WC_SLOTS];	/* Cache slots. */
+	recno_t	 high;		/* Highest cached line number. */
+
+	size_t	*blk;		/* Block screen lines, 0 if not summed. */
+	recno_t	 nblk;		/* Blocks allocated. */
+	size_t	 bcols;		/* Block sums: screen columns. */
+	u_long	 bts;		/* Block sums: tabstop. */
+	u_int8_t bflags;	/* Block sums: WC_* flags. */
+} WCACHE;
+
+#define	WCP(ep)	((WCACHE *)((ep)->wcache))
+
+/*
+ * Bracket depth index.
+ *
+ * Finding the partner of a bracket means walking the file a character at
+ * a time.  For each block of MI_BLOCK lines, the index keeps the net depth
+ * change for each matchchars pair, and the lowest depth reached walking
+ * forward through the block, so searches in either direction can step
+ * over blocks that can't hold the partner.  Blocks are summarized when a
+ * search first reaches them, and the db_* routines discard the summaries
+ * a change invalidates.
+ */
+#define	MI_BLOCK	256		/* Lines per block. */
+typedef struct _mindex {
+	CHAR_T	*mcs;		/* Match characters indexed. */
+	int	 npairs;	/* Bracket pairs, 0 if not indexable. */
+	u_char	 cls[256];	/* 1-N: character's offset in mcs, plus 1. */
+	recno_t	 nblk;		/* Blocks allocated. */
+	u_char	*valid;		/* Block summary is valid. */
+	int	*sum;		/* Block and pair: net and lowest depth. */
+} MINDEX;
+
+#define	MIP(ep)	((MINDEX *)((ep)->mindex))
+
+/*
+ * Paragraph and section index.
+ *
+ * For each block of PI_BLOCK lines, the index keeps which kinds of lines
+ * the paragraph and section motions stop on appear in the block, so they
+ * can step over blocks of plain text, or of empty lines, without reading
+ * them.  As with the bracket depth index, blocks are summarized when a
+ * motion first reaches them, and changes discard the summaries.
+ */
+#define	PI_BLOCK	256		/* Lines per block. */
+#define	PI_VALID	0x01		/* Summary is valid. */
+#define	PI_FULL		0x02		/* All of the block's lines exist. */
+#define	PI_EMPTY	0x04		/* Empty lines. */
+#define	PI_TEXT		0x08		/* Non-empty lines. */
+#define	PI_PARA		0x10		/* Formfeed, paragraph or section macro. */
+#define	PI_SECT		0x20		/* {, formfeed, section macro. */
+#define	PI_CLOSE	0x40		/* }. */
+typedef struct _pindex {
+	char	*ps;		/* Paragraph and section macros indexed. */
+	char	*sect;		/* Section macros indexed. */
+	recno_t	 nblk;		/* Blocks allocated. */
+	u_char	*flags;		/* Block flags. */
+} PINDEX;
+
+#define	PIP(ep)	((PINDEX *)((ep)->pindex))
+
 #define	O_NUMBER_FMT	"%7lu "			/* O_NUMBER format, length. */
 #define	O_NUMBER_LENGTH	8
 #define	SCREEN_COLS(sp)				/* Screen columns. */	\
@@ -71,6 +71,7 @@ vs_line(SCR *sp, SMAP *smp, size_t *yp, size_t *xp)
 	is_cached = SMAP_CACHE(smp);
 	if (yp == NULL && (is_cached || no_draw))
 		return (0);
+	STAT_INC(sp, vs_line);
 
 	/*
 	 * A nasty side effect of this routine is that it returns the screen
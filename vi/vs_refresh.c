@@ -66,9 +66,10 @@ vs_refresh(
 	GS *gp;
 	SCR *tsp;
 	int need_refresh = 0;
-	u_int priv_paint, pub_paint;
+	u_int flags, priv_paint, pub_paint;
 
 	gp = sp->gp;
+	TR_EVENT(sp, TR_REFRESH, TR_BEGIN, forcepaint);
 
 	/*
 	 * 1: Refresh the screen.
@@ -98,9 +99,11 @@ vs_refresh(
 		if (tsp != sp && !F_ISSET(tsp, SC_EXIT | SC_EXIT_FORCE) &&
 		    (F_ISSET(tsp, pub_paint) ||
 		    F_ISSET(VIP(tsp), priv_paint))) {
-			(void)vs_paint(tsp,
-			    (F_ISSET(VIP(tsp), VIP_CUR_INVALID) ?
-			    UPDATE_CURSOR : 0) | UPDATE_SCREEN);
+			flags = (F_ISSET(VIP(tsp), VIP_CUR_INVALID) ?
+			    UPDATE_CURSOR : 0) | UPDATE_SCREEN;
+			TR_EVENT(sp, TR_PAINT, TR_BEGIN, flags);
+			(void)vs_paint(tsp, flags);
+			TR_EVENT(sp, TR_PAINT, TR_END, 0);
 			F_SET(VIP(sp), VIP_CUR_INVALID);
 		}
 
@@ -111,9 +114,15 @@ vs_refresh(
 	 * Also, always do it last -- that way, SC_SCR_REDRAW can be set
 	 * in the current screen only, and the screen won't flash.
 	 */
-	if (vs_paint(sp, UPDATE_CURSOR | (!forcepaint &&
-	    F_ISSET(sp, SC_SCR_VI) && KEYS_WAITING(sp) ? 0 : UPDATE_SCREEN)))
+	flags = UPDATE_CURSOR | (!forcepaint &&
+	    F_ISSET(sp, SC_SCR_VI) && KEYS_WAITING(sp) ? 0 : UPDATE_SCREEN);
+	TR_EVENT(sp, TR_PAINT, TR_BEGIN, flags);
+	if (vs_paint(sp, flags)) {
+		TR_EVENT(sp, TR_PAINT, TR_END, 1);
+		TR_EVENT(sp, TR_REFRESH, TR_END, 1);
 		return (1);
+	}
+	TR_EVENT(sp, TR_PAINT, TR_END, 0);
 
 	/*
 	 * 4: Paint any missing status lines.
@@ -142,6 +151,7 @@ vs_refresh(
 	 * for everything else, i.e. messages.
 	 */
 	F_SET(sp, SC_SCR_VI);
+	TR_EVENT(sp, TR_REFRESH, TR_END, 0);
 	return (0);
 }
 
@@ -177,6 +187,7 @@ vs_paint(
 	gp = sp->gp;
 	vip = VIP(sp);
 	didpaint = leftright_warp = 0;
+	STAT_INC(sp, vs_paint);
 
 	/*
 	 * 5: Reformat the lines.
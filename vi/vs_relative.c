@@ -16,11 +16,19 @@
 #include <bitstring.h>
 #include <limits.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "../common/common.h"
 #include "vi.h"
 
+static size_t	vs_columns1(SCR *, CHAR_T *, recno_t, size_t *, size_t *);
+static int	vs_wc_brk(SCR *, WCENT *, CHAR_T *, size_t);
+static void	vs_wc_clear(WCENT *);
+static u_int8_t	vs_wc_flags(SCR *);
+static WCENT	*vs_wc_get(SCR *, recno_t);
+static WCACHE	*vs_wc_init(SCR *);
+
 /*
  * vs_column --
  *	Return the logical column of the cursor in the line.
@@ -93,6 +101,25 @@ vs_screens(SCR *sp, recno_t lno, size_t *cnop)
  */
 size_t
 vs_columns(SCR *sp, CHAR_T *lp, recno_t lno, size_t *cnop, size_t *diffp)
+{
+	WCENT *wp;
+
+	/* Whole lines from the file are kept in the line width cache. */
+	if (lp == NULL && cnop == NULL && (wp = vs_wc_get(sp, lno)) != NULL) {
+		if (diffp != NULL)
+			*diffp = wp->diff;
+		return (wp->ncols);
+	}
+	return (vs_columns1(sp, lp, lno, cnop, diffp));
+}
+
+/*
+ * vs_columns1 --
+ *	Walk the line, returning the screen columns necessary to display
+ *	it or the physical character column within it.
+ */
+static size_t
+vs_columns1(SCR *sp, CHAR_T *lp, recno_t lno, size_t *cnop, size_t *diffp)
 {
 	size_t chlen, cno, curoff, last = 0, len, scno;
 	int ch, leftright, listset;
@@ -220,6 +247,7 @@ vs_rcm(SCR *sp, recno_t lno, int islast)
 size_t
 vs_colpos(SCR *sp, recno_t lno, size_t cno)
 {
+	WCENT *wp;
 	size_t chlen, curoff, len, llen, off, scno;
 	int ch = 0, leftright, listset;
 	CHAR_T *lp, *p;
@@ -238,7 +266,25 @@ vs_colpos(SCR *sp, recno_t lno, size_t cno)
 	/* Discard screen (logical) lines. */
 	off = cno / sp->cols;
 	cno %= sp->cols;
-	for (scno = 0, p = lp, len = llen; off--;) {
+	scno = 0;
+	p = lp;
+	len = llen;
+
+	/*
+	 * If the line is in the line width cache, skip straight to the
+	 * start of the screen line.
+	 */
+	if (off != 0 && (wp = vs_wc_get(sp, lno)) != NULL &&
+	    (wp->brk != NULL || !vs_wc_brk(sp, wp, lp, llen))) {
+		if (off > wp->nbrk)
+			return (llen - 1);
+		p = lp + wp->brk[(off - 1) * 2];
+		len = llen - (p - lp);
+		scno = wp->brk[(off - 1) * 2 + 1];
+		off = 0;
+	}
+
+	for (; off--;) {
 		for (; len && scno < sp->cols; --len)
 			scno += CHLEN(scno);
 
@@ -289,3 +335,278 @@ vs_colpos(SCR *sp, recno_t lno, size_t cno)
 	/* No such character; return the start of the last character. */
 	return (llen - 1);
 }
+
+/*
+ * vs_wc_get --
+ *	Return the line width cache entry for a line, filling it in if
+ *	necessary.
+ */
+static WCENT *
+vs_wc_get(SCR *sp, recno_t lno)
+{
+	WCACHE *wcp;
+	WCENT *wp;
+	u_int8_t flags;
+
+	if ((wcp = vs_wc_init(sp)) == NULL)
+		return (NULL);
+	flags = vs_wc_flags(sp);
+
+	wp = &wcp->ent[lno & (WC_SLOTS - 1)];
+	if (wp->lno == lno && wp->cols == sp->cols &&
+	    wp->ts == O_VAL(sp, O_TABSTOP) && wp->flags == flags)
+		return (wp);
+
+	/* Don't cache lines that don't exist. */
+	if (db_get(sp, lno, 0, NULL, NULL))
+		return (NULL);
+
+	vs_wc_clear(wp);
+	wp->ncols = vs_columns1(sp, NULL, lno, NULL, &wp->diff);
+	wp->cols = sp->cols;
+	wp->ts = O_VAL(sp, O_TABSTOP);
+	wp->flags = flags;
+	wp->lno = lno;
+	if (lno > wcp->high)
+		wcp->high = lno;
+	return (wp);
+}
+
+/*
+ * vs_wc_rows --
+ *	Return the screen lines needed to display a block of WC_BLOCK
+ *	lines, summing them if necessary.  Fails if the block isn't all
+ *	in the file.
+ *
+ * PUBLIC: int vs_wc_rows(SCR *, recno_t, size_t *);
+ */
+int
+vs_wc_rows(SCR *sp, recno_t b, size_t *rowsp)
+{
+	WCACHE *wcp;
+	recno_t lno, nblk;
+	size_t cols, rows, *blk;
+	u_int8_t flags;
+
+	if ((wcp = vs_wc_init(sp)) == NULL)
+		return (1);
+	flags = vs_wc_flags(sp);
+	if (wcp->bcols != sp->cols ||
+	    wcp->bts != O_VAL(sp, O_TABSTOP) || wcp->bflags != flags) {
+		if (wcp->nblk != 0)
+			memset(wcp->blk, 0, wcp->nblk * sizeof(size_t));
+		wcp->bcols = sp->cols;
+		wcp->bts = O_VAL(sp, O_TABSTOP);
+		wcp->bflags = flags;
+	}
+	if (b >= wcp->nblk) {
+		nblk = b + 64;
+		if ((blk = realloc(wcp->blk, nblk * sizeof(size_t))) == NULL)
+			return (1);
+		memset(blk + wcp->nblk, 0, (nblk - wcp->nblk) * sizeof(size_t));
+		wcp->blk = blk;
+		wcp->nblk = nblk;
+	}
+	if (wcp->blk[b] == 0) {
+		if (!db_exist(sp, (b + 1) * WC_BLOCK))
+			return (1);
+		for (rows = 0,
+		    lno = b * WC_BLOCK + 1; lno <= (b + 1) * WC_BLOCK; ++lno) {
+			if (flags & WC_LEFTRIGHT) {
+				++rows;
+				continue;
+			}
+			cols = vs_columns1(sp, NULL, lno, NULL, NULL);
+			if ((cols = cols / sp->cols +
+			    (cols % sp->cols ? 1 : 0)) == 0)
+				cols = 1;
+			rows += cols;
+		}
+		wcp->blk[b] = rows;
+	}
+	*rowsp = wcp->blk[b];
+	return (0);
+}
+
+/*
+ * vs_wc_init --
+ *	Return the file's line width cache, allocating it if necessary.
+ */
+static WCACHE *
+vs_wc_init(SCR *sp)
+{
+	EXF *ep;
+	WCACHE *wcp;
+
+	/*
+	 * Lines being edited aren't in the file yet, and the line numbers
+	 * of the lines after them are shifted, see db_get().
+	 */
+	if ((ep = sp->ep) == NULL || F_ISSET(sp, SC_TINPUT))
+		return (NULL);
+	if ((wcp = WCP(ep)) == NULL) {
+		if ((wcp = calloc(1, sizeof(WCACHE))) == NULL)
+			return (NULL);
+		ep->wcache = wcp;
+	}
+	return (wcp);
+}
+
+/*
+ * vs_wc_flags --
+ *	Return the display options a line's width depends on.
+ */
+static u_int8_t
+vs_wc_flags(SCR *sp)
+{
+	u_int8_t flags;
+
+	flags = 0;
+	if (O_ISSET(sp, O_LEFTRIGHT))
+		flags |= WC_LEFTRIGHT;
+	if (O_ISSET(sp, O_LIST))
+		flags |= WC_LIST;
+	if (O_ISSET(sp, O_NUMBER))
+		flags |= WC_NUMBER;
+	return (flags);
+}
+
+/*
+ * vs_wc_brk --
+ *	Build the screen line breaks for a line width cache entry, i.e. the
+ *	state vs_colpos() has after discarding each screen line.
+ */
+static int
+vs_wc_brk(SCR *sp, WCENT *wp, CHAR_T *lp, size_t llen)
+{
+	size_t blen, len, nbrk, scno, *brk, *tbrk;
+	int ch = 0, leftright, listset;
+	CHAR_T *p;
+
+	listset = O_ISSET(sp, O_LIST);
+	leftright = O_ISSET(sp, O_LEFTRIGHT);
+
+	brk = NULL;
+	blen = nbrk = 0;
+	for (scno = 0, p = lp, len = llen;;) {
+		for (; len && scno < sp->cols; --len)
+			scno += CHLEN(scno);
+		if (len == 0)
+			break;
+		if (leftright && ch == '\t')
+			scno = 0;
+		else
+			scno -= sp->cols;
+
+		if (nbrk == blen) {
+			blen = blen == 0 ? 32 : blen * 2;
+			if ((tbrk = realloc(brk,
+			    blen * 2 * sizeof(size_t))) == NULL) {
+				free(brk);
+				return (1);
+			}
+			brk = tbrk;
+		}
+		brk[nbrk * 2] = p - lp;
+		brk[nbrk * 2 + 1] = scno;
+		++nbrk;
+	}
+
+	/* A line that fits in a single screen line has no breaks. */
+	if (brk == NULL && (brk = malloc(2 * sizeof(size_t))) == NULL)
+		return (1);
+	wp->brk = brk;
+	wp->nbrk = nbrk;
+	return (0);
+}
+
+/*
+ * vs_wc_change --
+ *	Discard the line width cache entries invalidated by a change to
+ *	the file.
+ *
+ * PUBLIC: void vs_wc_change(SCR *, recno_t, lnop_t);
+ */
+void
+vs_wc_change(SCR *sp, recno_t lno, lnop_t op)
+{
+	WCACHE *wcp;
+	WCENT *wp;
+	recno_t b, high;
+	int cnt;
+
+	if ((wcp = WCP(sp->ep)) == NULL)
+		return;
+
+	/* Discard the block sums from the changed line's block on. */
+	if ((b = (lno == 0 ? 0 : lno - 1) / WC_BLOCK) < wcp->nblk) {
+		if (op == LINE_RESET)
+			wcp->blk[b] = 0;
+		else
+			memset(wcp->blk + b,
+			    0, (wcp->nblk - b) * sizeof(size_t));
+	}
+
+	switch (op) {
+	case LINE_RESET:
+		wp = &wcp->ent[lno & (WC_SLOTS - 1)];
+		if (wp->lno == lno)
+			vs_wc_clear(wp);
+		return;
+	case LINE_APPEND:
+		++lno;
+		/* FALLTHROUGH */
+	case LINE_DELETE:
+	case LINE_INSERT:
+		/*
+		 * Every following line is renumbered.  Cheap in the common
+		 * case of changes below the lines on the screen.
+		 */
+		if (lno > wcp->high)
+			return;
+		for (high = 0, wp = wcp->ent, cnt = WC_SLOTS; cnt--; ++wp)
+			if (wp->lno >= lno)
+				vs_wc_clear(wp);
+			else if (wp->lno > high)
+				high = wp->lno;
+		wcp->high = high;
+		return;
+	default:
+		abort();
+	}
+}
+
+/*
+ * vs_wc_end --
+ *	Discard a file's line width cache.
+ *
+ * PUBLIC: void vs_wc_end(EXF *);
+ */
+void
+vs_wc_end(EXF *ep)
+{
+	WCACHE *wcp;
+	WCENT *wp;
+	int cnt;
+
+	if ((wcp = WCP(ep)) == NULL)
+		return;
+	for (wp = wcp->ent, cnt = WC_SLOTS; cnt--; ++wp)
+		free(wp->brk);
+	free(wcp->blk);
+	free(wcp);
+	ep->wcache = NULL;
+}
+
+/*
+ * vs_wc_clear --
+ *	Discard a line width cache entry.
+ */
+static void
+vs_wc_clear(WCENT *wp)
+{
+	free(wp->brk);
+	wp->brk = NULL;
+	wp->nbrk = 0;
+	wp->lno = OOBLNO;
+}
@@ -24,11 +24,13 @@
 
 static int	vs_deleteln(SCR *, int);
 static int	vs_insertln(SCR *, int);
+static int	vs_sm_block(SCR *);
 static int	vs_sm_delete(SCR *, recno_t);
 static int	vs_sm_down(SCR *, MARK *, recno_t, scroll_t, SMAP *);
 static int	vs_sm_erase(SCR *);
 static int	vs_sm_insert(SCR *, recno_t);
 static int	vs_sm_reset(SCR *, recno_t);
+static recno_t	vs_sm_skip(SCR *, SMAP *, recno_t, int);
 static int	vs_sm_up(SCR *, MARK *, recno_t, scroll_t, SMAP *);
 
 /*
@@ -155,6 +157,155 @@ vs_change(SCR *sp, recno_t lno, lnop_t op)
 	return (0);
 }
 
+/*
+ * vs_change_block --
+ *	Make a change to the screen for a block of cnt lines inserted or
+ *	deleted at lno.
+ *
+ * PUBLIC: int vs_change_block(SCR *, recno_t, lnop_t, recno_t);
+ */
+int
+vs_change_block(SCR *sp, recno_t lno, lnop_t op, recno_t cnt)
+{
+	VI_PRIVATE *vip;
+	SMAP *p;
+	recno_t lline;
+	size_t scnt;
+
+	vip = VIP(sp);
+
+	/* Ignore the change if the block is after the map. */
+	if (lno > TMAP->lno)
+		return (0);
+
+	/*
+	 * If the block is before the map, renumber the map, the same as
+	 * vs_change() does one line at a time.
+	 */
+	switch (op) {
+	case LINE_DELETE:
+		if (lno + cnt - 1 >= HMAP->lno)
+			break;
+		for (p = HMAP, scnt = sp->t_rows; scnt--; ++p)
+			p->lno -= cnt;
+		if (sp->lno >= lno)
+			sp->lno = sp->lno - lno >= cnt ? sp->lno - cnt : lno - 1;
+		F_SET(vip, VIP_N_RENUMBER);
+		return (0);
+	case LINE_INSERT:
+		if (lno >= HMAP->lno)
+			break;
+		for (p = HMAP, scnt = sp->t_rows; scnt--; ++p)
+			p->lno += cnt;
+		if (sp->lno >= lno)
+			sp->lno += cnt;
+		F_SET(vip, VIP_N_RENUMBER);
+		return (0);
+	default:
+		abort();
+	}
+
+	if (vs_sm_block(sp))
+		return (0);
+
+	if (op == LINE_INSERT) {
+		if (sp->lno > lno)
+			sp->lno += cnt;
+	} else {
+		if (sp->lno > lno)
+			sp->lno = sp->lno - lno >= cnt ? sp->lno - cnt : lno;
+		if (HMAP->lno > lno) {
+			HMAP->lno =
+			    HMAP->lno - lno >= cnt ? HMAP->lno - cnt : lno;
+			HMAP->coff = 0;
+			HMAP->soff = 1;
+		}
+		if (db_last(sp, &lline))
+			return (1);
+		if (HMAP->lno > lline) {
+			HMAP->lno = lline == 0 ? 1 : lline;
+			HMAP->coff = 0;
+			HMAP->soff = 1;
+		}
+	}
+
+	/*
+	 * Scrolling the block in and out one line at a time isn't worth
+	 * it, the changed lines will most likely fill the screen.  Refill
+	 * the map from the top line, and repaint.
+	 */
+	return (vs_sm_fill(sp, OOBLNO, P_TOP));
+}
+
+/*
+ * vs_change_move --
+ *	Make a change to the screen for a block of cnt lines at fl moved
+ *	after tl.
+ *
+ * PUBLIC: int vs_change_move(SCR *, recno_t, recno_t, recno_t);
+ */
+int
+vs_change_move(SCR *sp, recno_t fl, recno_t cnt, recno_t tl)
+{
+	recno_t lline;
+
+	/*
+	 * Lines outside of the range between the block and its destination
+	 * keep their numbers, ignore the change if the map is outside it.
+	 */
+	if ((tl > fl ? fl : tl + 1) > TMAP->lno ||
+	    (tl > fl ? tl : fl + cnt - 1) < HMAP->lno)
+		return (0);
+
+	if (vs_sm_block(sp))
+		return (0);
+
+	/*
+	 * Keep the same text at the top of the screen.  If the top line
+	 * was moved, it's replaced by the line that followed the block,
+	 * the same as if the lines had been moved one at a time.
+	 */
+	if (HMAP->lno >= fl && HMAP->lno < fl + cnt) {
+		HMAP->lno = fl + cnt;
+		HMAP->coff = 0;
+		HMAP->soff = 1;
+	}
+	HMAP->lno = db_bmove_lno(HMAP->lno, fl, cnt, tl);
+	if (db_last(sp, &lline))
+		return (1);
+	if (HMAP->lno > lline) {
+		HMAP->lno = lline;
+		HMAP->coff = 0;
+		HMAP->soff = 1;
+	}
+	sp->lno = db_bmove_lno(sp->lno, fl, cnt, tl);
+
+	return (vs_sm_fill(sp, OOBLNO, P_TOP));
+}
+
+/*
+ * vs_sm_block --
+ *	Common setup for a block change to the lines on the screen.
+ *	Return 1 if the screen will be redrawn by ex.
+ */
+static int
+vs_sm_block(SCR *sp)
+{
+	VI_PRIVATE *vip;
+
+	vip = VIP(sp);
+	F_SET(vip, VIP_N_REFRESH | VIP_N_RENUMBER | VIP_CUR_INVALID);
+	VI_SCR_CFLUSH(vip);
+
+	/* See vs_change(). */
+	if (!F_ISSET(sp, SC_TINPUT_INFO) &&
+	    (F_ISSET(sp, SC_SCR_EXWROTE) || VIP(sp)->totalcount > 1)) {
+		F_SET(vip, VIP_N_EX_REDRAW);
+		return (1);
+	}
+	return (0);
+}
+
 /*
  * vs_sm_fill --
  *	Fill in the screen map, placing the specified line at the
@@ -570,6 +721,7 @@ vs_sm_scroll(SCR *sp, MARK *rp, recno_t count, scroll_t scmd)
 static int
 vs_sm_up(SCR *sp, MARK *rp, recno_t count, scroll_t scmd, SMAP *smp)
 {
+	recno_t cnt;
 	int cursor_set, echanged, zset;
 	SMAP *ssmp, s1, s2;
 
@@ -650,7 +802,39 @@ vs_sm_up(SCR *sp, MARK *rp, recno_t count, scroll_t scmd, SMAP *smp)
 			return (0);
 	}
 
-	for (echanged = zset = 0; count; --count) {
+	/*
+	 * Scrolling a screen or more replaces every line on the screen,
+	 * so move the map directly, instead of a line at a time.
+	 */
+	echanged = zset = 0;
+	if (count >= sp->t_rows &&
+	    !IS_ONELINE(sp) && db_exist(sp, TMAP->lno)) {
+		s1 = *TMAP;
+		if ((cnt = vs_sm_skip(sp, &s1, count, 1)) != 0) {
+			(void)vs_sm_skip(sp, HMAP, cnt, 1);
+			if (vs_sm_fill(sp, OOBLNO, P_TOP))
+				return (1);
+			count -= cnt;
+			switch (scmd) {
+			case CNTRL_E:
+				if (cnt > (recno_t)(smp - HMAP)) {
+					smp = HMAP;
+					echanged = 1;
+				} else
+					smp -= cnt;
+				break;
+			case Z_PLUS:
+				smp = cnt - 1 < (recno_t)(TMAP - HMAP) ?
+				    TMAP - (cnt - 1) : HMAP;
+				zset = 1;
+				break;
+			default:
+				break;
+			}
+		}
+	}
+
+	for (; count; --count) {
 		/* Decide what would show up on the screen. */
 		if (vs_sm_next(sp, TMAP, &s1))
 			return (1);
@@ -808,6 +992,7 @@ static int
 vs_sm_down(SCR *sp, MARK *rp, recno_t count, scroll_t scmd, SMAP *smp)
 {
 	SMAP *ssmp, s1, s2;
+	recno_t cnt;
 	int cursor_set, ychanged, zset;
 
 	/* Check to see if movement is possible. */
@@ -865,7 +1050,33 @@ vs_sm_down(SCR *sp, MARK *rp, recno_t count, scroll_t scmd, SMAP *smp)
 			return (0);
 	}
 
-	for (ychanged = zset = 0; count; --count) {
+	/* See vs_sm_up(). */
+	ychanged = zset = 0;
+	if (count >= sp->t_rows && !IS_ONELINE(sp) && (HMAP->lno != 1 ||
+	    (!O_ISSET(sp, O_LEFTRIGHT) && HMAP->soff != 1)) &&
+	    (cnt = vs_sm_skip(sp, HMAP, count, 0)) != 0) {
+		if (vs_sm_fill(sp, OOBLNO, P_TOP))
+			return (1);
+		count -= cnt;
+		switch (scmd) {
+		case CNTRL_Y:
+			if (cnt > (recno_t)(TMAP - smp)) {
+				smp = TMAP;
+				ychanged = 1;
+			} else
+				smp += cnt;
+			break;
+		case Z_CARAT:
+			smp = cnt - 1 < (recno_t)(TMAP - HMAP) ?
+			    HMAP + (cnt - 1) : TMAP;
+			zset = 1;
+			break;
+		default:
+			break;
+		}
+	}
+
+	for (; count; --count) {
 		/* If the line doesn't exist, we're done. */
 		if (HMAP->lno == 1 &&
 		    (O_ISSET(sp, O_LEFTRIGHT) || HMAP->soff == 1))
@@ -1087,6 +1298,95 @@ vs_sm_prev(SCR *sp, SMAP *p, SMAP *t)
 	return (t->lno == 0);
 }
 
+/*
+ * vs_sm_skip --
+ *	Move an SMAP entry count screen lines forward or backward, as that
+ *	many calls to vs_sm_next() or vs_sm_prev() would, but stop at the
+ *	last screen line of the file or at the first.  Returns the number
+ *	of screen lines moved.
+ */
+static recno_t
+vs_sm_skip(SCR *sp, SMAP *p, recno_t count, int forward)
+{
+	recno_t lno, moved;
+	size_t cnt, rows;
+
+	SMAP_FLUSH(p);
+	if (O_ISSET(sp, O_LEFTRIGHT)) {
+		if (!forward)
+			moved = MIN(count, p->lno - 1);
+		else if (db_last(sp, &lno) || p->lno >= lno)
+			moved = 0;
+		else
+			moved = MIN(count, lno - p->lno);
+		p->lno = forward ? p->lno + moved : p->lno - moved;
+		return (moved);
+	}
+
+	/*
+	 * Step a line at a time, or a block of lines at a time if the
+	 * block takes fewer screen lines than are left to move.  Every
+	 * line takes at least one screen line, so don't bother summing
+	 * blocks that couldn't be stepped over.
+	 */
+	if (forward) {
+		cnt = vs_screens(sp, p->lno, NULL);
+		if (count <= cnt - p->soff) {
+			p->soff += count;
+			return (count);
+		}
+		for (moved = cnt - p->soff, lno = p->lno + 1;;) {
+			if (count - moved > WC_BLOCK &&
+			    (lno - 1) % WC_BLOCK == 0 &&
+			    !vs_wc_rows(sp, (lno - 1) / WC_BLOCK, &rows) &&
+			    rows < count - moved) {
+				moved += rows;
+				lno += WC_BLOCK;
+				continue;
+			}
+			if (!db_exist(sp, lno))
+				break;
+			cnt = vs_screens(sp, lno, NULL);
+			if (count - moved <= cnt) {
+				p->lno = lno;
+				p->soff = count - moved;
+				return (count);
+			}
+			moved += cnt;
+			++lno;
+		}
+		p->lno = lno - 1;
+		p->soff = vs_screens(sp, p->lno, NULL);
+		return (moved);
+	}
+
+	if (count < p->soff) {
+		p->soff -= count;
+		return (count);
+	}
+	for (moved = p->soff - 1, lno = p->lno; lno > 1;) {
+		if (count - moved > WC_BLOCK &&
+		    (lno - 1) % WC_BLOCK == 0 &&
+		    !vs_wc_rows(sp, (lno - 1) / WC_BLOCK - 1, &rows) &&
+		    rows < count - moved) {
+			moved += rows;
+			lno -= WC_BLOCK;
+			continue;
+		}
+		cnt = vs_screens(sp, lno - 1, NULL);
+		if (count - moved <= cnt) {
+			p->lno = lno - 1;
+			p->soff = cnt - (count - moved) + 1;
+			return (count);
+		}
+		moved += cnt;
+		--lno;
+	}
+	p->lno = 1;
+	p->soff = 1;
+	return (moved);
+}
+
 /*
  * vs_sm_cursor --
  *	Return the SMAP entry referenced by the cursor.